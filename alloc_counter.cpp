@@ -0,0 +1,58 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocationBytes{0};
+
+void count(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void freeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+}  // namespace
+
+// The array and nothrow forms forward to these.
+void* operator new(size_t size) {
+    count(size);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// Types aligned beyond what malloc guarantees come here instead.
+void* operator new(size_t size, std::align_val_t alignment) {
+    count(size);
+    size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+    if (void* p = _aligned_malloc(size ? size : 1, align)) return p;
+#else
+    // aligned_alloc takes whole multiples of the alignment only.
+    size_t rounded = size ? (size + align - 1) / align * align : align;
+    if (void* p = std::aligned_alloc(align, rounded)) return p;
+#endif
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { freeAligned(p); }
+
+AllocationTotals allocationTotals() {
+    return {allocationCount.load(std::memory_order_relaxed), allocationBytes.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations made through operator new since the process started. alloc_counter.cpp
+// replaces the global operator new, plain and aligned, to count them; it is linked into the
+// executables that report allocations rather than into the core library, where whether the
+// replacement gets linked would depend on what else the program uses.
+struct AllocationTotals {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+AllocationTotals allocationTotals();
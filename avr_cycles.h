@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// Approximate ATmega328P cycle costs of the operations the players use (avr-gcc, avr-libc).
+constexpr uint32_t CYCLES_PGM_BYTE = 5;
+constexpr uint32_t CYCLES_PGM_WORD = 8;
+constexpr uint32_t CYCLES_PGM_DWORD = 14;
+constexpr uint32_t CYCLES_FLOAT_ADD = 110;
+constexpr uint32_t CYCLES_FLOAT_MUL = 150;
+constexpr uint32_t CYCLES_FLOAT_CMP = 60;
+constexpr uint32_t CYCLES_FLOAT_DIV = 480;
+constexpr uint32_t CYCLES_FLOAT_CONVERT = 70;
+constexpr uint32_t CYCLES_FMOD = 1500;
+constexpr uint32_t CYCLES_LONG_MUL = 80;
+constexpr uint32_t CYCLES_LONG_DIV = 650;
+constexpr uint32_t CYCLES_STEP = 12;
+constexpr uint32_t CYCLES_MILLIS = 40;
+constexpr uint32_t CYCLES_ANALOG_WRITE = 70;
@@ -0,0 +1,322 @@
+// Headless batch compiler: turns a directory or manifest of curve files into Arduino code.
+#include "board.h"
+#include "budget.h"
+#include "codegen.h"
+#include "curve.h"
+#include "firmware_sim.h"
+#include "simplify.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct BatchOptions {
+    fs::path input;
+    fs::path outDir = ".";
+    float epsilon = 0.5f;
+    CodeFormat format = CodeFormat::Sketch;
+    size_t jobs = 0;
+    size_t pointLimit = 0;  // 0: only the board's flash limits the curve
+    size_t budget = 0;  // 0: simplify with epsilon instead
+    bool engine = false;  // simplify with `simplifier` to `toleranceCounts` instead of epsilon
+    Simplifier simplifier = Simplifier::Rdp;
+    float toleranceCounts = 1.0f;
+    PlayerKind player = PlayerKind::Scan;
+    unsigned tickMs = 10;
+    TableEncoding encoding = TableEncoding::Auto;
+    const BoardProfile* board = &boardProfiles().front();
+    bool simulate = false;
+};
+
+struct CurveJob {
+    fs::path source{};
+    float epsilon = 0.5f;
+    // Filled in by the worker.
+    bool ok = false;
+    std::string error{};
+    size_t inputPoints = 0;
+    size_t outputPoints = 0;
+    size_t flashBytes = 0;
+    FitError fit{};
+    bool simulated = false;
+    SimReport sim{};
+};
+
+static void printUsage(const char* argv0) {
+    std::fprintf(stderr,
+        "Usage: %s [options] <curve-dir | manifest>\n"
+        "\n"
+        "Compiles every curve (*.csv with \"time,duty\" rows) in a directory, or every\n"
+        "curve listed in a manifest (one \"path [epsilon]\" per line), into Arduino code.\n"
+        "\n"
+        "  -o, --out DIR        output directory (default: .)\n"
+        "  -e, --epsilon E      RDP epsilon (default: 0.5)\n"
+        "  -f, --format FMT     ino (sketch per curve) or h (data header) (default: ino)\n"
+        "  -j, --jobs N         worker threads (default: all cores)\n"
+        "      --limit N        reject curves simplifying to more than N points (default: no limit)\n"
+        "  -b, --budget N       keep the lowest-error curve of at most N points instead of\n"
+        "                       simplifying with a fixed epsilon\n"
+        "  -s, --simplifier S   rdp, swing-door or visvalingam, simplifying to a vertical\n"
+        "                       --tolerance instead of the epsilon (RDP's distance in seconds and\n"
+        "                       percent together)\n"
+        "      --tolerance N    largest output error the simplifier may leave, in PWM counts\n"
+        "                       (default: 1)\n"
+        "  -p, --player P       playback loop: scan, cursor, fixed or lookup (default: scan)\n"
+        "  -t, --tick MS        delay between output updates for non-scan players (default: 10)\n"
+        "      --encoding E     table layout: auto, plain, delta8, delta16, varint, nibble or rle;\n"
+        "                       auto picks the smallest one the player supports (default: auto)\n"
+        "      --board B        reject curves whose tables exceed the flash of uno, nano, mega or\n"
+        "                       esp32 (default: uno)\n"
+        "      --simulate       compile every sketch for the host, play it against simulated time\n"
+        "                       and reject it if its output strays further from the original curve\n"
+        "                       than the simplification does (needs a C++ compiler, $CXX or c++)\n",
+        argv0);
+}
+
+static bool parseArgs(int argc, char** argv, BatchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        if (arg == "-h" || arg == "--help") {
+            return false;
+        } else if (arg == "-o" || arg == "--out") {
+            const char* v = value();
+            if (!v) return false;
+            options.outDir = v;
+        } else if (arg == "-e" || arg == "--epsilon") {
+            const char* v = value();
+            if (!v) return false;
+            options.epsilon = std::strtof(v, nullptr);
+        } else if (arg == "-f" || arg == "--format") {
+            const char* v = value();
+            if (!v) return false;
+            if (std::strcmp(v, "ino") == 0) options.format = CodeFormat::Sketch;
+            else if (std::strcmp(v, "h") == 0) options.format = CodeFormat::Header;
+            else return false;
+        } else if (arg == "-j" || arg == "--jobs") {
+            const char* v = value();
+            if (!v) return false;
+            options.jobs = std::strtoul(v, nullptr, 10);
+        } else if (arg == "--limit") {
+            const char* v = value();
+            if (!v) return false;
+            options.pointLimit = std::strtoul(v, nullptr, 10);
+        } else if (arg == "-b" || arg == "--budget") {
+            const char* v = value();
+            if (!v) return false;
+            options.budget = std::strtoul(v, nullptr, 10);
+        } else if (arg == "-s" || arg == "--simplifier") {
+            const char* v = value();
+            if (!v || !parseSimplifier(v, options.simplifier)) return false;
+            options.engine = true;
+        } else if (arg == "--tolerance") {
+            const char* v = value();
+            if (!v) return false;
+            options.toleranceCounts = std::strtof(v, nullptr);
+            options.engine = true;
+        } else if (arg == "-p" || arg == "--player") {
+            const char* v = value();
+            if (!v || !parsePlayerKind(v, options.player)) return false;
+        } else if (arg == "-t" || arg == "--tick") {
+            const char* v = value();
+            if (!v) return false;
+            options.tickMs = std::strtoul(v, nullptr, 10);
+        } else if (arg == "--encoding") {
+            const char* v = value();
+            if (!v || !parseTableEncoding(v, options.encoding)) return false;
+        } else if (arg == "--board") {
+            const char* v = value();
+            if (!v || !(options.board = findBoard(v))) return false;
+        } else if (arg == "--simulate") {
+            options.simulate = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else {
+            options.input = arg;
+        }
+    }
+    return !options.input.empty() && !(options.simulate && options.format != CodeFormat::Sketch);
+}
+
+static bool collectJobs(const BatchOptions& options, std::vector<CurveJob>& jobs, std::string& error) {
+    std::error_code ec;
+    if (fs::is_directory(options.input, ec)) {
+        for (const auto& entry : fs::directory_iterator(options.input, ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".csv") {
+                jobs.push_back({entry.path(), options.epsilon});
+            }
+        }
+        std::sort(jobs.begin(), jobs.end(),
+            [](const CurveJob& a, const CurveJob& b) { return a.source < b.source; });
+        return true;
+    }
+
+    std::ifstream manifest(options.input);
+    if (!manifest.is_open()) {
+        error = "cannot open " + options.input.string();
+        return false;
+    }
+    fs::path base = options.input.parent_path();
+    std::string line;
+    while (std::getline(manifest, line)) {
+        std::istringstream fields(line);
+        std::string path;
+        if (!(fields >> path) || path[0] == '#') continue;
+        float epsilon = options.epsilon;
+        fields >> epsilon;
+        fs::path source = fs::path(path).is_absolute() ? fs::path(path) : base / path;
+        jobs.push_back({source, epsilon});
+    }
+    return true;
+}
+
+static void compileCurve(const BatchOptions& options, CurveJob& job) {
+    std::vector<DataPoint> points;
+    if (!loadCurveCsv(job.source.string(), points, job.error)) return;
+    job.inputPoints = points.size();
+    if (points.empty()) {
+        job.error = "no points";
+        return;
+    }
+
+    std::vector<DataPoint> simplified;
+    if (options.budget > 0) {
+        // Curves already run in parallel, so each worker solves its budget single-threaded.
+        thread_local BudgetSimplifier budget;
+        simplified = budget.solve(points, options.budget).points;
+    } else if (options.engine) {
+        simplifyCurve(points, options.simplifier, options.toleranceCounts, simplified);
+    } else {
+        rdpSimplify(points, job.epsilon, simplified);
+    }
+    job.outputPoints = simplified.size();
+    job.fit = measureFitError(points, simplified);
+    if (options.pointLimit > 0 && simplified.size() > options.pointLimit) {
+        job.error = std::to_string(simplified.size()) + " points after simplification exceed the limit of " +
+                    std::to_string(options.pointLimit);
+        return;
+    }
+
+    std::string stem = job.source.stem().string();
+    CodeOptions code;
+    code.format = options.format;
+    code.player = options.player;
+    code.tickMs = options.tickMs;
+    code.encoding = options.encoding;
+
+    PlayerCost cost = estimatePlayerCost(simplified, code);
+    job.flashBytes = cost.flashBytes;
+    if (!options.board->fits(cost.flashBytes, cost.largestArray)) {
+        job.error = std::to_string(cost.flashBytes) + " bytes of " + encodingName(cost.encoding) +
+                    " tables do not fit the " + std::to_string(options.board->curveBytes) +
+                    " bytes available on " +
+                    options.board->label;
+        return;
+    }
+    fs::path target;
+    if (options.format == CodeFormat::Sketch) {
+        // The Arduino IDE expects every sketch in a folder of the same name.
+        fs::path dir = options.outDir / stem;
+        std::error_code ec;
+        fs::create_directories(dir, ec);
+        target = dir / (stem + ".ino");
+    } else {
+        code.symbolPrefix = symbolPrefixFor(stem);
+        target = options.outDir / (stem + ".h");
+    }
+
+    std::ofstream file(target);
+    if (!file.is_open()) {
+        job.error = "cannot write " + target.string();
+        return;
+    }
+    std::ostringstream sketch;
+    writeArduinoCode(sketch, simplified, code);
+    file << sketch.str();
+    if (!file) {
+        job.error = "write failed: " + target.string();
+        return;
+    }
+
+    if (options.simulate) {
+        if (!simulateSketch(sketch.str(), {{10, points}}, {}, job.sim, job.error)) return;
+        job.simulated = true;
+        float allowance = simulationAllowance(simplified, code);
+        if (job.sim.maxError > job.fit.maxError + allowance) {
+            char message[192];
+            std::snprintf(message, sizeof(message),
+                "the sketch plays %.2f%% off the curve at %.3f s; the simplified curve is within %.2f%%, "
+                "the player within %.2f%% of that", job.sim.maxError, job.sim.maxErrorAt, job.fit.maxError, allowance);
+            job.error = message;
+            return;
+        }
+    }
+    job.ok = true;
+}
+
+int main(int argc, char** argv) {
+    BatchOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<CurveJob> jobs;
+    std::string error;
+    if (!collectJobs(options, jobs, error)) {
+        std::fprintf(stderr, "error: %s\n", error.c_str());
+        return 1;
+    }
+    std::error_code ec;
+    fs::create_directories(options.outDir, ec);
+
+    auto start = std::chrono::steady_clock::now();
+    ThreadPool pool(options.jobs);
+    pool.parallelFor(jobs.size(), [&](size_t i) { compileCurve(options, jobs[i]); });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t failed = 0, pointsIn = 0, pointsOut = 0, flashBytes = 0, simulated = 0;
+    float worstError = 0, worstSimError = 0;
+    uint32_t worstCycles = 0;
+    double sumRms = 0;
+    for (const auto& job : jobs) {
+        pointsIn += job.inputPoints;
+        pointsOut += job.outputPoints;
+        flashBytes += job.flashBytes;
+        worstError = std::max(worstError, job.fit.maxError);
+        sumRms += job.fit.rmsError;
+        if (job.simulated) {
+            ++simulated;
+            worstSimError = std::max(worstSimError, job.sim.maxError);
+            worstCycles = std::max(worstCycles, job.sim.worstCycles);
+        }
+        if (!job.ok) {
+            ++failed;
+            std::fprintf(stderr, "%s: %s\n", job.source.string().c_str(), job.error.c_str());
+        }
+    }
+
+    double rate = seconds > 0 ? jobs.size() / seconds : 0;
+    std::printf("%zu curves (%zu failed), %zu -> %zu points in %.3f s on %zu threads: %.1f curves/s, %.2f Mpoints/s\n",
+        jobs.size(), failed, pointsIn, pointsOut, seconds, pool.size(), rate,
+        seconds > 0 ? pointsIn / seconds / 1e6 : 0.0);
+    if (!jobs.empty()) {
+        std::printf("interpolation error: worst max %.3f%%, mean RMS %.3f%%\n", worstError, sumRms / jobs.size());
+        std::printf("curve tables: %zu bytes of flash in total (%s)\n", flashBytes, options.board->label);
+    }
+    if (simulated > 0) {
+        std::printf("simulated %zu sketches: worst output error %.3f%%, worst loop %u cycles in flash reads and I/O\n",
+            simulated, worstSimError, worstCycles);
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,865 @@
+// Benchmarks for the editor's per-frame and per-click work on large synthetic curves.
+#include "alloc_counter.h"
+#include "codegen.h"
+#include "curve.h"
+#include "curve_store.h"
+#include "firmware_sim.h"
+#include "history.h"
+#include "live_link.h"
+#include "multichannel.h"
+#include "plot_geometry.h"
+#include "selection.h"
+#include "session.h"
+#include "simplify.h"
+#include "telemetry.h"
+#include "waveform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+    size_t points = 1000000;
+    size_t reps = 1000;
+    unsigned seed = 1;
+    bool suite = false;               // run the pipeline sweep instead of the editor cases
+    size_t maxPoints = 10000000;      // largest curve in the sweep
+    std::string jsonPath;             // where the sweep results go, if anywhere
+};
+
+// Plot geometry the editor uses for hit testing, at a typical window size.
+constexpr float PLOT_WIDTH = 1200.0f;
+constexpr float PLOT_HEIGHT = 400.0f;
+constexpr float PICK_RADIUS = 10.0f;
+
+std::vector<DataPoint> syntheticCurve(size_t count, std::mt19937& rng) {
+    std::vector<DataPoint> points(count);
+    std::uniform_real_distribution<float> noise(-2.0f, 2.0f);
+    for (size_t i = 0; i < count; ++i) {
+        float x = static_cast<float>(i) * 0.001f;
+        points[i] = {x, 50.0f + 40.0f * std::sin(x * 0.7f) + noise(rng)};
+    }
+    return points;
+}
+
+template <typename Fn>
+double nanosPerOp(size_t reps, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < reps; ++i) fn(i);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / reps;
+}
+
+void report(const char* name, double nanos, const char* unit = "op") {
+    if (nanos >= 1e6) {
+        std::printf("%-34s %12.3f ms/%s\n", name, nanos / 1e6, unit);
+    } else if (nanos >= 1e3) {
+        std::printf("%-34s %12.3f us/%s\n", name, nanos / 1e3, unit);
+    } else {
+        std::printf("%-34s %12.3f ns/%s\n", name, nanos, unit);
+    }
+}
+
+// The pre-index hit test: every point converted and compared on every click.
+int pickLinear(const std::vector<DataPoint>& points, const DataPoint& at, PlotScale scale, float radius) {
+    int best = -1;
+    float bestDist = radius * radius;
+    for (size_t i = 0; i < points.size(); ++i) {
+        float dx = (points[i].x - at.x) * scale.x;
+        float dy = (points[i].y - at.y) * scale.y;
+        float dist = dx * dx + dy * dy;
+        if (dist < bestDist) {
+            bestDist = dist;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+void benchSelection(const BenchOptions& options, std::mt19937& rng) {
+    std::vector<DataPoint> points = syntheticCurve(options.points, rng);
+    float duration = points.back().x;
+    PlotScale scale{PLOT_WIDTH / duration, PLOT_HEIGHT / 100.0f};
+
+    // Clicks land on or near random points, as when grabbing a handle.
+    std::uniform_int_distribution<size_t> anyPoint(0, points.size() - 1);
+    std::vector<DataPoint> clicks(options.reps);
+    for (auto& click : clicks) {
+        click = points[anyPoint(rng)];
+        click.y += 1.0f;
+    }
+
+    long sink = 0;
+    report("click, indexed pick", nanosPerOp(options.reps, [&](size_t i) {
+        sink += pickPoint(points, clicks[i], scale, PICK_RADIUS);
+    }));
+    size_t linearReps = std::max<size_t>(1, options.reps / 100);
+    report("click, linear scan", nanosPerOp(linearReps, [&](size_t i) {
+        sink += pickLinear(points, clicks[i], scale, PICK_RADIUS);
+    }));
+
+    PointSelection selection;
+    selection.reset(points.size());
+    for (float fraction : {0.01f, 0.25f, 1.0f}) {
+        std::uniform_real_distribution<float> startAt(0.0f, duration * (1.0f - fraction));
+        std::string name = "box select, " + std::to_string(static_cast<int>(fraction * 100)) + "% of time";
+        size_t reps = std::max<size_t>(1, static_cast<size_t>(options.reps / 10 / fraction / 10));
+        report(name.c_str(), nanosPerOp(reps, [&](size_t) {
+            float x0 = startAt(rng);
+            sink += selection.selectBox(points, {x0, 30.0f}, {x0 + duration * fraction, 70.0f});
+        }));
+    }
+
+    // The per-frame color lookup for every handle, with the last (full-width) box selected.
+    double perFrame = nanosPerOp(10, [&](size_t) {
+        size_t selected = 0;
+        for (size_t i = 0; i < points.size(); ++i) selected += selection.selected(i);
+        sink += selected;
+    });
+    report("selection lookup, per point", perFrame / points.size(), "point");
+
+    std::vector<DataPoint> scratch;
+    std::uniform_real_distribution<float> startAt(0.0f, duration * 0.9f);
+    report("copy + delete 10% box selection", nanosPerOp(10, [&](size_t) {
+        scratch = points;
+        float x0 = startAt(rng);
+        selection.selectBox(scratch, {x0, 0.0f}, {x0 + duration * 0.1f, 100.0f});
+        sink += selection.eraseSelected(scratch);
+    }));
+
+    std::printf("(checksum %ld)\n", sink);
+}
+
+void benchPlot(const BenchOptions& options, std::mt19937& rng) {
+    std::vector<DataPoint> points = syntheticCurve(options.points, rng);
+    PlotViewport viewport{PLOT_WIDTH, PLOT_HEIGHT, points.back().x, PICK_RADIUS / 2};
+
+    // What every frame used to do: convert every point for the polyline and the handles.
+    std::vector<ScreenPoint> everyPoint;
+    report("plot, all points per frame", nanosPerOp(10, [&](size_t) {
+        everyPoint.clear();
+        for (const auto& p : points) everyPoint.push_back({p.x * viewport.width, p.y * viewport.height});
+    }));
+
+    PlotGeometryCache geometry;
+    uint64_t revision = 0;
+    report("plot, rebuild after an edit", nanosPerOp(10, [&](size_t) {
+        geometry.update(points, ++revision, viewport);
+    }));
+    report("plot, cached frame", nanosPerOp(options.reps, [&](size_t) {
+        geometry.update(points, revision, viewport);
+    }));
+    std::printf("%-34s %12zu -> %zu line vertices, %zu handles\n", "plot, decimation", points.size(),
+        geometry.polyline().size(), geometry.handles().size());
+}
+
+// Point edits on the sorted store against the vector the editor used to keep: assign, sort the
+// whole curve, then find the point again.
+void benchStore(const BenchOptions& options, std::mt19937& rng) {
+    std::vector<DataPoint> points = syntheticCurve(options.points, rng);
+    CurveStore store;
+    store.assign(points);
+    size_t n = points.size();
+
+    // Each drag step carries a point just past its right-hand neighbor.
+    std::uniform_int_distribution<size_t> interior(1, n - 3);
+    std::vector<size_t> dragged(options.reps);
+    for (auto& i : dragged) i = interior(rng);
+    auto dragTarget = [&](float nextX) { return DataPoint{nextX + 0.0001f, 50.0f}; };
+
+    long sink = 0;
+    size_t slowReps = std::max<size_t>(1, options.reps / 100);
+    report("drag step, vector + sort + find", nanosPerOp(slowReps, [&](size_t r) {
+        size_t i = dragged[r];
+        DataPoint p = dragTarget(points[i + 1].x);
+        points[i] = p;
+        std::sort(points.begin(), points.end());
+        sink += std::find(points.begin(), points.end(), p) - points.begin();
+    }));
+    report("drag step, store move", nanosPerOp(options.reps, [&](size_t r) {
+        size_t i = dragged[r];
+        sink += store.move(i, dragTarget(store[i + 1].x));
+    }));
+    CurveStore::Id id = store.id(n / 2);
+    report("drag step, id lookup", nanosPerOp(options.reps, [&](size_t) { sink += store.indexOf(id); }));
+
+    // The simplification follows the drag: an erase plus an insert renumber the whole
+    // decomposition tree, a relocation only visits the ranges that overlap the edit. Both start
+    // from the same curve and make the same drags, fewer than the other cases as erase + insert
+    // is slow on large curves.
+    size_t cacheReps = std::min<size_t>(options.reps, 200);
+    points = store.toPoints();
+    std::vector<DataPoint> dragStart = points;
+    SimplifyCache cache;
+    uint64_t revision = 0;
+    cache.sync(points, 0.5f, revision);
+    report("drag step, cache erase + insert", nanosPerOp(cacheReps, [&](size_t r) {
+        size_t i = dragged[r];
+        DataPoint p = dragTarget(points[i + 1].x);
+        points.erase(points.begin() + i);
+        cache.pointErased(points, i, revision);
+        size_t to = std::upper_bound(points.begin(), points.end(), p) - points.begin();
+        points.insert(points.begin() + to, p);
+        cache.pointInserted(points, to, revision);
+    }));
+    store.assign(dragStart);
+    cache.sync(store.view(), 0.5f, ++revision);
+    report("drag step, store move + relocate", nanosPerOp(cacheReps, [&](size_t r) {
+        size_t i = dragged[r];
+        size_t to = store.move(i, dragTarget(store[i + 1].x));
+        cache.pointRelocated(store.view(), i, to, revision);
+    }));
+
+    std::uniform_real_distribution<float> anyTime(0.0f, points.back().x);
+    report("add point, copy + sort", nanosPerOp(slowReps, [&](size_t) {
+        std::vector<DataPoint> copy = points;
+        copy.push_back({anyTime(rng), 50.0f});
+        std::sort(copy.begin(), copy.end());
+        sink += copy.size();
+    }));
+    report("add point, store insert", nanosPerOp(options.reps, [&](size_t) {
+        sink += store.insert({anyTime(rng), 50.0f});
+    }));
+
+    // 1000 scattered points, as after a box select over a noisy stretch.
+    std::vector<uint8_t> doomed(store.size());
+    for (size_t k = 0; k < 1000; ++k) doomed[interior(rng)] = 1;
+    std::vector<size_t> descending;
+    for (size_t i = doomed.size(); i-- > 0;) {
+        if (doomed[i]) descending.push_back(i);
+    }
+    points = store.toPoints();
+    report("copy + delete 1000, vector::erase", nanosPerOp(3, [&](size_t) {
+        std::vector<DataPoint> copy = points;
+        for (size_t i : descending) copy.erase(copy.begin() + i);
+        sink += copy.size();
+    }));
+    report("copy + delete 1000, one pass", nanosPerOp(3, [&](size_t) {
+        CurveStore copy = store;
+        sink += copy.eraseIf([&](size_t i) { return doomed[i] != 0; });
+    }));
+
+    std::vector<DataPoint> simplified;
+    report("rdp 0.5, DataPoint array", nanosPerOp(3, [&](size_t) {
+        rdpSimplify(points, 0.5f, simplified);
+        sink += simplified.size();
+    }));
+    report("rdp 0.5, store view", nanosPerOp(3, [&](size_t) {
+        rdpSimplify(store.view(), 0.5f, simplified);
+        sink += simplified.size();
+    }));
+
+    std::printf("(checksum %ld)\n", sink);
+}
+
+// Undo history on a large curve: every drag step committed as its own snapshot, against keeping
+// a full copy of the curve per step.
+void benchHistory(const BenchOptions& options, std::mt19937& rng) {
+    CurveStore store;
+    store.assign(syntheticCurve(options.points, rng));
+    size_t n = store.size();
+    double curveBytes = static_cast<double>(n) * sizeof(DataPoint);
+    CurveHistory history;
+    history.reset(store);
+
+    std::uniform_int_distribution<size_t> interior(1, n - 3);
+    size_t steps = std::min<size_t>(options.reps * 5, 5000);
+    double worst = 0, bytes = 0;
+    double nanos = nanosPerOp(steps, [&](size_t) {
+        size_t i = interior(rng);
+        store.move(i, {store[i + 1].x + 0.0001f, 50.0f});
+        history.commit(store);
+        worst = std::max(worst, history.stats().lastCommitNanos);
+        bytes += history.stats().lastCommitBytes;
+    });
+    report("snapshot, drag step", nanos);
+    std::printf("%-34s %12.1f KiB/step, slowest %.1f us\n", "snapshot, memory", bytes / steps / 1024, worst / 1e3);
+    std::printf("%-34s %12.2f x the curve for %zu steps (%.1f MB)\n", "snapshot, whole history",
+        history.stats().bytes / curveBytes, history.stats().steps, history.stats().bytes / 1e6);
+
+    size_t undos = std::min<size_t>(steps, 1000);
+    report("undo, drag step", nanosPerOp(undos, [&](size_t) { history.undo(store); }));
+    report("redo, drag step", nanosPerOp(undos, [&](size_t) { history.redo(store); }));
+
+    std::vector<std::vector<DataPoint>> copies;
+    size_t copySteps = std::min<size_t>(steps, 20);
+    report("full copy per step", nanosPerOp(copySteps, [&](size_t) { copies.push_back(store.toPoints()); }));
+    std::printf("%-34s %12.1f KiB/step\n", "full copy, memory", curveBytes / 1024);
+}
+
+// Rigs of 4 and 8 motors sampled every millisecond for 10 s: moves that change speed at the same
+// instants on every motor, and motors that each follow their own schedule. Reports the flash of
+// one sketch with a shared time base against one sketch per motor.
+void benchChannels(const BenchOptions&, std::mt19937& rng) {
+    CodeOptions code;
+    code.player = PlayerKind::Cursor;
+    std::uniform_real_distribution<float> level(5.0f, 95.0f);
+    std::uniform_int_distribution<int> hold(50, 500);
+    for (bool synchronized : {true, false}) {
+        for (size_t count : {4, 8}) {
+            std::vector<std::vector<int>> schedules;
+            for (size_t c = 0; c < count; ++c) {
+                if (c > 0 && synchronized) {
+                    schedules.push_back(schedules.front());
+                    continue;
+                }
+                std::vector<int> breaks{0};
+                while (breaks.back() < 10000) breaks.push_back(std::min(breaks.back() + hold(rng), 10000));
+                schedules.push_back(breaks);
+            }
+            std::vector<std::vector<DataPoint>> curves(count);
+            std::vector<Channel> channels;
+            for (size_t c = 0; c < count; ++c) {
+                const std::vector<int>& breaks = schedules[c];
+                std::vector<float> levels;
+                for (size_t b = 0; b < breaks.size(); ++b) levels.push_back(level(rng));
+                for (size_t b = 0; b + 1 < breaks.size(); ++b) {
+                    for (int ms = breaks[b]; ms < breaks[b + 1]; ++ms) {
+                        float along = static_cast<float>(ms - breaks[b]) / (breaks[b + 1] - breaks[b]);
+                        curves[c].push_back({ms / 1000.0f, levels[b] + (levels[b + 1] - levels[b]) * along});
+                    }
+                }
+                curves[c].push_back({10.0f, levels.back()});
+                channels.push_back({static_cast<int>(c + 2), curves[c]});
+            }
+
+            ChannelPlan plan;
+            double nanos = nanosPerOp(3, [&](size_t) { plan = planChannels(channels, 0.5f, code); });
+            char name[64];
+            std::snprintf(name, sizeof(name), "channels, %zu %s", count, synchronized ? "in sync" : "independent");
+            report(name, nanos, "plan");
+            std::printf("%-34s %12zu bytes on %zu tables vs %zu as separate sketches (%+.0f%%)\n", "",
+                plan.flashBytes, plan.tracks.size(), plan.separateBytes,
+                100.0 * (static_cast<double>(plan.flashBytes) / plan.separateBytes - 1.0));
+        }
+    }
+}
+
+// Import throughput from a recorded run written to a temporary file, against loading the whole
+// CSV and simplifying it afterwards.
+void benchImport(const BenchOptions& options, std::mt19937& rng) {
+    std::vector<DataPoint> samples = syntheticCurve(options.points, rng);
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string csvPath = (dir / "motor_curve_bench.csv").string();
+    std::string binPath = (dir / "motor_curve_bench.bin").string();
+    saveCurveCsv(csvPath, samples);
+    if (std::FILE* file = std::fopen(binPath.c_str(), "wb")) {
+        std::fwrite(samples.data(), sizeof(DataPoint), samples.size(), file);
+        std::fclose(file);
+    }
+
+    ImportOptions importOptions;
+    importOptions.tolerance = 5.0f;  // wider than the synthetic noise
+    std::vector<DataPoint> points;
+    std::string error;
+    for (const std::string& path : {csvPath, binPath}) {
+        double megabytes = std::filesystem::file_size(path) / 1e6;
+        double nanos = nanosPerOp(3, [&](size_t) {
+            if (!importTelemetry(path, importOptions, points, error)) std::printf("%s\n", error.c_str());
+        });
+        std::string name = "import, " + std::string(path == csvPath ? "csv" : "binary");
+        std::printf("%-34s %12.1f MB/s, %zu samples -> %zu points\n", name.c_str(), megabytes / (nanos / 1e9),
+            samples.size(), points.size());
+    }
+
+    double megabytes = std::filesystem::file_size(csvPath) / 1e6;
+    std::vector<DataPoint> loaded;
+    double nanos = nanosPerOp(3, [&](size_t) {
+        loadCurveCsv(csvPath, loaded, error);
+        rdpSimplify(loaded, importOptions.tolerance, points);
+    });
+    std::printf("%-34s %12.1f MB/s, %zu samples -> %zu points\n", "load whole csv + rdp", megabytes / (nanos / 1e9),
+        loaded.size(), points.size());
+
+    std::filesystem::remove(csvPath);
+    std::filesystem::remove(binPath);
+}
+
+// The generator before the waveform engine: accumulated float time, std::sin per sample, and a
+// copy, filter and full sort of the curve.
+std::vector<DataPoint> spliceSineWaveAccumulated(const std::vector<DataPoint>& points, const WaveSettings& settings) {
+    float startX = settings.append && !points.empty() ? points.back().x : 0.0f;
+    float duration = settings.timeScale - startX;
+
+    std::vector<DataPoint> newPoints;
+    for (float t = 0; t <= duration; t += settings.density) {
+        float x = startX + t;
+        float y = 50.0f + settings.amplitude * std::sin(2 * PI * settings.frequency * t);
+        y = std::clamp(y, 0.0f, 100.0f);
+        newPoints.push_back({x, y});
+    }
+
+    std::vector<DataPoint> result = points;
+    auto it = std::remove_if(result.begin(), result.end(),
+        [startX](const DataPoint& p) { return p.x >= startX; });
+    result.erase(it, result.end());
+    result.insert(result.end(), newPoints.begin(), newPoints.end());
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// A wave of `points` samples over 10 s appended to the second half of a curve of the same size.
+void benchWave(const BenchOptions& options, std::mt19937& rng) {
+    std::vector<DataPoint> curve = syntheticCurve(options.points, rng);
+    WaveSettings settings;
+    settings.timeScale = 10.0f;
+    settings.density = settings.timeScale / options.points;
+    settings.amplitude = 40.0f;
+    settings.append = true;
+    float mid = curve[curve.size() / 2].x;
+    for (auto& p : curve) p.x = p.x * (settings.timeScale / 2) / mid;  // ends at 10 s
+    curve.resize(curve.size() / 2);
+
+    std::vector<DataPoint> spliced;
+    double before = nanosPerOp(3, [&](size_t) { spliced = spliceSineWaveAccumulated(curve, settings); });
+    float lastBefore = spliced.back().x;
+    report("sine splice, float time + sort", before);
+    double after = nanosPerOp(3, [&](size_t) { spliced = spliceWave(curve, settings); });
+    report("sine splice, wave engine", after);
+    std::printf("%-34s %12.6f s (accumulated) vs %.6f s (indexed), %.6f s expected\n", "sine splice, last sample time",
+        lastBefore, spliced.back().x, settings.timeScale);
+
+    size_t samples = waveSampleCount(settings, 0.0f);
+    std::vector<DataPoint> buffer(samples);
+    for (WaveShape shape : {WaveShape::Sine, WaveShape::Triangle, WaveShape::Trapezoid, WaveShape::SCurve, WaveShape::Chirp}) {
+        settings.shape = shape;
+        std::string name = std::string("wave kernel, ") + waveShapeName(shape);
+        double nanos = nanosPerOp(3, [&](size_t) { sampleWave(settings, 0.0f, 0, samples, buffer.data()); });
+        report(name.c_str(), nanos / samples, "sample");
+    }
+
+    // The same samples with std::sin: time from the index and the phase reduced in double, as
+    // the engine does, then clamped. Without the double time the last sample drifts, as above.
+    double indexed = nanosPerOp(3, [&](size_t) {
+        for (size_t i = 0; i < samples; ++i) {
+            double t = static_cast<double>(i) * settings.density;
+            double cycles = t * settings.frequency;
+            float phase = static_cast<float>(cycles - std::floor(cycles));
+            float v = 50.0f + settings.amplitude * std::sin(2 * PI * phase);
+            buffer[i] = {static_cast<float>(t), std::max(0.0f, std::min(v, 100.0f))};
+        }
+    }) / samples;
+    report("std::sin, indexed time", indexed, "sample");
+    double accumulated = nanosPerOp(3, [&](size_t) {
+        for (size_t i = 0; i < samples; ++i) {
+            float t = static_cast<float>(i) * settings.density;
+            buffer[i] = {t, 50.0f + settings.amplitude * std::sin(2 * PI * settings.frequency * t)};
+        }
+    }) / samples;
+    report("std::sin, float time, no clamp", accumulated, "sample");
+}
+
+// Each simplifier engine on the noisy sine at 8 PWM counts, above its noise of about 5, against the
+// RDP the editor used before (perpendicular epsilon 0.5, which mixes seconds with percent).
+void benchSimplifiers(const BenchOptions& options, std::mt19937& rng) {
+    std::vector<DataPoint> points = syntheticCurve(options.points, rng);
+    std::vector<DataPoint> simplified;
+    auto row = [&](const char* name, double nanos) {
+        FitError fit = measureFitError(points, simplified);
+        report(name, nanos, "curve");
+        std::printf("%-34s %12zu points, max error %.2f counts\n", "", simplified.size(),
+            fit.maxError * 255.0f / 100.0f);
+    };
+    row("simplify, rdp epsilon 0.5",
+        nanosPerOp(3, [&](size_t) { rdpSimplify(points, 0.5f, simplified); }));
+    for (Simplifier engine : {Simplifier::Rdp, Simplifier::SwingDoor, Simplifier::Visvalingam}) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "simplify, %s 8 counts", simplifierName(engine));
+        row(name, nanosPerOp(3, [&](size_t) { simplifyCurve(points, engine, 8.0f, simplified); }));
+    }
+}
+
+// A drag streamed to the resident player, compiled for the host and running behind a
+// pseudo-terminal: 60 edits of one point at the editor's frame rate, and 60 back to back, which
+// the link merges into fewer updates. Latency runs from the oldest edit in an update to the
+// board's answer. A pseudo-terminal has no line rate, so the time the bytes would take at the
+// link's baud rate is given beside it.
+void benchLive(const BenchOptions&, std::mt19937&) {
+    std::vector<DataPoint> curve;
+    for (int i = 0; i <= 80; ++i) {
+        float x = static_cast<float>(i) * 0.05f;
+        curve.push_back({x, 50.0f + 40.0f * std::sin(x * PI)});
+    }
+    LiveOptions options;
+    std::ostringstream sketch;
+    writeLiveSketch(sketch, curve, options);
+    SketchStandIn board;
+    LiveLink link;
+    std::string error;
+    if (!board.start(sketch.str(), {}, error) || !link.open(board.port(), options, error)) {
+        std::printf("%-34s skipped: %s\n", "live link", error.substr(0, error.find('\n')).c_str());
+        return;
+    }
+    auto wireMs = [&](double bytes) { return bytes * 10 * 1000 / options.baud; };
+
+    link.submit(curve);
+    link.flush(5000);
+    LiveStats whole = link.stats();
+    std::printf("%-34s %12zu bytes, %.2f ms to confirm (+%.1f ms at %u baud)\n", "live link, whole curve",
+        whole.lastBytes, whole.lastLatencyMs, wireMs(static_cast<double>(whole.lastBytes)), options.baud);
+
+    // At the editor's frame rate, then as fast as edits can be submitted.
+    for (int pauseMs : {16, 0}) {
+        LiveStats before = link.stats();
+        for (int edit = 0; edit < 60; ++edit) {
+            curve[40].y = 20.0f + static_cast<float>(edit + pauseMs);
+            link.submit(curve);
+            std::this_thread::sleep_for(std::chrono::milliseconds(pauseMs));
+        }
+        link.flush(5000);
+        LiveStats after = link.stats();
+        size_t updates = after.updates - before.updates;
+        double bytes = updates ? static_cast<double>(after.bytesSent - before.bytesSent) / updates : 0.0;
+        double meanMs = updates ? (after.totalLatencyMs - before.totalLatencyMs) / updates : 0.0;
+        char name[64];
+        std::snprintf(name, sizeof(name), "live link, drag, %d ms apart", pauseMs);
+        std::printf("%-34s %12zu edits in %zu updates, %.1f bytes per update, %zu resyncs\n", name,
+            after.edits - before.edits, updates, bytes, after.resyncs - before.resyncs);
+        std::printf("%-34s %12.2f ms mean, %.2f ms max to confirm (+%.1f ms at %u baud)\n", "", meanMs,
+            after.maxLatencyMs, wireMs(bytes), options.baud);
+    }
+    link.lastError(error);
+    if (!error.empty()) std::printf("%-34s %s\n", "", error.c_str());
+}
+
+// Sessions at every decade up to --points: opening the snapshot against loading the curve from
+// CSV, and an autosave after a one-point drag, appended to the journal against rewriting the file.
+void benchSession(const BenchOptions& options, std::mt19937& rng) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string path = (dir / "motor_curve_bench.mcs").string();
+    std::string csvPath = (dir / "motor_curve_bench_session.csv").string();
+    std::string error;
+    for (size_t n = 10000; n <= options.points; n *= 10) {
+        std::vector<DataPoint> points = syntheticCurve(n, rng);
+        CurveStore store;
+        store.assign(points);
+        store.clearUnsaved();
+        SessionSettings settings;
+        SessionWriter writer;
+        std::vector<SessionChannel> channels = {{10, store.view()}};
+        double saveNanos = nanosPerOp(3, [&](size_t) { writer.save(path, settings, channels, error); });
+        SessionData session;
+        double loadNanos = nanosPerOp(3, [&](size_t) {
+            if (!loadSession(path, session, error)) std::printf("%s\n", error.c_str());
+        });
+        std::printf("%-34s %12.2f ms to open, %.2f ms to save, %.1f MB\n",
+            ("session, " + std::to_string(n) + " points").c_str(), loadNanos / 1e6, saveNanos / 1e6,
+            std::filesystem::file_size(path) / 1e6);
+        if (n <= 1000000) {
+            saveCurveCsv(csvPath, points);
+            std::vector<DataPoint> loaded;
+            double csvNanos = nanosPerOp(3, [&](size_t) { loadCurveCsv(csvPath, loaded, error); });
+            std::printf("%-34s %12.2f ms to load, %.1f MB\n", "", csvNanos / 1e6,
+                std::filesystem::file_size(csvPath) / 1e6);
+        }
+
+        // One drag step per autosave, the way the editor appends them.
+        std::uniform_int_distribution<size_t> interior(1, n - 3);
+        size_t saves = std::min<size_t>(options.reps, 200);
+        uint64_t journalBefore = writer.stats().journalBytes;
+        double appendNanos = nanosPerOp(saves, [&](size_t) {
+            size_t i = interior(rng);
+            store.move(i, {store[i].x, 50.0f});
+            const CurveStore::Changes& edit = store.unsaved();
+            writer.appendSplice(0, store.view(), edit.first, edit.tail, error);
+            writer.flush(error);
+            store.clearUnsaved();
+        });
+        std::printf("%-34s %12.2f us per autosave, %.0f bytes appended\n", "", appendNanos / 1e3,
+            static_cast<double>(writer.stats().journalBytes - journalBefore) / saves);
+        writer.close();
+        loadNanos = nanosPerOp(3, [&](size_t) { loadSession(path, session, error); });
+        bool same = session.channels[0].points.size() == store.size();
+        for (size_t i = 0; same && i < store.size(); ++i)
+            same = session.channels[0].points[i].x == store[i].x && session.channels[0].points[i].y == store[i].y;
+        std::printf("%-34s %12.2f ms to open with %zu records replayed%s\n", "", loadNanos / 1e6,
+            session.journalRecords, same ? "" : ", MISMATCH");
+    }
+    std::filesystem::remove(path);
+    std::filesystem::remove(csvPath);
+}
+
+// The pipeline sweep: each stage on each curve family at every decade from 10^3 points up to
+// --max-points, with allocations and peak RSS alongside the timings.
+enum class CurveFamily { RandomWalk, DenseSine, FlatHolds };
+
+const char* familyName(CurveFamily family) {
+    switch (family) {
+    case CurveFamily::RandomWalk: return "random_walk";
+    case CurveFamily::DenseSine: return "dense_sine";
+    case CurveFamily::FlatHolds: return "flat_holds";
+    }
+    return "";
+}
+
+// One sample per millisecond in every family, so sizes compare directly.
+std::vector<DataPoint> familyCurve(CurveFamily family, size_t count, std::mt19937& rng) {
+    std::vector<DataPoint> points(count);
+    std::normal_distribution<float> step(0.0f, 0.5f);
+    std::uniform_int_distribution<int> holdLength(50, 2000);
+    std::uniform_real_distribution<float> level(0.0f, 100.0f);
+    float y = 50.0f;
+    size_t holdLeft = 0;
+    for (size_t i = 0; i < count; ++i) {
+        float x = static_cast<float>(i) * 0.001f;
+        switch (family) {
+        case CurveFamily::RandomWalk:
+            y = std::clamp(y + step(rng), 0.0f, 100.0f);
+            break;
+        case CurveFamily::DenseSine:
+            y = 50.0f + 45.0f * std::sin(x * 2 * PI * 5.0f);  // 5 Hz, 200 samples per period
+            break;
+        case CurveFamily::FlatHolds:
+            if (holdLeft-- == 0) {
+                holdLeft = holdLength(rng);
+                y = level(rng);
+            }
+            break;
+        }
+        points[i] = {x, y};
+    }
+    return points;
+}
+
+// Peak resident set size in KiB since the last resetPeakRss(). Linux only; 0 elsewhere.
+void resetPeakRss() {
+#ifdef __linux__
+    if (std::FILE* file = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", file);
+        std::fclose(file);
+    }
+#endif
+}
+
+uint64_t peakRssKib() {
+    uint64_t kib = 0;
+#ifdef __linux__
+    if (std::FILE* file = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        while (std::fgets(line, sizeof line, file)) {
+            if (std::strncmp(line, "VmHWM:", 6) == 0) kib = std::strtoull(line + 6, nullptr, 10);
+        }
+        std::fclose(file);
+    }
+#endif
+    return kib;
+}
+
+struct StageResult {
+    std::string stage;
+    std::string curve;
+    size_t points = 0;      // size of the stage's input
+    size_t reps = 0;
+    double nanosPerOp = 0;
+    double allocationsPerOp = 0;
+    double bytesPerOp = 0;
+    uint64_t peakRssKib = 0;
+};
+
+// Stages repeat until they have run this long or hit their rep cap, so every size takes
+// roughly the same wall time.
+constexpr double STAGE_BUDGET_NANOS = 3e8;
+// A stage whose single run took longer than this is not repeated at the next size; RDP on
+// some inputs is quadratic, and 10x the points would take 100x as long.
+constexpr double SLOW_RUN_NANOS = 2e9;
+
+// Times calls of `fn` on an input of `points` points and records what they allocated.
+template <typename Fn>
+StageResult measureStage(const char* stage, const char* curve, size_t points, size_t maxReps, Fn&& fn) {
+    resetPeakRss();
+    AllocationTotals before = allocationTotals();
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    size_t reps = 0;
+    while (reps < maxReps && elapsed < STAGE_BUDGET_NANOS) {
+        fn(reps++);
+        elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    StageResult result;
+    result.stage = stage;
+    result.curve = curve;
+    result.points = points;
+    result.reps = reps;
+    result.nanosPerOp = elapsed / reps;
+    AllocationTotals after = allocationTotals();
+    result.allocationsPerOp = static_cast<double>(after.count - before.count) / reps;
+    result.bytesPerOp = static_cast<double>(after.bytes - before.bytes) / reps;
+    result.peakRssKib = peakRssKib();
+    std::printf("%-11s %-12s %9zu %10.3f ns/point %10.1f allocs %12.0f bytes %9llu KiB peak\n", stage, curve, points,
+        result.nanosPerOp / std::max<size_t>(points, 1), result.allocationsPerOp, result.bytesPerOp,
+        static_cast<unsigned long long>(result.peakRssKib));
+    return result;
+}
+
+void writeSuiteJson(std::ostream& out, const BenchOptions& options, const std::vector<StageResult>& results) {
+    out << "{\n  \"seed\": " << options.seed << ",\n  \"max_points\": " << options.maxPoints << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const StageResult& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"stage\": \"" << r.stage << "\", \"curve\": \"" << r.curve
+            << "\", \"points\": " << r.points << ", \"reps\": " << r.reps << ", \"ns_per_op\": " << r.nanosPerOp
+            << ", \"ns_per_point\": " << r.nanosPerOp / std::max<size_t>(r.points, 1) << ", \"allocations_per_op\": " << r.allocationsPerOp
+            << ", \"bytes_per_op\": " << r.bytesPerOp << ", \"peak_rss_kib\": " << r.peakRssKib << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+bool runSuite(const BenchOptions& options, std::mt19937& rng) {
+    std::vector<StageResult> results;
+    std::vector<std::string> tooSlow;  // "stage/curve" pairs left out of larger sizes
+    long sink = 0;
+    auto stage = [&](const char* name, const char* curve, size_t points, size_t maxReps, auto&& fn) {
+        std::string key = std::string(name) + "/" + curve;
+        if (std::find(tooSlow.begin(), tooSlow.end(), key) != tooSlow.end()) {
+            std::printf("%-11s %-12s %9zu skipped, the previous size took over %.0f s per run\n", name, curve, points,
+                SLOW_RUN_NANOS / 1e9);
+            return false;
+        }
+        results.push_back(measureStage(name, curve, points, maxReps, fn));
+        if (results.back().nanosPerOp > SLOW_RUN_NANOS) tooSlow.push_back(key);
+        return true;
+    };
+
+    for (size_t n = 1000; n <= options.maxPoints; n *= 10) {
+        for (CurveFamily family : {CurveFamily::RandomWalk, CurveFamily::DenseSine, CurveFamily::FlatHolds}) {
+            const char* curve = familyName(family);
+            std::vector<DataPoint> points = familyCurve(family, n, rng);
+
+            // The sketch is generated from the simplified curve, so codegen goes when rdp does.
+            std::vector<DataPoint> simplified;
+            bool simplifiedOk = stage("rdp", curve, n, 10000, [&](size_t) {
+                rdpSimplify(points, 0.5f, simplified);
+                sink += simplified.size();
+            });
+            std::vector<DataPoint> engineOut;
+            for (Simplifier engine : {Simplifier::SwingDoor, Simplifier::Visvalingam}) {
+                stage(simplifierName(engine), curve, n, 10000, [&](size_t) {
+                    simplifyCurve(points, engine, 1.0f, engineOut);
+                    sink += engineOut.size();
+                });
+            }
+            CodeOptions code;
+            code.player = PlayerKind::Cursor;
+            if (simplifiedOk) {
+                stage("codegen", curve, simplified.size(), 10000, [&](size_t) {
+                    std::ostringstream sketch;
+                    writeArduinoCode(sketch, simplified, code);
+                    sink += sketch.tellp();
+                });
+            }
+
+            float duration = points.back().x;
+            PlotScale scale{PLOT_WIDTH / duration, PLOT_HEIGHT / 100.0f};
+            std::uniform_int_distribution<size_t> anyPoint(0, n - 1);
+            stage("pick", curve, n, 100000, [&](size_t) {
+                DataPoint click = points[anyPoint(rng)];
+                sink += pickPoint(points, {click.x, click.y + 1.0f}, scale, PICK_RADIUS);
+            });
+
+            PlotGeometryCache geometry;
+            PlotViewport viewport{PLOT_WIDTH, PLOT_HEIGHT, duration, PICK_RADIUS / 2};
+            uint64_t revision = 0;
+            stage("plot", curve, n, 10000, [&](size_t) { geometry.update(points, ++revision, viewport); });
+        }
+
+        // The generator takes no input curve: n samples of a 1 Hz sine, one per millisecond.
+        WaveSettings wave;
+        wave.timeScale = static_cast<float>(n - 1) * 0.001f;
+        wave.density = 0.001f;
+        std::vector<DataPoint> samples;
+        stage("wave", "generated", n, 10000, [&](size_t) {
+            samples = spliceWave(CurveView{}, wave);
+            sink += samples.size();
+        });
+    }
+    std::printf("(checksum %ld)\n", sink);
+
+    if (options.jsonPath.empty()) return true;
+    std::ofstream out(options.jsonPath);
+    writeSuiteJson(out, options, results);
+    if (!out) {
+        std::fprintf(stderr, "cannot write %s\n", options.jsonPath.c_str());
+        return false;
+    }
+    std::printf("results written to %s\n", options.jsonPath.c_str());
+    return true;
+}
+
+void printUsage(const char* argv0) {
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "\n"
+        "  -n, --points N   points in the synthetic curve (default: 1000000)\n"
+        "  -r, --reps N     clicks to simulate; other cases scale from this (default: 1000)\n"
+        "  -s, --seed N     random seed (default: 1)\n"
+        "      --suite      run the pipeline sweep over random-walk, dense-sine and flat-hold\n"
+        "                   curves from 1000 points up, instead of the editor cases\n"
+        "      --max-points N\n"
+        "                   largest curve in the sweep (default: 10000000)\n"
+        "      --json FILE  write the sweep results as JSON (implies --suite)\n",
+        argv0);
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--suite") {
+            options.suite = true;
+            continue;
+        }
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) return false;
+        if (arg == "-n" || arg == "--points") {
+            options.points = std::strtoul(v, nullptr, 10);
+        } else if (arg == "-r" || arg == "--reps") {
+            options.reps = std::strtoul(v, nullptr, 10);
+        } else if (arg == "-s" || arg == "--seed") {
+            options.seed = static_cast<unsigned>(std::strtoul(v, nullptr, 10));
+        } else if (arg == "--max-points") {
+            options.maxPoints = std::strtoul(v, nullptr, 10);
+        } else if (arg == "--json") {
+            options.jsonPath = v;
+            options.suite = true;
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return options.points >= 2 && options.reps > 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    std::mt19937 rng(options.seed);
+    if (options.suite) return runSuite(options, rng) ? 0 : 1;
+    std::printf("%zu points\n", options.points);
+    benchSelection(options, rng);
+    benchPlot(options, rng);
+    benchStore(options, rng);
+    benchHistory(options, rng);
+    benchChannels(options, rng);
+    benchImport(options, rng);
+    benchWave(options, rng);
+    benchSimplifiers(options, rng);
+    benchLive(options, rng);
+    benchSession(options, rng);
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "board.h"
+
+bool BoardProfile::fits(size_t bytes, size_t largestArray) const {
+    return bytes <= curveBytes && (maxArrayBytes == 0 || largestArray <= maxArrayBytes);
+}
+
+const std::vector<BoardProfile>& boardProfiles() {
+    // AVR budgets leave 2 KB for the core and player. avr-gcc limits objects to 32767 bytes,
+    // and pgm_read_* only reaches the first 64 KB, which caps the Mega below its real flash.
+    // The ESP32 figure is the default 1.25 MB app partition minus about 300 KB of core, and its
+    // RAM what the heap typically has free.
+    static const std::vector<BoardProfile> boards = {
+        {"uno", "Arduino Uno (ATmega328P)", 32256 - 2048, 32767, 2048},
+        {"nano", "Arduino Nano (ATmega328P, old bootloader)", 30720 - 2048, 32767, 2048},
+        {"mega", "Arduino Mega 2560", 65536 - 2048, 32767, 8192},
+        {"esp32", "ESP32", 1310720 - 307200, 0, 160 * 1024},
+    };
+    return boards;
+}
+
+const BoardProfile* findBoard(const std::string& name) {
+    for (const auto& board : boardProfiles()) {
+        if (name == board.name) return &board;
+    }
+    return nullptr;
+}
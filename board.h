@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Flash available to curve tables on a target board, after the bootloader, the Arduino core
+// and the player code.
+struct BoardProfile {
+    const char* name;       // command-line name, e.g. "uno"
+    const char* label;      // display name
+    size_t curveBytes;      // total PROGMEM budget for the curve tables
+    size_t maxArrayBytes;   // largest single array the toolchain accepts, 0 for no limit
+    size_t ramBytes;        // SRAM, for players that keep the curve in RAM
+
+    bool fits(size_t bytes, size_t largestArray) const;
+};
+
+const std::vector<BoardProfile>& boardProfiles();
+const BoardProfile* findBoard(const std::string& name);
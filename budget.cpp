@@ -0,0 +1,182 @@
+#include "budget.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr uint32_t UNREACHED = std::numeric_limits<uint32_t>::max();
+
+}  // namespace
+
+const BudgetResult& BudgetSimplifier::solve(CurveView points, size_t budget,
+                                            const SimplifyCache* hierarchy) {
+    budget = std::max<size_t>(budget, 2);
+    if (points.size() <= budget) {
+        current.points.clear();
+        for (size_t i = 0; i < points.size(); ++i) current.points.push_back(points[i]);
+        current.method = BudgetResult::Method::Exact;
+        current.epsilon = 0;
+        current.error = {};
+        return current;
+    }
+
+    collectSplits(points, budget - 1, hierarchy);
+    if (points.size() <= optimalLimit) {
+        solveOptimal(points, budget);
+    } else {
+        solveRdp(points, budget);
+    }
+    current.error = measureFitError(points, current.points);
+    return current;
+}
+
+void BudgetSimplifier::collectSplits(CurveView points, size_t count,
+                                     const SimplifyCache* hierarchy) {
+    splits.clear();
+    if (hierarchy) {
+        hierarchy->topSplits(count, splits);
+        return;
+    }
+
+    // Best-first walk of the RDP hierarchy. A split survives epsilon iff every range on its path
+    // was divided, i.e. iff the smallest maxDist along that path (its effective distance)
+    // exceeds epsilon. Effective distances only shrink going down, so ranges are expanded in
+    // descending order and only about `count` of them are ever scanned.
+    frontier.clear();
+    auto push = [&](size_t first, size_t last, float limit) {
+        float maxDist;
+        size_t split = farthestPoint(points, first, last, maxDist);
+        if (split == 0) return;
+        frontier.push_back({std::min(limit, maxDist), first, last, split});
+        std::push_heap(frontier.begin(), frontier.end());
+    };
+    push(0, points.size() - 1, FLT_MAX);
+    while (!frontier.empty() && splits.size() < count) {
+        std::pop_heap(frontier.begin(), frontier.end());
+        Range range = frontier.back();
+        frontier.pop_back();
+        splits.push_back({range.effective, range.split});
+        push(range.first, range.split, range.effective);
+        push(range.split, range.last, range.effective);
+    }
+}
+
+void BudgetSimplifier::solveRdp(CurveView points, size_t budget) {
+    size_t n = points.size();
+
+    // Splits arrive in descending effective order. The (budget - 1)-th one is the smallest
+    // epsilon that keeps at most budget - 2 interior points.
+    size_t interior = budget - 2;
+    float epsilon = splits.size() > interior ? splits[interior].first : 0.0f;
+
+    kept.clear();
+    kept.push_back(0);
+    kept.push_back(n - 1);
+    for (const auto& [effective, index] : splits) {
+        if (effective > epsilon) kept.push_back(index);
+    }
+    std::sort(kept.begin(), kept.end());
+    current.points.clear();
+    for (size_t index : kept) current.points.push_back(points[index]);
+    current.method = BudgetResult::Method::RdpSearch;
+    current.epsilon = epsilon;
+}
+
+void BudgetSimplifier::solveOptimal(CurveView points, size_t budget) {
+    // The RDP answer fits the budget, so its error bounds the optimum from above.
+    solveRdp(points, budget);
+    double hi = measureFitError(points, current.points).maxError;
+    hi = hi * (1 + 1e-6) + 1e-6;
+    double lo = 0;
+
+    size_t lanes = pool ? pool->size() : 1;
+    if (workspaces.size() < lanes) workspaces.resize(lanes);
+    std::vector<double> candidates(lanes);
+    std::vector<uint8_t> ok(lanes);
+
+    // Narrow the tolerance with one probe per worker per round.
+    for (int round = 0; round < 64 && hi - lo > std::max(1e-4, hi * 1e-4); ++round) {
+        for (size_t i = 0; i < lanes; ++i) {
+            candidates[i] = lo + (hi - lo) * (i + 1) / (lanes + 1);
+        }
+        auto probe = [&](size_t i) { ok[i] = feasible(points, budget, candidates[i], workspaces[i]); };
+        if (pool && lanes > 1) {
+            pool->parallelFor(lanes, probe);
+        } else {
+            probe(0);
+        }
+
+        size_t first = 0;
+        while (first < lanes && !ok[first]) ++first;
+        if (first < lanes) hi = candidates[first];
+        if (first > 0) lo = candidates[first - 1];
+    }
+
+    Workspace& ws = workspaces[0];
+    if (!feasible(points, budget, hi, ws)) return;  // keep the RDP answer
+
+    current.points.clear();
+    for (uint32_t i = static_cast<uint32_t>(points.size() - 1);; i = ws.previous[i]) {
+        current.points.push_back(points[i]);
+        if (i == 0) break;
+    }
+    std::reverse(current.points.begin(), current.points.end());
+    current.method = BudgetResult::Method::Optimal;
+    current.epsilon = 0;
+}
+
+// Fewest-points path from the first to the last point using segments that stay within
+// `tolerance` of every point they skip. For each start the admissible slopes form a window
+// that only narrows, so the scan stops as soon as no further segment can be valid.
+bool BudgetSimplifier::feasible(CurveView points, size_t budget, double tolerance,
+                                Workspace& ws) const {
+    size_t n = points.size();
+    ws.count.assign(n, UNREACHED);
+    ws.previous.resize(n);
+    ws.count[0] = 1;
+
+    for (size_t i = 0; i + 1 < n; ++i) {
+        uint32_t reached = ws.count[i];
+        if (reached >= budget) continue;
+        double xi = points.x(i), yi = points.y(i);
+        double lo = -std::numeric_limits<double>::infinity();
+        double hi = std::numeric_limits<double>::infinity();
+        // Skipped points sharing the start time, which the segment meets only at y_i.
+        float sameLo = FLT_MAX, sameHi = -FLT_MAX;
+        bool sameTimeOk = true;
+        for (size_t j = i + 1; j < n; ++j) {
+            double dx = points.x(j) - xi;
+            double dy = points.y(j) - yi;
+            bool valid;
+            if (dx <= 0) {
+                // A vertical step covers the values between its ends.
+                float stepLo = std::min(points.y(i), points.y(j)) - static_cast<float>(tolerance);
+                float stepHi = std::max(points.y(i), points.y(j)) + static_cast<float>(tolerance);
+                valid = j == i + 1 || (sameLo >= stepLo && sameHi <= stepHi);
+            } else {
+                if (!sameTimeOk) break;
+                double slope = dy / dx;
+                valid = slope >= lo && slope <= hi;
+            }
+            if (valid && reached + 1 < ws.count[j]) {
+                ws.count[j] = reached + 1;
+                ws.previous[j] = static_cast<uint32_t>(i);
+            }
+
+            if (dx <= 0) {
+                sameLo = std::min(sameLo, points.y(j));
+                sameHi = std::max(sameHi, points.y(j));
+                sameTimeOk = sameTimeOk && std::abs(dy) <= tolerance;
+                continue;
+            }
+            lo = std::max(lo, (dy - tolerance) / dx);
+            hi = std::min(hi, (dy + tolerance) / dx);
+            if (lo > hi) break;
+        }
+    }
+    return ws.count[n - 1] <= budget;
+}
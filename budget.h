@@ -0,0 +1,65 @@
+#pragma once
+
+#include "curve.h"
+#include "simplify.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+struct BudgetResult {
+    enum class Method { Exact, RdpSearch, Optimal };
+
+    std::vector<DataPoint> points;
+    Method method = Method::Exact;
+    float epsilon = 0;     // smallest RDP epsilon meeting the budget (RdpSearch only)
+    FitError error;
+};
+
+// Finds the lowest-error simplification of a curve that keeps at most `budget` points.
+//
+// Small inputs are solved optimally: the maximum vertical error is minimized over every choice
+// of at most `budget` original points, by searching the tolerance with a min-points shortest
+// path over the valid shortcut segments. The tolerance search is split across the pool.
+// Larger inputs walk the RDP hierarchy best-first, which reads off the smallest epsilon that
+// meets the budget directly; the result is identical to rdpSimplify() at that epsilon.
+// Buffers are kept between calls so re-solving while a point is dragged stays cheap.
+class BudgetSimplifier {
+public:
+    explicit BudgetSimplifier(ThreadPool* pool = nullptr) : pool(pool) {}
+
+    // Inputs with more points than this use the RDP search instead of the optimal solver.
+    size_t optimalLimit = 4096;
+
+    // `hierarchy`, if given, must hold `points` at epsilon 0; its incrementally maintained tree
+    // then replaces the full RDP walk, which is what keeps large curves interactive.
+    const BudgetResult& solve(CurveView points, size_t budget,
+                              const SimplifyCache* hierarchy = nullptr);
+    const BudgetResult& result() const { return current; }
+
+private:
+    struct Workspace {
+        std::vector<uint32_t> count;
+        std::vector<uint32_t> previous;
+    };
+
+    struct Range {
+        float effective;
+        size_t first, last, split;
+        bool operator<(const Range& other) const { return effective < other.effective; }
+    };
+
+    void collectSplits(CurveView points, size_t count, const SimplifyCache* hierarchy);
+    void solveRdp(CurveView points, size_t budget);
+    void solveOptimal(CurveView points, size_t budget);
+    bool feasible(CurveView points, size_t budget, double tolerance, Workspace& ws) const;
+
+    ThreadPool* pool;
+    BudgetResult current;
+    std::vector<Range> frontier;
+    std::vector<std::pair<float, size_t>> splits;
+    std::vector<size_t> kept;
+    std::vector<Workspace> workspaces;
+};
@@ -0,0 +1,697 @@
+#include "codegen.h"
+
+#include "avr_cycles.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace {
+
+// The curve as the integer players store it: millisecond times and PWM values.
+struct IntegerCurve {
+    std::vector<uint32_t> times;
+    std::vector<int> values;
+    uint32_t totalMs = 1;
+    bool wideTime = false;   // times need uint32_t
+    bool wideIndex = false;  // segment index needs uint16_t
+};
+
+IntegerCurve quantize(const std::vector<DataPoint>& points) {
+    IntegerCurve curve;
+    for (const auto& p : points) {
+        curve.times.push_back(toMs(p.x));
+        curve.values.push_back(toPwm(p.y));
+    }
+    if (!curve.times.empty()) curve.totalMs = std::max<uint32_t>(1, curve.times.back());
+    curve.wideTime = curve.totalMs > 0xFFFF;
+    curve.wideIndex = points.size() > 0xFF;
+    return curve;
+}
+
+// Q16 PWM counts per millisecond for each segment.
+std::vector<int32_t> segmentSlopes(const IntegerCurve& curve) {
+    std::vector<int32_t> slopes;
+    for (size_t i = 0; i + 1 < curve.times.size(); ++i) {
+        uint32_t span = curve.times[i + 1] - curve.times[i];
+        int dv = curve.values[i + 1] - curve.values[i];
+        slopes.push_back(span > 0 ? static_cast<int32_t>(std::lround(dv * 65536.0 / span)) : 0);
+    }
+    return slopes;
+}
+
+// Value the Cursor player outputs at `ms`, used to fill the Lookup table.
+int valueAt(const IntegerCurve& curve, uint32_t ms) {
+    size_t n = curve.times.size();
+    if (n < 2) return n ? curve.values[0] : 0;
+    size_t seg = std::upper_bound(curve.times.begin() + 1, curve.times.end() - 1, ms) - curve.times.begin() - 1;
+    uint32_t t1 = curve.times[seg], t2 = curve.times[seg + 1];
+    int v1 = curve.values[seg], v2 = curve.values[seg + 1];
+    if (ms <= t1) return v1;
+    return v1 + static_cast<int32_t>(v2 - v1) * static_cast<int32_t>(ms - t1) / static_cast<int32_t>(t2 - t1);
+}
+
+std::vector<int> lookupTable(const IntegerCurve& curve, unsigned shift) {
+    std::vector<int> table(((curve.totalMs - 1) >> shift) + 1);
+    for (size_t i = 0; i < table.size(); ++i) {
+        table[i] = valueAt(curve, static_cast<uint32_t>(i << shift));
+    }
+    return table;
+}
+
+// Most segment boundaries the cursor can cross in a single tick, wrap-around included.
+unsigned maxSegmentSteps(const IntegerCurve& curve, unsigned tickMs) {
+    size_t n = curve.times.size();
+    if (n < 3) return 0;
+    std::vector<uint32_t> boundaries(curve.times.begin() + 1, curve.times.end() - 1);
+    size_t count = boundaries.size();
+    for (size_t i = 0; i < count; ++i) boundaries.push_back(boundaries[i] + curve.totalMs);
+
+    uint32_t window = std::max(1u, tickMs);
+    unsigned best = 0;
+    for (size_t lo = 0, hi = 0; lo < count; ++lo) {
+        while (hi < boundaries.size() && boundaries[hi] < boundaries[lo] + window) ++hi;
+        best = std::max(best, static_cast<unsigned>(hi - lo));
+    }
+    return best;
+}
+
+size_t lookupSize(const IntegerCurve& curve, unsigned shift) {
+    return ((curve.totalMs - 1) >> shift) + 1;
+}
+
+uint32_t maxTimeStep(const IntegerCurve& curve) {
+    uint32_t step = 0;
+    for (size_t i = 1; i < curve.times.size(); ++i) step = std::max(step, curve.times[i] - curve.times[i - 1]);
+    return step;
+}
+
+bool isStream(TableEncoding encoding) {
+    return encoding == TableEncoding::Varint || encoding == TableEncoding::Nibble || encoding == TableEncoding::Rle;
+}
+
+bool isCursor(PlayerKind player) {
+    return player == PlayerKind::Cursor || player == PlayerKind::FixedPoint;
+}
+
+void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+struct ByteStream {
+    std::vector<uint8_t> bytes;
+    size_t maxRecord = 0;  // longest record, for the worst-case decode cost
+};
+
+// Encodes every point relative to the previous one, starting from time 0 and value 0,
+// exactly as the generated readPoint() decodes it.
+ByteStream encodeStream(const IntegerCurve& curve, TableEncoding encoding) {
+    ByteStream stream;
+    size_t n = curve.times.size();
+    uint32_t prevTime = 0;
+    int prevValue = 0;
+    for (size_t i = 0; i < n;) {
+        size_t start = stream.bytes.size();
+        uint32_t dt = curve.times[i] - prevTime;
+        int dv = curve.values[i] - prevValue;
+        size_t count = 1;
+        if (encoding == TableEncoding::Rle) {
+            while (i + count < n && count < 255 && curve.times[i + count] - curve.times[i + count - 1] == dt &&
+                   curve.values[i + count] - curve.values[i + count - 1] == dv) {
+                ++count;
+            }
+            stream.bytes.push_back(static_cast<uint8_t>(count));
+            putVarint(stream.bytes, dt);
+            putVarint(stream.bytes, dv < 0 ? 2u * -dv - 1 : 2u * dv);
+        } else if (encoding == TableEncoding::Nibble && dt >= 1 && dt <= 15 && dv >= -8 && dv <= 7) {
+            stream.bytes.push_back(static_cast<uint8_t>(dt << 4 | (dv & 0xF)));
+        } else {
+            if (encoding == TableEncoding::Nibble) stream.bytes.push_back(0);
+            putVarint(stream.bytes, dt);
+            stream.bytes.push_back(static_cast<uint8_t>(curve.values[i]));
+        }
+        stream.maxRecord = std::max(stream.maxRecord, stream.bytes.size() - start);
+        i += count;
+        prevTime = curve.times[i - 1];
+        prevValue = curve.values[i - 1];
+    }
+    return stream;
+}
+
+EncodingSize measureEncoding(const IntegerCurve& curve, const CodeOptions& options, TableEncoding encoding) {
+    EncodingSize size{encoding};
+    size_t n = curve.times.size();
+    bool fixed = options.player == PlayerKind::FixedPoint;
+    if (encoding == TableEncoding::Plain) {
+        size.available = true;
+        if (options.player == PlayerKind::Scan) {
+            size.bytes = n * (sizeof(float) + 1);
+            size.largestArray = n * sizeof(float);
+        } else if (options.player == PlayerKind::Lookup) {
+            size.bytes = size.largestArray = lookupSize(curve, options.lookupShift);
+        } else {
+            size_t timeBytes = curve.wideTime ? 4 : 2;
+            size_t slopeBytes = fixed && n > 1 ? 4 * (n - 1) : 0;
+            size.bytes = n * (timeBytes + 1) + slopeBytes;
+            size.largestArray = std::max(n * timeBytes, slopeBytes);
+        }
+        return size;
+    }
+    if (!isCursor(options.player) || n < 2) return size;
+
+    if (isStream(encoding)) {
+        size.bytes = size.largestArray = encodeStream(curve, encoding).bytes.size();
+    } else {
+        size_t stepBytes = encoding == TableEncoding::Delta8 ? 1 : 2;
+        if (maxTimeStep(curve) >> (8 * stepBytes)) return size;
+        size.bytes = (n - 1) * stepBytes + n;
+        size.largestArray = std::max((n - 1) * stepBytes, n);
+    }
+    size.available = true;
+    return size;
+}
+
+std::vector<EncodingSize> measureAll(const IntegerCurve& curve, const CodeOptions& options) {
+    std::vector<EncodingSize> sizes;
+    for (int e = static_cast<int>(TableEncoding::Plain); e <= static_cast<int>(TableEncoding::Rle); ++e) {
+        sizes.push_back(measureEncoding(curve, options, static_cast<TableEncoding>(e)));
+    }
+    return sizes;
+}
+
+TableEncoding resolve(const std::vector<EncodingSize>& sizes, TableEncoding requested) {
+    const EncodingSize* best = &sizes.front();
+    for (const auto& size : sizes) {
+        if (!size.available) continue;
+        if (size.encoding == requested) return requested;
+        if (requested == TableEncoding::Auto && size.bytes < best->bytes) best = &size;
+    }
+    return requested == TableEncoding::Auto ? best->encoding : TableEncoding::Plain;
+}
+
+template <typename T>
+void writeList(std::ostream& out, const std::vector<T>& items) {
+    for (size_t i = 0; i < items.size(); ++i) {
+        out << +items[i] << (i == items.size() - 1 ? "" : ", ");
+    }
+}
+
+void writeTables(std::ostream& out, const std::vector<DataPoint>& points, const std::string& prefix) {
+    out << "const int " << prefix << "NUM_POINTS = " << points.size() << ";\n\n";
+
+    out << "const float " << prefix << "timePoints[] PROGMEM = {";
+    for (size_t i = 0; i < points.size(); ++i) {
+        out << points[i].x << (i == points.size() - 1 ? "" : ", ");
+    }
+    out << "};\n\n";
+
+    out << "const uint8_t " << prefix << "values[] PROGMEM = {";
+    for (size_t i = 0; i < points.size(); ++i) {
+        out << toPwm(points[i].y) << (i == points.size() - 1 ? "" : ", ");
+    }
+    out << "};\n\n";
+}
+
+void writeIntegerTables(std::ostream& out, const IntegerCurve& curve, const CodeOptions& options,
+                        TableEncoding encoding, const std::string& prefix) {
+    out << "const int " << prefix << "NUM_POINTS = " << curve.times.size() << ";\n";
+    out << "const uint32_t " << prefix << "TOTAL_MS = " << curve.totalMs << ";\n\n";
+
+    if (options.player == PlayerKind::Lookup) {
+        out << "const uint8_t " << prefix << "LOOKUP_SHIFT = " << options.lookupShift
+            << ";  // one sample every " << (1u << options.lookupShift) << " ms\n\n";
+        out << "const uint8_t " << prefix << "table[] PROGMEM = {";
+        writeList(out, lookupTable(curve, options.lookupShift));
+        out << "};\n\n";
+        return;
+    }
+
+    if (isStream(encoding)) {
+        if (encoding == TableEncoding::Varint) {
+            out << "// Per point: LEB128 time step (ms), then the PWM value\n";
+        } else if (encoding == TableEncoding::Nibble) {
+            out << "// Per point: (step << 4 | value delta) for steps of 1-15 ms and deltas of -8..7,\n";
+            out << "// otherwise 0, a LEB128 time step and the PWM value\n";
+        } else {
+            out << "// Runs of points with equal steps: count, LEB128 time step (ms), zigzag LEB128 value delta\n";
+        }
+        out << "const uint8_t " << prefix << "curve[] PROGMEM = {";
+        writeList(out, encodeStream(curve, encoding).bytes);
+        out << "};\n\n";
+        return;
+    }
+
+    if (encoding != TableEncoding::Plain) {
+        std::vector<uint32_t> steps;
+        for (size_t i = 1; i < curve.times.size(); ++i) steps.push_back(curve.times[i] - curve.times[i - 1]);
+        out << "const uint32_t " << prefix << "START_MS = " << curve.times.front() << ";\n\n";
+        out << "// Milliseconds from each point to the next\n";
+        out << "const " << (encoding == TableEncoding::Delta8 ? "uint8_t " : "uint16_t ") << prefix
+            << "timeSteps[] PROGMEM = {";
+        writeList(out, steps);
+        out << "};\n\n";
+
+        out << "const uint8_t " << prefix << "values[] PROGMEM = {";
+        writeList(out, curve.values);
+        out << "};\n\n";
+        return;
+    }
+
+    out << "const " << (curve.wideTime ? "uint32_t " : "uint16_t ") << prefix << "timePoints[] PROGMEM = {";
+    writeList(out, curve.times);
+    out << "};\n\n";
+
+    out << "const uint8_t " << prefix << "values[] PROGMEM = {";
+    writeList(out, curve.values);
+    out << "};\n\n";
+
+    if (options.player == PlayerKind::FixedPoint) {
+        out << "// Q16 PWM counts per millisecond, one per segment\n";
+        out << "const int32_t " << prefix << "slopes[] PROGMEM = {";
+        writeList(out, segmentSlopes(curve));
+        out << "};\n\n";
+    }
+}
+
+const char* const SETUP_PWM = R"(
+void setup() {
+  pinMode(10, OUTPUT);
+#ifdef TCCR1A
+  TCCR1A = _BV(COM1A1) | _BV(WGM10);
+  TCCR1B = _BV(CS10);
+#endif
+)";
+
+const char* const WRAP_CYCLE = R"(  uint32_t elapsed = millis() - cycleStart;
+  if (elapsed >= TOTAL_MS) {
+    // Wrap to the start; after a long stall resynchronise instead of replaying.
+    cycleStart += TOTAL_MS;
+    elapsed -= TOTAL_MS;
+    if (elapsed >= TOTAL_MS) {
+      cycleStart = millis();
+      elapsed = 0;
+    }
+)";
+
+const char* const SKETCH_PLAYER = R"(
+float getPointTime(int index) {
+  return pgm_read_float(&timePoints[index]);
+}
+
+uint8_t getPointValue(int index) {
+  return pgm_read_byte(&values[index]);
+}
+
+void loop() {
+  float totalDuration = getPointTime(NUM_POINTS - 1);
+  float currentTime = fmod(millis() / 1000.0, totalDuration);
+  float outputValue = 0.0;
+
+  for(int i = 0; i < NUM_POINTS - 1; i++) {
+    float t1 = getPointTime(i);
+    float t2 = getPointTime(i+1);
+    if(currentTime >= t1 && currentTime <= t2) {
+      float lerpT = (currentTime - t1) / (t2 - t1);
+      outputValue = getPointValue(i) + lerpT * (getPointValue(i+1) - getPointValue(i));
+      break;
+    }
+  }
+
+  analogWrite(10, (int)outputValue);
+  delay(10);
+}
+)";
+
+void writeTick(std::ostream& out, const CodeOptions& options) {
+    if (options.tickMs > 0) out << "  delay(" << options.tickMs << ");\n";
+}
+
+// Plain tables are read by segment index. The other encodings only support reading forward, so
+// readPoint() decodes the next point into t2/v2 and the fixed-point player derives its slope on
+// segment entry rather than reading it from a table.
+void writeCursorPlayer(std::ostream& out, const IntegerCurve& curve, const CodeOptions& options,
+                       TableEncoding encoding) {
+    bool fixed = options.player == PlayerKind::FixedPoint;
+    bool plain = encoding == TableEncoding::Plain;
+    bool stream = isStream(encoding);
+    const char* timeType = curve.wideTime ? "uint32_t" : "uint16_t";
+    const char* readTime = curve.wideTime ? "pgm_read_dword" : "pgm_read_word";
+
+    out << "uint32_t cycleStart;\n";
+    out << (curve.wideIndex ? "uint16_t" : "uint8_t") << " segment;\n";
+    out << timeType << " t1, t2;\n";
+    out << "int16_t v1, v2;\n";
+    if (fixed) out << "int32_t slope;\n";
+    if (stream) {
+        size_t streamBytes = encodeStream(curve, encoding).bytes.size();
+        out << (streamBytes > 0xFFFF ? "uint32_t" : "uint16_t") << " readPos;\n";
+    }
+    if (encoding == TableEncoding::Rle) {
+        out << "uint8_t runLeft;\n";
+        out << "uint32_t runStep;\n";
+        out << "int16_t runDelta;\n";
+    }
+
+    if (plain) {
+        out << "\n" << timeType << " getPointTime(int index) {\n";
+        out << "  return " << readTime << "(&timePoints[index]);\n";
+        out << "}\n";
+    } else {
+        if (stream) {
+            out << "\nuint32_t readVarint() {\n";
+            out << "  uint32_t value = 0;\n";
+            out << "  uint8_t shift = 0;\n";
+            out << "  uint8_t b;\n";
+            out << "  do {\n";
+            out << "    b = pgm_read_byte(&curve[readPos++]);\n";
+            out << "    value |= (uint32_t)(b & 0x7F) << shift;\n";
+            out << "    shift += 7;\n";
+            out << "  } while (b & 0x80);\n";
+            out << "  return value;\n";
+            out << "}\n";
+        }
+        out << "\nvoid readPoint() {\n";
+        switch (encoding) {
+        case TableEncoding::Delta8:
+        case TableEncoding::Delta16:
+            out << "  t2 += " << (encoding == TableEncoding::Delta8 ? "pgm_read_byte" : "pgm_read_word")
+                << "(&timeSteps[segment]);\n";
+            out << "  v2 = pgm_read_byte(&values[segment + 1]);\n";
+            break;
+        case TableEncoding::Varint:
+            out << "  t2 += readVarint();\n";
+            out << "  v2 = pgm_read_byte(&curve[readPos++]);\n";
+            break;
+        case TableEncoding::Nibble:
+            out << "  uint8_t b = pgm_read_byte(&curve[readPos++]);\n";
+            out << "  if (b >> 4) {\n";
+            out << "    t2 += b >> 4;\n";
+            out << "    v2 += (int8_t)(b << 4) >> 4;\n";
+            out << "  } else {\n";
+            out << "    t2 += readVarint();\n";
+            out << "    v2 = pgm_read_byte(&curve[readPos++]);\n";
+            out << "  }\n";
+            break;
+        default:
+            out << "  if (runLeft == 0) {\n";
+            out << "    runLeft = pgm_read_byte(&curve[readPos++]);\n";
+            out << "    runStep = readVarint();\n";
+            out << "    uint16_t zigzag = readVarint();\n";
+            out << "    runDelta = (int16_t)(zigzag >> 1) ^ -(int16_t)(zigzag & 1);\n";
+            out << "  }\n";
+            out << "  runLeft--;\n";
+            out << "  t2 += runStep;\n";
+            out << "  v2 += runDelta;\n";
+            break;
+        }
+        out << "}\n";
+        if (fixed) {
+            out << "\n// Q16 PWM counts per millisecond, rounded; one division per segment, not per tick.\n";
+            out << "void updateSlope() {\n";
+            out << "  int32_t span = t2 - t1;\n";
+            out << "  int32_t rise = (int32_t)(v2 - v1) * 65536;\n";
+            out << "  slope = span > 0 ? (rise + (rise < 0 ? -span : span) / 2) / span : 0;\n";
+            out << "}\n";
+        }
+    }
+
+    out << "\n// Segments are entered in order, so each tick costs O(1) amortized.\n";
+    out << "void startCycle() {\n";
+    out << "  segment = 0;\n";
+    if (plain) {
+        out << "  t1 = getPointTime(0);\n";
+        out << "  t2 = getPointTime(1);\n";
+        out << "  v1 = pgm_read_byte(&values[0]);\n";
+        out << "  v2 = pgm_read_byte(&values[1]);\n";
+        if (fixed) out << "  slope = (int32_t)pgm_read_dword(&slopes[0]);\n";
+    } else {
+        if (stream) {
+            out << "  readPos = 0;\n";
+            if (encoding == TableEncoding::Rle) out << "  runLeft = 0;\n";
+            out << "  t2 = 0;\n";
+            out << "  v2 = 0;\n";
+            out << "  readPoint();\n";
+        } else {
+            out << "  t2 = START_MS;\n";
+            out << "  v2 = pgm_read_byte(&values[0]);\n";
+        }
+        out << "  t1 = t2;\n";
+        out << "  v1 = v2;\n";
+        out << "  readPoint();\n";
+        if (fixed) out << "  updateSlope();\n";
+    }
+    out << "}\n";
+
+    out << "\nvoid nextSegment() {\n";
+    out << "  segment++;\n";
+    out << "  t1 = t2;\n";
+    out << "  v1 = v2;\n";
+    if (plain) {
+        out << "  t2 = getPointTime(segment + 1);\n";
+        out << "  v2 = pgm_read_byte(&values[segment + 1]);\n";
+        if (fixed) out << "  slope = (int32_t)pgm_read_dword(&slopes[segment]);\n";
+    } else {
+        out << "  readPoint();\n";
+        if (fixed) out << "  updateSlope();\n";
+    }
+    out << "}\n";
+
+    out << SETUP_PWM;
+    out << "  startCycle();\n";
+    out << "  cycleStart = millis();\n";
+    out << "}\n";
+
+    out << "\nvoid loop() {\n";
+    out << WRAP_CYCLE;
+    out << "    startCycle();\n";
+    out << "  }\n";
+    out << "  while (segment < NUM_POINTS - 2 && elapsed >= t2) {\n";
+    out << "    nextSegment();\n";
+    out << "  }\n\n";
+    out << "  int16_t outputValue = v1;\n";
+    out << "  if (elapsed > t1) {\n";
+    if (fixed) {
+        out << "    outputValue = v1 + (int16_t)((slope * (int32_t)(elapsed - t1) + 0x8000) >> 16);\n";
+    } else {
+        out << "    outputValue = v1 + (int32_t)(v2 - v1) * (int32_t)(elapsed - t1) / (int32_t)(t2 - t1);\n";
+    }
+    out << "  }\n\n";
+    out << "  analogWrite(10, outputValue);\n";
+    writeTick(out, options);
+    out << "}\n";
+}
+
+void writeLookupPlayer(std::ostream& out, const CodeOptions& options) {
+    out << "uint32_t cycleStart;\n";
+    out << SETUP_PWM;
+    out << "  cycleStart = millis();\n";
+    out << "}\n";
+
+    out << "\nvoid loop() {\n";
+    out << WRAP_CYCLE;
+    out << "  }\n\n";
+    out << "  analogWrite(10, pgm_read_byte(&table[elapsed >> LOOKUP_SHIFT]));\n";
+    writeTick(out, options);
+    out << "}\n";
+}
+
+// Degenerate curves with fewer than two points just hold their value.
+void writeHoldPlayer(std::ostream& out, const IntegerCurve& curve, const CodeOptions& options) {
+    out << SETUP_PWM;
+    out << "  analogWrite(10, " << (curve.values.empty() ? 0 : curve.values.back()) << ");\n";
+    out << "}\n";
+    out << "\nvoid loop() {\n";
+    writeTick(out, options);
+    out << "}\n";
+}
+
+}  // namespace
+
+void writeArduinoCode(std::ostream& out, const std::vector<DataPoint>& points, const CodeOptions& options) {
+    bool header = options.format == CodeFormat::Header;
+    const std::string& prefix = header ? options.symbolPrefix : std::string();
+
+    if (options.player == PlayerKind::Scan) {
+        if (header) {
+            out << "#pragma once\n\n";
+            out << "#include <avr/pgmspace.h>\n\n";
+            writeTables(out, points, prefix);
+            return;
+        }
+        out << "#include <avr/pgmspace.h>\n";
+        out << "#include <math.h>\n\n";
+        writeTables(out, points, prefix);
+        // The scan divides by the curve's duration, which a single point does not have.
+        if (points.size() < 2) {
+            writeHoldPlayer(out, quantize(points), options);
+        } else {
+            out << SETUP_PWM;
+            out << "}\n";
+            out << SKETCH_PLAYER;
+        }
+        return;
+    }
+
+    IntegerCurve curve = quantize(points);
+    PlayerCost cost = estimatePlayerCost(points, options);
+    if (header) out << "#pragma once\n\n";
+    out << "#include <avr/pgmspace.h>\n\n";
+    out << "// Player: " << playerName(options.player) << ", " << encodingName(cost.encoding) << " encoding, "
+        << cost.flashBytes << " bytes of curve data\n";
+    out << "// Worst case per tick: ~" << cost.cycles << " cycles, " << cost.flashReads << " flash reads, "
+        << cost.divisions << " divisions (estimate)\n\n";
+    writeIntegerTables(out, curve, options, cost.encoding, prefix);
+    if (header) return;
+
+    if (points.size() < 2) {
+        writeHoldPlayer(out, curve, options);
+    } else if (options.player == PlayerKind::Lookup) {
+        writeLookupPlayer(out, options);
+    } else {
+        writeCursorPlayer(out, curve, options, cost.encoding);
+    }
+}
+
+int toPwm(float duty) {
+    return std::clamp((int)(duty * 2.55f), 0, 255);
+}
+
+uint32_t toMs(float seconds) {
+    return seconds > 0 ? static_cast<uint32_t>(std::lround(seconds * 1000.0)) : 0;
+}
+
+PlayerCost estimatePlayerCost(const std::vector<DataPoint>& points, const CodeOptions& options) {
+    PlayerCost cost;
+    size_t n = points.size();
+    IntegerCurve curve = quantize(points);
+    std::vector<EncodingSize> sizes = measureAll(curve, options);
+    cost.encoding = resolve(sizes, options.encoding);
+    const EncodingSize& size = sizes[static_cast<int>(cost.encoding) - static_cast<int>(TableEncoding::Plain)];
+    cost.flashBytes = size.bytes;
+    cost.largestArray = size.largestArray;
+
+    uint32_t timeRead = curve.wideTime ? CYCLES_PGM_DWORD : CYCLES_PGM_WORD;
+    cost.cycles = CYCLES_MILLIS + CYCLES_ANALOG_WRITE;
+
+    switch (options.player) {
+    case PlayerKind::Scan: {
+        // Worst case: the match is the last segment.
+        unsigned segments = n > 1 ? static_cast<unsigned>(n - 1) : 0;
+        cost.segmentSteps = segments;
+        cost.flashReads = 1 + 2 * segments + (segments ? 3 : 0);
+        cost.divisions = 2 + (segments ? 1 : 0);
+        cost.floatOps = 2 * segments + (segments ? 5 : 0);
+        cost.cycles += CYCLES_PGM_DWORD + CYCLES_FLOAT_CONVERT + CYCLES_FLOAT_DIV + CYCLES_FMOD +
+                       segments * (2 * CYCLES_PGM_DWORD + 2 * CYCLES_FLOAT_CMP + CYCLES_STEP) + CYCLES_FLOAT_CONVERT;
+        if (segments) {
+            cost.cycles += 3 * CYCLES_PGM_BYTE + 3 * CYCLES_FLOAT_CONVERT + 3 * CYCLES_FLOAT_ADD +
+                           CYCLES_FLOAT_DIV + CYCLES_FLOAT_MUL;
+        }
+        break;
+    }
+    case PlayerKind::Cursor:
+    case PlayerKind::FixedPoint: {
+        bool fixed = options.player == PlayerKind::FixedPoint;
+        unsigned stepReads = 2;
+        uint32_t stepCycles = CYCLES_STEP;
+        switch (cost.encoding) {
+        case TableEncoding::Plain:
+            stepReads = fixed ? 3 : 2;
+            stepCycles += timeRead + CYCLES_PGM_BYTE + (fixed ? CYCLES_PGM_DWORD : 0);
+            break;
+        case TableEncoding::Delta8:
+        case TableEncoding::Delta16:
+            stepCycles += (cost.encoding == TableEncoding::Delta8 ? CYCLES_PGM_BYTE : CYCLES_PGM_WORD) +
+                          CYCLES_PGM_BYTE + CYCLES_STEP;
+            break;
+        default: {
+            size_t record = n >= 2 ? encodeStream(curve, cost.encoding).maxRecord : 0;
+            stepReads = static_cast<unsigned>(record);
+            stepCycles += static_cast<uint32_t>(record) * (CYCLES_PGM_BYTE + 2 * CYCLES_STEP) + 2 * CYCLES_STEP;
+            break;
+        }
+        }
+        // Without a slope table, every segment entered costs the fixed-point player a division.
+        bool slopePerStep = fixed && cost.encoding != TableEncoding::Plain;
+        if (slopePerStep) stepCycles += CYCLES_LONG_DIV + CYCLES_STEP;
+
+        // A wrap reloads the first segment on top of the steps taken in this tick.
+        cost.segmentSteps = maxSegmentSteps(curve, options.tickMs) + 1;
+        cost.flashReads = cost.segmentSteps * stepReads + (cost.encoding == TableEncoding::Plain ? 2 + fixed : 0);
+        cost.multiplies = 1;
+        cost.divisions = (fixed ? 0 : 1) + (slopePerStep ? cost.segmentSteps : 0);
+        cost.cycles += cost.segmentSteps * stepCycles + timeRead + CYCLES_LONG_MUL +
+                       (fixed ? 0 : CYCLES_LONG_DIV) + 4 * CYCLES_STEP;
+        break;
+    }
+    case PlayerKind::Lookup:
+        cost.flashReads = 1;
+        cost.cycles += CYCLES_PGM_BYTE + 4 * CYCLES_STEP;
+        break;
+    }
+    return cost;
+}
+
+std::vector<EncodingSize> measureEncodings(const std::vector<DataPoint>& points, const CodeOptions& options) {
+    return measureAll(quantize(points), options);
+}
+
+TableEncoding resolveEncoding(const std::vector<DataPoint>& points, const CodeOptions& options) {
+    return resolve(measureEncodings(points, options), options.encoding);
+}
+
+const char* playerName(PlayerKind player) {
+    switch (player) {
+    case PlayerKind::Scan: return "scan";
+    case PlayerKind::Cursor: return "cursor";
+    case PlayerKind::FixedPoint: return "fixed";
+    case PlayerKind::Lookup: return "lookup";
+    }
+    return "scan";
+}
+
+bool parsePlayerKind(const std::string& name, PlayerKind& player) {
+    for (PlayerKind kind : {PlayerKind::Scan, PlayerKind::Cursor, PlayerKind::FixedPoint, PlayerKind::Lookup}) {
+        if (name == playerName(kind)) {
+            player = kind;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* encodingName(TableEncoding encoding) {
+    switch (encoding) {
+    case TableEncoding::Auto: return "auto";
+    case TableEncoding::Plain: return "plain";
+    case TableEncoding::Delta8: return "delta8";
+    case TableEncoding::Delta16: return "delta16";
+    case TableEncoding::Varint: return "varint";
+    case TableEncoding::Nibble: return "nibble";
+    case TableEncoding::Rle: return "rle";
+    }
+    return "plain";
+}
+
+bool parseTableEncoding(const std::string& name, TableEncoding& encoding) {
+    for (int e = static_cast<int>(TableEncoding::Auto); e <= static_cast<int>(TableEncoding::Rle); ++e) {
+        if (name == encodingName(static_cast<TableEncoding>(e))) {
+            encoding = static_cast<TableEncoding>(e);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string symbolPrefixFor(const std::string& name) {
+    std::string prefix;
+    for (char c : name) {
+        prefix += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+    if (prefix.empty() || std::isdigit(static_cast<unsigned char>(prefix[0]))) prefix.insert(0, "curve_");
+    return prefix + "_";
+}
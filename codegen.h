@@ -0,0 +1,88 @@
+#pragma once
+
+#include "curve.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum class CodeFormat {
+    Sketch,  // complete .ino with setup() and the playback loop()
+    Header,  // data tables only, for inclusion in an existing sketch
+};
+
+// How the generated loop() finds the output value for the current time.
+enum class PlayerKind {
+    Scan,        // float times, linear search from the first segment on every tick
+    Cursor,      // integer ms times and a segment cursor that only moves forward
+    FixedPoint,  // cursor with precomputed Q16 slopes, so no division per tick
+    Lookup,      // curve resampled every 2^lookupShift ms, indexed directly by time
+};
+
+// Layout of the curve tables. Only the cursor players can decode the delta and stream
+// encodings, because those are read sequentially.
+enum class TableEncoding {
+    Auto,     // smallest encoding the player supports
+    Plain,    // absolute times and values
+    Delta8,   // uint8_t millisecond steps between points
+    Delta16,  // uint16_t millisecond steps
+    Varint,   // byte stream: LEB128 time step, then the value
+    Nibble,   // byte stream: small steps packed as 4-bit time and value deltas, else escaped
+    Rle,      // byte stream: runs of identical time and value deltas (holds, ramps, regular sampling)
+};
+
+struct CodeOptions {
+    CodeFormat format = CodeFormat::Sketch;
+    std::string symbolPrefix;  // prepended to every emitted name in headers
+    PlayerKind player = PlayerKind::Scan;
+    unsigned tickMs = 10;      // delay between updates; 0 updates as fast as loop() runs
+    unsigned lookupShift = 3;  // Lookup table step is 1 << lookupShift ms
+    TableEncoding encoding = TableEncoding::Auto;
+};
+
+struct EncodingSize {
+    TableEncoding encoding;
+    bool available = false;    // the player can decode it and every step fits
+    size_t bytes = 0;          // all curve tables together
+    size_t largestArray = 0;   // biggest single PROGMEM array
+};
+
+// Worst-case work of one loop() tick for a given curve and player.
+struct PlayerCost {
+    unsigned flashReads = 0;      // pgm_read_* calls
+    unsigned floatOps = 0;        // float add, multiply and compare
+    unsigned divisions = 0;       // float or 32-bit integer division and modulo
+    unsigned multiplies = 0;      // 32-bit integer multiplies
+    unsigned segmentSteps = 0;    // segments visited while searching
+    uint32_t cycles = 0;          // estimated ATmega328P cycles
+    TableEncoding encoding = TableEncoding::Plain;  // after resolving Auto
+    size_t flashBytes = 0;        // size of the curve tables
+    size_t largestArray = 0;      // biggest single table
+};
+
+// Writes the (already simplified) curve as PROGMEM tables for an Arduino.
+void writeArduinoCode(std::ostream& out, const std::vector<DataPoint>& points, const CodeOptions& options = {});
+
+// The quantization of every generated table: duty in percent to a PWM count of 0-255, seconds
+// to whole milliseconds.
+int toPwm(float duty);
+uint32_t toMs(float seconds);
+
+// Cycle figures use approximate avr-libc costs per operation, not a cycle-accurate model.
+PlayerCost estimatePlayerCost(const std::vector<DataPoint>& points, const CodeOptions& options);
+
+// Sizes of every concrete encoding (Plain through Rle) for the options' player.
+std::vector<EncodingSize> measureEncodings(const std::vector<DataPoint>& points, const CodeOptions& options);
+
+// Auto becomes the smallest available encoding; an unavailable choice falls back to Plain.
+TableEncoding resolveEncoding(const std::vector<DataPoint>& points, const CodeOptions& options);
+
+const char* playerName(PlayerKind player);
+bool parsePlayerKind(const std::string& name, PlayerKind& player);
+const char* encodingName(TableEncoding encoding);
+bool parseTableEncoding(const std::string& name, TableEncoding& encoding);
+
+// Turns an arbitrary file stem into a valid C identifier prefix, e.g. "motor-3" -> "motor_3_".
+std::string symbolPrefixFor(const std::string& name);
@@ -0,0 +1,86 @@
+#include "curve.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+size_t CurveView::lowerBound(float t, size_t first, size_t last) const {
+    while (first < last) {
+        size_t mid = first + (last - first) / 2;
+        if (x(mid) < t) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+size_t CurveView::upperBound(float t, size_t first, size_t last) const {
+    while (first < last) {
+        size_t mid = first + (last - first) / 2;
+        if (!(t < x(mid))) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+CurveLine parseCurveLine(const char* line, DataPoint& point) {
+    const char* s = line;
+    while (*s == ' ' || *s == '\t' || *s == '\r') ++s;
+    if (*s == '\0' || *s == '#') return CurveLine::Blank;
+
+    char* end = nullptr;
+    float x = std::strtof(s, &end);
+    if (end == s) return CurveLine::Invalid;
+    while (*end == ' ' || *end == '\t') ++end;
+    if (*end != ',' && *end != ';') return CurveLine::Invalid;
+    s = end + 1;
+    float y = std::strtof(s, &end);
+    if (end == s) return CurveLine::Invalid;
+    point = {x, y};
+    return CurveLine::Sample;
+}
+
+bool loadCurveCsv(const std::string& path, std::vector<DataPoint>& points, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    points.clear();
+    std::string line;
+    size_t lineNo = 0;
+    while (std::getline(file, line)) {
+        ++lineNo;
+        DataPoint point;
+        CurveLine kind = parseCurveLine(line.c_str(), point);
+        if (kind == CurveLine::Blank) continue;
+        if (kind == CurveLine::Invalid) {
+            if (points.empty() && lineNo == 1) continue;  // column header
+            error = path + ":" + std::to_string(lineNo) + ": expected \"time,duty\"";
+            return false;
+        }
+        points.push_back(point);
+    }
+
+    if (!std::is_sorted(points.begin(), points.end())) {
+        std::stable_sort(points.begin(), points.end());
+    }
+    return true;
+}
+
+bool saveCurveCsv(const std::string& path, const std::vector<DataPoint>& points) {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+    file.precision(9);
+    file << "time,duty\n";
+    for (const auto& p : points) {
+        file << p.x << "," << p.y << "\n";
+    }
+    return static_cast<bool>(file);
+}
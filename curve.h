@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct DataPoint {
+    float x, y;
+    bool operator<(const DataPoint& other) const { return x < other.x; }
+    bool operator==(const DataPoint& other) const { return x == other.x && y == other.y; }
+};
+
+// Read-only view of a time-sorted curve. It reads either a DataPoint array or separate time
+// and duty arrays in place, so code that only scans the curve takes both without copying.
+struct CurveView {
+    const float* xs = nullptr;
+    const float* ys = nullptr;
+    size_t count = 0;
+    size_t stride = 1;  // floats between consecutive points
+
+    CurveView() = default;
+    CurveView(const float* xs, const float* ys, size_t count, size_t stride = 1)
+        : xs(xs), ys(ys), count(count), stride(stride) {}
+    // An empty vector's data() may be null, which must not be dereferenced even for an address.
+    CurveView(const DataPoint* points, size_t count)
+        : xs(points ? &points->x : nullptr), ys(points ? &points->y : nullptr), count(count),
+          stride(sizeof(DataPoint) / sizeof(float)) {}
+    CurveView(const std::vector<DataPoint>& points) : CurveView(points.data(), points.size()) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    float x(size_t i) const { return xs[i * stride]; }
+    float y(size_t i) const { return ys[i * stride]; }
+    DataPoint operator[](size_t i) const { return {x(i), y(i)}; }
+    DataPoint back() const { return (*this)[count - 1]; }
+
+    // First index in [first, last) whose time is not before (lowerBound) or is after
+    // (upperBound) `t`; `last` if there is none.
+    size_t lowerBound(float t) const { return lowerBound(t, 0, count); }
+    size_t lowerBound(float t, size_t first, size_t last) const;
+    size_t upperBound(float t) const { return upperBound(t, 0, count); }
+    size_t upperBound(float t, size_t first, size_t last) const;
+};
+
+static_assert(sizeof(DataPoint) == 2 * sizeof(float), "CurveView reads DataPoint arrays as strided floats");
+
+constexpr float PI = 3.14159265358979323846f;
+
+// Curve files are plain text with one "time,duty" pair per line (seconds, percent).
+// Blank lines, lines starting with '#' and a non-numeric header line are ignored.
+// Points are returned sorted by time.
+bool loadCurveCsv(const std::string& path, std::vector<DataPoint>& points, std::string& error);
+bool saveCurveCsv(const std::string& path, const std::vector<DataPoint>& points);
+
+// Classifies one line of a curve file, given NUL-terminated without its newline; for a
+// sample, `point` receives it.
+enum class CurveLine { Blank, Sample, Invalid };
+CurveLine parseCurveLine(const char* line, DataPoint& point);
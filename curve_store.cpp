@@ -0,0 +1,135 @@
+#include "curve_store.h"
+
+#include <algorithm>
+
+std::vector<DataPoint> CurveStore::toPoints() const {
+    std::vector<DataPoint> points(xs.size());
+    for (size_t i = 0; i < xs.size(); ++i) points[i] = {xs[i], ys[i]};
+    return points;
+}
+
+void CurveStore::assign(CurveView points) {
+    size_t n = points.size();
+    xs.resize(n);
+    ys.resize(n);
+    ids.resize(n);
+    slots.resize(n);
+    freeIds.clear();
+    if (points.stride == 1) {
+        std::copy(points.xs, points.xs + n, xs.begin());
+        std::copy(points.ys, points.ys + n, ys.begin());
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = points.x(i);
+            ys[i] = points.y(i);
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        ids[i] = static_cast<Id>(i);
+        slots[i] = i;
+    }
+    touch(0, n);
+}
+
+void CurveStore::clear() {
+    xs.clear();
+    ys.clear();
+    ids.clear();
+    slots.clear();
+    freeIds.clear();
+    touch(0, 0);
+}
+
+size_t CurveStore::insert(const DataPoint& point) {
+    size_t index = view().upperBound(point.x);
+    xs.insert(xs.begin() + index, point.x);
+    ys.insert(ys.begin() + index, point.y);
+    ids.insert(ids.begin() + index, acquire());
+    renumber(index, xs.size());
+    touch(index, index + 1);
+    return index;
+}
+
+void CurveStore::erase(size_t index) {
+    release(ids[index]);
+    xs.erase(xs.begin() + index);
+    ys.erase(ys.begin() + index);
+    ids.erase(ids.begin() + index);
+    renumber(index, xs.size());
+    touch(index, index);
+}
+
+void CurveStore::replace(size_t first, size_t last, const DataPoint* points, size_t count) {
+    for (size_t i = first; i < last; ++i) release(ids[i]);
+    // Points after the span only shift, and need renumbering, when the length changes.
+    size_t renumberEnd = first + count;
+    if (count != last - first) {
+        size_t keep = std::min(count, last - first);
+        xs.erase(xs.begin() + first + keep, xs.begin() + last);
+        ys.erase(ys.begin() + first + keep, ys.begin() + last);
+        ids.erase(ids.begin() + first + keep, ids.begin() + last);
+        xs.insert(xs.begin() + first + keep, count - keep, 0.0f);
+        ys.insert(ys.begin() + first + keep, count - keep, 0.0f);
+        ids.insert(ids.begin() + first + keep, count - keep, 0);
+        renumberEnd = xs.size();
+    }
+
+    for (size_t k = 0; k < count; ++k) {
+        xs[first + k] = points[k].x;
+        ys[first + k] = points[k].y;
+        ids[first + k] = acquire();
+    }
+    renumber(first, renumberEnd);
+    touch(first, first + count);
+}
+
+size_t CurveStore::move(size_t index, const DataPoint& point) {
+    xs[index] = point.x;
+    ys[index] = point.y;
+    touch(index, index + 1);
+
+    // Same place as erasing the point and inserting it again: after any equal times.
+    size_t to = index;
+    if (index > 0 && point.x < xs[index - 1]) {
+        to = view().upperBound(point.x, 0, index);
+    } else if (index + 1 < xs.size() && xs[index + 1] < point.x) {
+        to = view().upperBound(point.x, index + 1, xs.size()) - 1;
+    }
+    if (to == index) return index;
+
+    // Rotate the point into place: right by one when it moves back, left by one when forward.
+    size_t first = std::min(index, to), last = std::max(index, to) + 1;
+    size_t middle = to < index ? index : index + 1;
+    std::rotate(xs.begin() + first, xs.begin() + middle, xs.begin() + last);
+    std::rotate(ys.begin() + first, ys.begin() + middle, ys.begin() + last);
+    std::rotate(ids.begin() + first, ids.begin() + middle, ids.begin() + last);
+    renumber(first, last);
+    touch(first, last);
+    return to;
+}
+
+CurveStore::Id CurveStore::acquire() {
+    if (freeIds.empty()) {
+        slots.push_back(npos);
+        return static_cast<Id>(slots.size() - 1);
+    }
+    Id id = freeIds.back();
+    freeIds.pop_back();
+    return id;
+}
+
+void CurveStore::renumber(size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) slots[ids[i]] = i;
+}
+
+void CurveStore::touch(size_t first, size_t last) {
+    size_t tail = xs.size() - last;
+    for (Changes* span : {&changed, &unsavedChanges}) {
+        if (span->first == npos) {
+            *span = {first, tail};
+        } else {
+            span->first = std::min(span->first, first);
+            span->tail = std::min(span->tail, tail);
+        }
+    }
+}
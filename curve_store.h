@@ -0,0 +1,107 @@
+#pragma once
+
+#include "curve.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The editable curve: points sorted by time, kept as separate time and duty arrays that the
+// simplifier, the budget solver and the plot read in place through view(). Every point has an
+// id that survives edits elsewhere in the curve, so a drag can hold on to its point. The ids of
+// erased points are handed out again, so the id table stays as large as the curve has been
+// rather than growing with every edit.
+class CurveStore {
+public:
+    using Id = uint32_t;
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    CurveView view() const { return {xs.data(), ys.data(), xs.size()}; }
+    size_t size() const { return xs.size(); }
+    bool empty() const { return xs.empty(); }
+    DataPoint operator[](size_t index) const { return {xs[index], ys[index]}; }
+    std::vector<DataPoint> toPoints() const;
+
+    // Replaces the curve with `points`, which must be sorted by time. Earlier ids are dropped.
+    void assign(CurveView points);
+    void clear();
+
+    // Inserts after any points with the same time and returns the new index.
+    size_t insert(const DataPoint& point);
+    void erase(size_t index);
+    // Replaces points [first, last) with `count` points that keep the curve sorted. They get
+    // new ids.
+    void replace(size_t first, size_t last, const DataPoint* points, size_t count);
+
+    // Gives the point at `index` new coordinates and returns its new index. Only the points
+    // between the old and the new position shift, so a drag past a neighbor is O(log n).
+    size_t move(size_t index, const DataPoint& point);
+
+    // Removes every point at or after `first` for which `remove(index)` holds, in one pass that
+    // keeps the order of the rest. Returns how many were removed.
+    template <typename Pred>
+    size_t eraseIf(Pred remove, size_t first = 0);
+
+    Id id(size_t index) const { return ids[index]; }
+    // Current index of the point with `id`, or npos once it has been erased and until the id is
+    // given to a new point.
+    size_t indexOf(Id id) const { return id < slots.size() ? slots[id] : npos; }
+
+    // What changed since the last clearChanges(): the first `first` points and the last `tail`
+    // points are the same as they were then, everything in between may differ. `first` is npos
+    // when nothing was edited.
+    struct Changes {
+        size_t first = npos;
+        size_t tail = 0;
+    };
+    const Changes& changes() const { return changed; }
+    void clearChanges() { changed = {}; }
+    // The same since clearUnsaved(), for the session journal, which records edits on a schedule
+    // of its own and must also see the spans undo and redo rewrite.
+    const Changes& unsaved() const { return unsavedChanges; }
+    void clearUnsaved() { unsavedChanges = {}; }
+
+private:
+    // An unused id; its slot is set by the caller.
+    Id acquire();
+    void release(Id id) {
+        slots[id] = npos;
+        freeIds.push_back(id);
+    }
+    void renumber(size_t first, size_t last);
+    // Records that [first, last) of the curve as it now is holds edited points.
+    void touch(size_t first, size_t last);
+
+    std::vector<float> xs, ys;
+    std::vector<Id> ids;
+    std::vector<size_t> slots;  // index of each id, npos once erased
+    std::vector<Id> freeIds;    // erased ids, reused before the table grows
+    Changes changed;
+    Changes unsavedChanges;
+};
+
+template <typename Pred>
+size_t CurveStore::eraseIf(Pred remove, size_t first) {
+    size_t out = first;
+    size_t firstGap = npos, lastGap = 0;  // output positions where points went missing
+    for (size_t i = first; i < xs.size(); ++i) {
+        if (remove(i)) {
+            release(ids[i]);
+            firstGap = std::min(firstGap, out);
+            lastGap = out;
+            continue;
+        }
+        xs[out] = xs[i];
+        ys[out] = ys[i];
+        ids[out] = ids[i];
+        slots[ids[out]] = out;
+        ++out;
+    }
+    size_t removed = xs.size() - out;
+    xs.resize(out);
+    ys.resize(out);
+    ids.resize(out);
+    if (removed > 0) touch(firstGap, lastGap);
+    return removed;
+}
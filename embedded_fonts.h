@@ -0,0 +1,31 @@
+#pragma once
+
+// The UI fonts built into the editor. GCC and Clang link the files in with fonts.S; MSVC has
+// no .incbin and compiles the hex-array headers from binary_to_header.py instead.
+
+struct EmbeddedFont {
+    const unsigned char* data;
+    int size;
+};
+
+#ifdef MOTOR_CURVE_INCBIN_FONTS
+extern "C" const unsigned char NotoSansMonoCJKkr_Regular_otf[], NotoSansMonoCJKkr_Regular_otf_end[];
+extern "C" const unsigned char NotoSansMonoCJKsc_Regular_otf[], NotoSansMonoCJKsc_Regular_otf_end[];
+
+inline EmbeddedFont koreanFont() {
+    return {NotoSansMonoCJKkr_Regular_otf, static_cast<int>(NotoSansMonoCJKkr_Regular_otf_end - NotoSansMonoCJKkr_Regular_otf)};
+}
+inline EmbeddedFont chineseFont() {
+    return {NotoSansMonoCJKsc_Regular_otf, static_cast<int>(NotoSansMonoCJKsc_Regular_otf_end - NotoSansMonoCJKsc_Regular_otf)};
+}
+#else
+#include "NotoSansMonoCJKkr-Regular.h"
+#include "NotoSansMonoCJKsc-Regular.h"
+
+inline EmbeddedFont koreanFont() {
+    return {NotoSansMonoCJKkr_Regular_otf, static_cast<int>(NotoSansMonoCJKkr_Regular_otf_len)};
+}
+inline EmbeddedFont chineseFont() {
+    return {NotoSansMonoCJKsc_Regular_otf, static_cast<int>(NotoSansMonoCJKsc_Regular_otf_len)};
+}
+#endif
@@ -0,0 +1,483 @@
+#include "firmware_sim.h"
+
+#include "avr_cycles.h"
+#include "codegen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <csignal>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Included ahead of the sketch, as the Arduino IDE includes Arduino.h. Flash reads are counted
+// by width; avr/pgmspace.h and math.h resolve to this and the host's headers. Timer 1's
+// registers are macros, as in avr/io.h, and only exist when SIM_AVR_TIMERS is defined.
+const char* ARDUINO_SHIM = R"(#pragma once
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define OUTPUT 1
+#define _BV(bit) (1 << (bit))
+
+namespace sim {
+extern uint32_t reads[4];  // byte, word, dword, float
+extern uint8_t timer1[2];
+}
+
+#ifdef SIM_AVR_TIMERS
+#define COM1A1 7
+#define WGM10 0
+#define CS10 0
+#define TCCR1A (sim::timer1[0])
+#define TCCR1B (sim::timer1[1])
+#endif
+
+inline uint8_t pgm_read_byte(const void* p) { ++sim::reads[0]; uint8_t v; memcpy(&v, p, sizeof v); return v; }
+inline uint16_t pgm_read_word(const void* p) { ++sim::reads[1]; uint16_t v; memcpy(&v, p, sizeof v); return v; }
+inline uint32_t pgm_read_dword(const void* p) { ++sim::reads[2]; uint32_t v; memcpy(&v, p, sizeof v); return v; }
+inline float pgm_read_float(const void* p) { ++sim::reads[3]; float v; memcpy(&v, p, sizeof v); return v; }
+
+unsigned long millis();
+void delay(unsigned long ms);
+void pinMode(uint8_t pin, uint8_t mode);
+void analogWrite(uint8_t pin, int value);
+
+struct HardwareSerial {
+  void begin(unsigned long baud);
+  int available();
+  int read();
+  size_t write(uint8_t b);
+};
+extern HardwareSerial Serial;
+)";
+
+// Runs setup() and then loop() until the simulated time is up. Prints a write when its pin's
+// value or millisecond differs from the last one printed (the players only change their output
+// when millis() does), then a summary line.
+const char* SIM_MAIN = R"(#include <Arduino.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+void setup();
+void loop();
+
+namespace sim {
+uint8_t timer1[2];
+uint32_t reads[4];
+uint64_t micros;
+uint32_t millisCalls, writes;
+struct Write { uint64_t micros; int pin, value; };
+std::vector<Write> log;
+int lastValue[256];
+uint64_t lastMs[256];
+}
+
+unsigned long millis() { ++sim::millisCalls; return (unsigned long)(sim::micros / 1000); }
+void delay(unsigned long ms) { sim::micros += (uint64_t)ms * 1000; }
+void pinMode(uint8_t, uint8_t) {}
+void HardwareSerial::begin(unsigned long) {}
+int HardwareSerial::available() { return 0; }
+int HardwareSerial::read() { return -1; }
+size_t HardwareSerial::write(uint8_t) { return 1; }
+HardwareSerial Serial;
+void analogWrite(uint8_t pin, int value) {
+  ++sim::writes;
+  uint64_t ms = sim::micros / 1000;
+  if (sim::lastValue[pin] == value && sim::lastMs[pin] == ms) return;
+  sim::lastValue[pin] = value;
+  sim::lastMs[pin] = ms;
+  sim::log.push_back({sim::micros, pin, value});
+}
+
+int main(int argc, char** argv) {
+  uint64_t end = strtoull(argv[1], nullptr, 10) * 1000;
+  for (int& value : sim::lastValue) value = -1;
+  sim::log.reserve(1 << 16);
+  setup();
+  unsigned long long loops = 0, reads = 0;
+  unsigned maxReads = 0, maxWrites = 0, worstCycles = 0;
+  double nanos = 0;
+  while (sim::micros < end) {
+    sim::reads[0] = sim::reads[1] = sim::reads[2] = sim::reads[3] = 0;
+    sim::millisCalls = sim::writes = 0;
+    auto start = std::chrono::steady_clock::now();
+    loop();
+    nanos += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    unsigned loopReads = sim::reads[0] + sim::reads[1] + sim::reads[2] + sim::reads[3];
+    unsigned cycles = CYCLES_STEP + sim::reads[0] * CYCLES_PGM_BYTE + sim::reads[1] * CYCLES_PGM_WORD +
+                      (sim::reads[2] + sim::reads[3]) * CYCLES_PGM_DWORD + sim::millisCalls * CYCLES_MILLIS +
+                      sim::writes * CYCLES_ANALOG_WRITE;
+    sim::micros += (cycles + 15) / 16;  // 16 MHz
+    ++loops;
+    reads += loopReads;
+    if (loopReads > maxReads) maxReads = loopReads;
+    if (sim::writes > maxWrites) maxWrites = sim::writes;
+    if (cycles > worstCycles) worstCycles = cycles;
+  }
+  for (const auto& w : sim::log) std::printf("w %llu %d %d\n", (unsigned long long)w.micros, w.pin, w.value);
+  std::printf("s %llu %llu %u %u %u %.1f\n", loops, reads, maxReads, maxWrites, worstCycles, loops ? nanos / loops : 0.0);
+  return 0;
+}
+)";
+
+// Runs the sketch in real time with Serial on the master side of a new pseudo-terminal, and
+// prints the name of the slave side for the live link to open. The slave is held open and raw
+// so bytes pass unchanged between connections. Exits with the process that started it.
+const char* LIVE_MAIN = R"(#include <Arduino.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+void setup();
+void loop();
+
+namespace sim {
+uint8_t timer1[2];
+uint32_t reads[4];
+const auto start = std::chrono::steady_clock::now();
+int port = -1;
+uint8_t rx[4096];
+size_t rxHead, rxTail;
+}
+
+unsigned long millis() {
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - sim::start).count();
+}
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void pinMode(uint8_t, uint8_t) {}
+void analogWrite(uint8_t, int) {}
+
+void HardwareSerial::begin(unsigned long) {}
+int HardwareSerial::available() {
+  if (sim::rxHead == sim::rxTail) {
+    ssize_t n = ::read(sim::port, sim::rx, sizeof sim::rx);
+    sim::rxHead = 0;
+    sim::rxTail = n > 0 ? (size_t)n : 0;
+  }
+  return (int)(sim::rxTail - sim::rxHead);
+}
+int HardwareSerial::read() { return available() ? sim::rx[sim::rxHead++] : -1; }
+size_t HardwareSerial::write(uint8_t b) { return ::write(sim::port, &b, 1) == 1 ? 1 : 0; }
+HardwareSerial Serial;
+
+int main() {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) return 1;
+  const char* name = ptsname(master);
+  int slave = open(name, O_RDWR | O_NOCTTY);
+  termios mode;
+  if (slave < 0 || tcgetattr(slave, &mode) != 0) return 1;
+  cfmakeraw(&mode);
+  tcsetattr(slave, TCSANOW, &mode);
+  fcntl(master, F_SETFL, O_NONBLOCK);
+  sim::port = master;
+  std::printf("%s\n", name);
+  std::fflush(stdout);
+
+  pid_t parent = getppid();
+  setup();
+  while (getppid() == parent) {
+    loop();
+    pollfd input = {master, POLLIN, 0};
+    poll(&input, 1, 1);  // until a byte arrives or the next millisecond
+  }
+  return 0;
+}
+)";
+
+std::string quoted(const fs::path& path) {
+    return "\"" + path.string() + "\"";
+}
+
+// std::system hands the line to cmd.exe on Windows, which strips one pair of outer quotes.
+int run(const std::string& command) {
+#ifdef _WIN32
+    return std::system(("\"" + command + "\"").c_str());
+#else
+    return std::system(command.c_str());
+#endif
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream file(path);
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+// The curve's value at `t`, holding the first and last values outside it.
+float valueAt(CurveView points, float t) {
+    size_t i = points.upperBound(t);
+    if (i == 0) return points.y(0);
+    if (i == points.size()) return points.back().y;
+    DataPoint a = points[i - 1], b = points[i];
+    return b.x > a.x ? a.y + (b.y - a.y) * (t - a.x) / (b.x - a.x) : a.y;
+}
+
+// How far `duty` lies outside the range the curve covers between `from` and `to`.
+float distanceToRange(CurveView points, float from, float to, float duty) {
+    float low = std::min(valueAt(points, from), valueAt(points, to));
+    float high = std::max(valueAt(points, from), valueAt(points, to));
+    for (size_t i = points.upperBound(from); i < points.size() && points.x(i) < to; ++i) {
+        low = std::min(low, points.y(i));
+        high = std::max(high, points.y(i));
+    }
+    low = std::clamp(low, 0.0f, 100.0f);
+    high = std::clamp(high, 0.0f, 100.0f);
+    return std::max({0.0f, low - duty, duty - high});
+}
+
+bool compare(const std::string& output, const std::vector<Channel>& channels, uint32_t periodMs, SimReport& report,
+             std::string& error) {
+    std::vector<double> lastWrite(channels.size(), 0.0);
+    double sumSquares = 0;
+    std::istringstream lines(output);
+    std::string tag;
+    bool summary = false;
+    while (lines >> tag) {
+        if (tag == "s") {
+            unsigned long long loops = 0, reads = 0;
+            lines >> loops >> reads >> report.maxFlashReads >> report.maxWrites >> report.worstCycles >> report.nanosPerLoop;
+            report.loops = loops;
+            report.flashReadsPerLoop = loops ? static_cast<double>(reads) / loops : 0.0;
+            summary = true;
+            continue;
+        }
+        unsigned long long micros = 0;
+        int pin = 0, value = 0;
+        if (tag != "w" || !(lines >> micros >> pin >> value)) break;
+
+        auto channel = std::find_if(channels.begin(), channels.end(), [pin](const Channel& c) { return c.pin == pin; });
+        if (channel == channels.end()) {
+            error = "the sketch writes pin " + std::to_string(pin) + ", which no channel drives";
+            return false;
+        }
+        size_t c = static_cast<size_t>(channel - channels.begin());
+        double ms = micros / 1000.0;
+        report.longestGapMs = std::max(report.longestGapMs, static_cast<float>(ms - lastWrite[c]));
+        lastWrite[c] = ms;
+        if (channel->points.empty()) continue;
+
+        // The sketch sees whole milliseconds and wraps at periodMs. At the seam it may still play
+        // the end of the cycle (the float player wraps after it, not at it).
+        double inCycle = std::fmod(std::floor(ms), static_cast<double>(periodMs));
+        float duty = value * 100.0f / 255.0f;
+        auto distanceAt = [&](double at) {
+            return distanceToRange(channel->points, static_cast<float>((at - 0.5) / 1000.0),
+                                   static_cast<float>((at + 0.5) / 1000.0), duty);
+        };
+        float distance = distanceAt(inCycle);
+        if (inCycle == 0 && ms >= periodMs) distance = std::min(distance, distanceAt(periodMs));
+        sumSquares += static_cast<double>(distance) * distance;
+        ++report.samples;
+        if (distance > report.maxError) {
+            report.maxError = distance;
+            report.maxErrorAt = static_cast<float>(ms / 1000.0);
+            report.maxErrorPin = pin;
+        }
+    }
+    if (!summary) {
+        error = "the simulation ended without a summary";
+        return false;
+    }
+    report.rmsError = report.samples ? static_cast<float>(std::sqrt(sumSquares / report.samples)) : 0.0f;
+    return true;
+}
+
+// A fresh directory under the system's temporary one.
+bool makeWorkDir(fs::path& dir, std::string& error) {
+    static std::atomic<unsigned> runs{0};
+    std::error_code ec;
+    dir = fs::temp_directory_path(ec) /
+          ("motor_curve_sim_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_" +
+           std::to_string(runs++));
+    if (ec || !fs::create_directories(dir / "include" / "avr", ec)) {
+        error = "cannot create a directory for the simulation";
+        return false;
+    }
+    return true;
+}
+
+// Compiles `sketch` with the shims and `runtime`, which provides main(), into dir/sim.
+bool buildSketch(const std::string& sketch, const std::string& runtime, const SimOptions& options,
+                 const fs::path& dir, std::string& error) {
+    std::ofstream(dir / "include" / "Arduino.h") << ARDUINO_SHIM;
+    std::ofstream(dir / "include" / "avr" / "pgmspace.h") << "#include <Arduino.h>\n";
+    std::ofstream(dir / "sketch.cpp") << sketch;
+    std::ofstream(dir / "sim_main.cpp") << runtime;
+
+    std::string compiler = options.compiler;
+    if (compiler.empty()) compiler = std::getenv("CXX") ? std::getenv("CXX") : "c++";
+    std::string build = compiler + " -std=c++11 -O1 -w" + (options.avrTimers ? " -DSIM_AVR_TIMERS" : "") + " -I" +
+                        quoted(dir / "include") + " -include Arduino.h " +
+                        quoted(dir / "sketch.cpp") + " " + quoted(dir / "sim_main.cpp") + " -o " +
+                        quoted(dir / "sim") + " > " + quoted(dir / "build.log") + " 2>&1";
+    if (run(build) != 0) {
+        std::string log = readFile(dir / "build.log");
+        error = "the sketch does not compile with " + compiler + (log.empty() ? std::string() : ":\n" + log);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool simulateSketch(const std::string& sketch, const std::vector<Channel>& channels, const SimOptions& options,
+                    SimReport& report, std::string& error) {
+    report = SimReport();
+    uint32_t periodMs = 1;
+    for (const Channel& channel : channels) {
+        if (!channel.points.empty()) periodMs = std::max(periodMs, toMs(channel.points.back().x));
+    }
+    uint32_t durationMs = options.durationMs ? options.durationMs : 2 * periodMs;
+
+    fs::path dir;
+    if (!makeWorkDir(dir, error)) return false;
+    struct Cleanup {
+        fs::path dir;
+        ~Cleanup() {
+            std::error_code ignored;
+            fs::remove_all(dir, ignored);
+        }
+    } cleanup{dir};
+
+    std::ostringstream cycles;
+    cycles << "#define CYCLES_STEP " << CYCLES_STEP << "u\n#define CYCLES_PGM_BYTE " << CYCLES_PGM_BYTE
+           << "u\n#define CYCLES_PGM_WORD " << CYCLES_PGM_WORD << "u\n#define CYCLES_PGM_DWORD " << CYCLES_PGM_DWORD
+           << "u\n#define CYCLES_MILLIS " << CYCLES_MILLIS << "u\n#define CYCLES_ANALOG_WRITE " << CYCLES_ANALOG_WRITE
+           << "u\n";
+    if (!buildSketch(sketch, cycles.str() + SIM_MAIN, options, dir, error)) return false;
+    if (run(quoted(dir / "sim") + " " + std::to_string(durationMs) + " > " + quoted(dir / "run.out")) != 0) {
+        error = "the simulated sketch crashed";
+        return false;
+    }
+    return compare(readFile(dir / "run.out"), channels, periodMs, report, error);
+}
+
+float simulationAllowance(const std::vector<DataPoint>& simplified, const CodeOptions& options) {
+    constexpr float ROUNDING = 1.0f;
+    size_t n = simplified.size();
+    if (options.player != PlayerKind::Lookup || n < 2) return ROUNDING;
+
+    // Total variation of the curve up to each point, and up to any time: `after` counts a jump
+    // at exactly that time, as the sample taken there may already show it or not yet.
+    std::vector<double> variation(n, 0.0);
+    for (size_t i = 1; i < n; ++i) variation[i] = variation[i - 1] + std::fabs(simplified[i].y - simplified[i - 1].y);
+    auto variationAt = [&](float t, bool after) {
+        auto it = after ? std::upper_bound(simplified.begin(), simplified.end(), t,
+                                           [](float time, const DataPoint& p) { return time < p.x; })
+                        : std::lower_bound(simplified.begin(), simplified.end(), t,
+                                           [](const DataPoint& p, float time) { return p.x < time; });
+        size_t j = static_cast<size_t>(it - simplified.begin());
+        if (j == 0) return 0.0;
+        if (j == n) return variation[n - 1];
+        const DataPoint& a = simplified[j - 1];
+        const DataPoint& b = simplified[j];
+        return variation[j - 1] + std::fabs(b.y - a.y) * (t - a.x) / (b.x - a.x);
+    };
+
+    // The variation over a window is largest with one end on a breakpoint.
+    float step = static_cast<float>(1u << options.lookupShift) / 1000.0f;
+    double hold = 0;
+    for (const DataPoint& p : simplified) {
+        hold = std::max(hold, variationAt(p.x + step, true) - variationAt(p.x, false));
+        hold = std::max(hold, variationAt(p.x, true) - variationAt(p.x - step, false));
+    }
+    return ROUNDING + static_cast<float>(hold);
+}
+
+#ifdef _WIN32
+
+bool SketchStandIn::start(const std::string&, const SimOptions&, std::string& error) {
+    error = "the stand-in board needs pseudo-terminals, which Windows does not have";
+    return false;
+}
+
+void SketchStandIn::stop() {}
+
+#else
+
+bool SketchStandIn::start(const std::string& sketch, const SimOptions& options, std::string& error) {
+    stop();
+    fs::path dir;
+    if (!makeWorkDir(dir, error)) return false;
+    workDir = dir.string();
+    if (!buildSketch(sketch, LIVE_MAIN, options, dir, error)) {
+        stop();
+        return false;
+    }
+
+    int output[2];
+    if (pipe(output) != 0) {
+        error = "cannot start the stand-in";
+        stop();
+        return false;
+    }
+    std::string exe = (dir / "sim").string();
+    pid = fork();
+    if (pid == 0) {
+        dup2(output[1], STDOUT_FILENO);
+        ::close(output[0]);
+        ::close(output[1]);
+        execl(exe.c_str(), exe.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    ::close(output[1]);
+
+    // The first line is the port; the sketch prints nothing else.
+    char name[256];
+    size_t length = 0;
+    pollfd ready{output[0], POLLIN, 0};
+    while (pid > 0 && length + 1 < sizeof(name) && poll(&ready, 1, 5000) > 0) {
+        ssize_t n = ::read(output[0], name + length, 1);
+        if (n <= 0 || name[length] == '\n') break;
+        ++length;
+    }
+    ::close(output[0]);
+    portName.assign(name, length);
+    if (pid < 0 || portName.empty()) {
+        error = "the stand-in did not open a pseudo-terminal";
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void SketchStandIn::stop() {
+    if (pid > 0) {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+    pid = -1;
+    portName.clear();
+    if (!workDir.empty()) {
+        std::error_code ignored;
+        fs::remove_all(workDir, ignored);
+        workDir.clear();
+    }
+}
+
+#endif
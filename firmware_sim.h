@@ -0,0 +1,70 @@
+#pragma once
+
+#include "codegen.h"
+#include "curve.h"
+#include "multichannel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SimOptions {
+    std::string compiler;     // host C++ compiler; empty: $CXX, else c++
+    uint32_t durationMs = 0;  // simulated run; 0: two cycles of the curve, so the wrap is played
+    bool avrTimers = true;    // false: no Timer 1 registers, as on an ESP32 core
+};
+
+// What a generated sketch did when run on the host against simulated time.
+struct SimReport {
+    size_t loops = 0;           // loop() calls
+    size_t samples = 0;         // outputs compared, at most one per pin and millisecond
+    float maxError = 0;         // percent duty, output against the original curve
+    float rmsError = 0;
+    float maxErrorAt = 0;       // seconds into the run
+    int maxErrorPin = -1;
+    float longestGapMs = 0;     // longest time a pin went without analogWrite
+    double flashReadsPerLoop = 0;
+    unsigned maxFlashReads = 0;
+    unsigned maxWrites = 0;     // analogWrite calls in one loop()
+    uint32_t worstCycles = 0;   // of the most expensive loop(), counted from the shimmed calls
+    double nanosPerLoop = 0;    // on the host, shims included
+};
+
+// Compiles `sketch` (a complete sketch from writeArduinoCode or writeMultiChannelCode) with the
+// host compiler against shims for millis, delay, pgm_read_* and analogWrite, runs it, and
+// compares every output with the channel driving that pin. Simulated time moves with delay()
+// and with the cycles the shimmed calls cost at 16 MHz; arithmetic is not counted, so
+// worstCycles is a lower bound to compare with estimatePlayerCost. Outputs are compared with
+// the original curve within half a millisecond, the resolution the sketch works in. int is
+// wider on the host than on an AVR, so 16-bit overflow in a sketch does not show. Blocks for
+// the compile and run, typically a second.
+bool simulateSketch(const std::string& sketch, const std::vector<Channel>& channels, const SimOptions& options,
+                    SimReport& report, std::string& error);
+
+// How far a correct sketch of `simplified` may play from the original curve beyond the
+// simplification's own error, in percent duty: PWM quantization and the players' rounding, a
+// couple of counts, and for the Lookup player the most the curve moves within one table step,
+// since each sample is held for a step.
+float simulationAllowance(const std::vector<DataPoint>& simplified, const CodeOptions& options);
+
+// A sketch compiled for the host and run in real time, with Serial on a pseudo-terminal, in
+// place of a board: a LiveLink opened on port() talks to the sketch as it would over USB.
+// millis() is the wall clock and analogWrite does nothing. POSIX only.
+class SketchStandIn {
+public:
+    SketchStandIn() = default;
+    ~SketchStandIn() { stop(); }
+    SketchStandIn(const SketchStandIn&) = delete;
+    SketchStandIn& operator=(const SketchStandIn&) = delete;
+
+    // Compiles and starts the sketch; blocks for the compile.
+    bool start(const std::string& sketch, const SimOptions& options, std::string& error);
+    void stop();
+    const std::string& port() const { return portName; }
+
+private:
+    int pid = -1;
+    std::string portName;
+    std::string workDir;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Scratch memory for one frame. Allocations bump through one block and reset() takes all of them
+// back at once. A frame that outgrows the block gets extra blocks, and the next reset() swaps
+// them for a single block big enough for the whole frame, so after the first frames of a session
+// the editor's scratch arrays cost no heap allocation at all.
+class FrameArena {
+public:
+    explicit FrameArena(size_t bytes = 64 * 1024) : block(new unsigned char[bytes]), blockSize(bytes) {}
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Uninitialized room for `count` objects; valid until the next reset(). Only for types that
+    // need no destructor.
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+        size_t start = (used + alignof(T) - 1) / alignof(T) * alignof(T);
+        size_t bytes = count * sizeof(T);
+        if (start + bytes <= blockSize) {
+            used = start + bytes;
+            return reinterpret_cast<T*>(block.get() + start);
+        }
+        overflow.emplace_back(new unsigned char[bytes]);
+        overflowBytes += bytes;
+        return reinterpret_cast<T*>(overflow.back().get());
+    }
+
+    void reset() {
+        if (!overflow.empty()) {
+            blockSize = (used + overflowBytes) * 2;
+            block.reset(new unsigned char[blockSize]);
+            overflow.clear();
+            overflowBytes = 0;
+        }
+        used = 0;
+    }
+
+    size_t capacity() const { return blockSize; }
+
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t blockSize;
+    size_t used = 0;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+    size_t overflowBytes = 0;
+};
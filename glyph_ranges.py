@@ -0,0 +1,36 @@
+import re
+import sys
+
+# Collects the non-ASCII characters of the string literals in the given sources and writes them
+# as one UTF-8 string, for the editor to seed its glyph set with.
+
+STRING = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+
+
+def collect(paths):
+    chars = set()
+    for path in paths:
+        with open(path, encoding='utf-8') as f:
+            for literal in STRING.findall(f.read()):
+                chars.update(c for c in literal if ord(c) > 0x7E)
+    return sorted(chars)
+
+
+def write(output_file, chars):
+    data = ''.join(chars).encode('utf-8')
+    with open(output_file, 'w') as f:
+        f.write('#pragma once\n\n')
+        f.write('// Generated by glyph_ranges.py: every non-ASCII character of the UI strings.\n')
+        f.write(f'// {len(chars)} characters.\n')
+        f.write('static const char UI_GLYPHS[] =\n')
+        for i in range(0, len(data), 24):
+            chunk = ''.join(f'\\x{b:02x}' for b in data[i:i+24])
+            f.write(f'    "{chunk}"\n')
+        f.write('    "";\n')
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        print("Usage: python glyph_ranges.py <output> <source>...")
+        sys.exit(1)
+    write(sys.argv[1], collect(sys.argv[2:]))
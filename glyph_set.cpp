@@ -0,0 +1,53 @@
+#include "glyph_set.h"
+
+namespace {
+
+// Decodes one UTF-8 sequence at `s`, advancing past it. Returns 0xFFFFFFFF for a malformed one,
+// after skipping its first byte.
+uint32_t nextCodepoint(const unsigned char*& s) {
+    unsigned char lead = *s++;
+    if (lead < 0x80) return lead;
+    int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+    if (extra < 0 || lead >= 0xF8) return 0xFFFFFFFF;
+    uint32_t codepoint = lead & (0x3F >> extra);
+    for (int k = 0; k < extra; ++k) {
+        if ((s[k] & 0xC0) != 0x80) return 0xFFFFFFFF;
+        codepoint = codepoint << 6 | (s[k] & 0x3F);
+    }
+    s += extra;
+    return codepoint;
+}
+
+}  // namespace
+
+GlyphSet::GlyphSet() {
+    for (uint32_t c = 0x20; c < 0x7F; ++c) present[c] = true;
+    for (uint32_t c = 0xA0; c <= 0xFF; ++c) present[c] = true;
+    present[0xFFFD] = true;  // ImGui draws missing characters with the replacement glyph
+}
+
+bool GlyphSet::addText(const char* text) {
+    bool added = false;
+    const auto* s = reinterpret_cast<const unsigned char*>(text);
+    while (*s) {
+        uint32_t codepoint = nextCodepoint(s);
+        if (codepoint < 0x20 || codepoint >= PLANE || present[codepoint]) continue;
+        present[codepoint] = true;
+        added = true;
+    }
+    return added;
+}
+
+std::vector<uint16_t> GlyphSet::ranges() const {
+    std::vector<uint16_t> ranges;
+    for (uint32_t c = 1; c < PLANE; ++c) {
+        if (!present[c]) continue;
+        uint32_t last = c;
+        while (last + 1 < PLANE && present[last + 1]) ++last;
+        ranges.push_back(static_cast<uint16_t>(c));
+        ranges.push_back(static_cast<uint16_t>(last));
+        c = last;
+    }
+    ranges.push_back(0);
+    return ranges;
+}
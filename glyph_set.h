@@ -0,0 +1,30 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+// The characters the UI font has to draw. Rasterizing whole CJK ranges means tens of thousands
+// of glyphs for a few dozen strings, so the atlas is built from this set instead: printable
+// Latin-1, the characters of the UI strings (generated at build time), and whatever user text
+// has been shown since. Only the Basic Multilingual Plane is tracked, as ImGui's 16-bit ImWchar
+// cannot name the rest.
+class GlyphSet {
+public:
+    GlyphSet();
+
+    // Adds the characters of the UTF-8 `text`, skipping malformed bytes. Returns true when any
+    // were new, meaning the atlas has to be rebuilt to show them.
+    bool addText(const char* text);
+
+    bool contains(uint32_t codepoint) const { return codepoint < PLANE && present[codepoint]; }
+    size_t size() const { return present.count(); }
+
+    // Inclusive [first, last] pairs followed by a 0, in the layout ImFontAtlas takes as glyph
+    // ranges. The atlas keeps the pointer, so the vector must outlive the fonts built from it.
+    std::vector<uint16_t> ranges() const;
+
+private:
+    static constexpr uint32_t PLANE = 0x10000;
+    std::bitset<PLANE> present;
+};
@@ -0,0 +1,279 @@
+#include "history.h"
+
+#include <algorithm>
+#include <chrono>
+
+// Every node reports its size to the history's byte count while it is alive, so memory shared
+// between steps is counted once and freed steps stop counting.
+struct CurveHistory::Node {
+    size_t* live = nullptr;
+    size_t bytes = 0;
+
+    Node() = default;
+    Node(const Node&) = delete;
+    Node& operator=(const Node&) = delete;
+    ~Node() {
+        if (live) *live -= bytes;
+    }
+};
+
+struct CurveHistory::Chunk : Node {
+    std::vector<DataPoint> points;
+};
+
+struct CurveHistory::Page : Node {
+    std::vector<ChunkPtr> chunks;
+    size_t size = 0;  // points in all chunks
+};
+
+struct CurveHistory::Root : Node {
+    std::vector<PagePtr> pages;  // never holds an empty page
+    size_t size = 0;
+};
+
+namespace {
+
+// make_shared keeps the node and its reference counts in one block.
+constexpr size_t CONTROL_BYTES = 2 * sizeof(long);
+
+// Splits `count` items into the fewest pieces of at most `limit` and returns the size of piece
+// `k`, so pieces differ by at most one.
+size_t pieceSize(size_t count, size_t limit, size_t k) {
+    size_t pieces = (count + limit - 1) / limit;
+    return count / pieces + (k < count % pieces ? 1 : 0);
+}
+
+}  // namespace
+
+// Where a point of a snapshot lives: chunk `chunk` of page `page`, which starts at point `start`.
+struct CurveHistory::Cursor {
+    size_t page = 0;
+    size_t chunk = 0;
+    size_t start = 0;
+};
+
+CurveHistory::Cursor CurveHistory::locate(const Root& root, size_t index) {
+    Cursor at;
+    while (at.page + 1 < root.pages.size() && at.start + root.pages[at.page]->size <= index) {
+        at.start += root.pages[at.page]->size;
+        ++at.page;
+    }
+    const auto& chunks = root.pages[at.page]->chunks;
+    while (at.chunk + 1 < chunks.size() && at.start + chunks[at.chunk]->points.size() <= index) {
+        at.start += chunks[at.chunk]->points.size();
+        ++at.chunk;
+    }
+    return at;
+}
+
+template <typename Fn>
+void CurveHistory::visit(const Root& root, size_t first, size_t last, Fn&& fn) {
+    if (first >= last) return;
+    Cursor at = locate(root, first);
+    for (size_t p = at.page, c = at.chunk, start = at.start; start < last; ++p, c = 0) {
+        const auto& chunks = root.pages[p]->chunks;
+        for (; c < chunks.size() && start < last; ++c) {
+            const auto& points = chunks[c]->points;
+            size_t from = std::max(first, start) - start;
+            size_t to = std::min(last - start, points.size());
+            if (from < to) fn(points.data() + from, to - from, start + from);
+            start += points.size();
+        }
+    }
+}
+
+CurveHistory::CurveHistory(size_t maxSteps)
+    : liveBytes(std::make_unique<size_t>(0)), maxSteps(std::max<size_t>(maxSteps, 1)) {
+    steps.push_back({makeRoot({})});
+    updateStats();
+}
+
+CurveHistory::ChunkPtr CurveHistory::makeChunk(CurveView points, size_t first, size_t count) {
+    auto chunk = std::make_shared<Chunk>();
+    chunk->points.resize(count);
+    for (size_t i = 0; i < count; ++i) chunk->points[i] = points[first + i];
+    track(*chunk, sizeof(Chunk) + count * sizeof(DataPoint));
+    return chunk;
+}
+
+CurveHistory::PagePtr CurveHistory::makePage(std::vector<ChunkPtr> chunks) {
+    auto page = std::make_shared<Page>();
+    for (const auto& chunk : chunks) page->size += chunk->points.size();
+    page->chunks = std::move(chunks);
+    track(*page, sizeof(Page) + page->chunks.capacity() * sizeof(ChunkPtr));
+    return page;
+}
+
+std::shared_ptr<const CurveHistory::Root> CurveHistory::makeRoot(std::vector<PagePtr> pages) {
+    auto root = std::make_shared<Root>();
+    for (const auto& page : pages) root->size += page->size;
+    root->pages = std::move(pages);
+    track(*root, sizeof(Root) + root->pages.capacity() * sizeof(PagePtr));
+    return root;
+}
+
+void CurveHistory::track(Node& node, size_t bytes) {
+    bytes += CONTROL_BYTES;
+    node.live = liveBytes.get();
+    node.bytes = bytes;
+    *liveBytes += bytes;
+    allocated += bytes;
+}
+
+// The base with points [first, base.size - tail) replaced by [first, points.size() - tail) of
+// `points`. The chunks covering the span are cut again from `points`, and so are the pages
+// holding them; everything else is shared with the base.
+std::shared_ptr<const CurveHistory::Root> CurveHistory::snapshot(const Root& base, CurveView points, size_t first,
+                                                                  size_t tail) {
+    const auto& pages = base.pages;
+    size_t baseEnd = base.size - tail;
+    size_t newEnd = points.size() - tail;
+
+    // Whole chunks around the span: [startAt, endAt] in the base, points [spanStart, spanEnd).
+    // An insertion at the very end goes into the last chunk.
+    Cursor startAt, endAt;
+    size_t spanStart = 0, spanEnd = 0;
+    if (!pages.empty()) {
+        startAt = locate(base, std::min(first, base.size - 1));
+        endAt = baseEnd > first ? locate(base, baseEnd - 1) : startAt;
+        spanStart = startAt.start;
+        spanEnd = endAt.start + pages[endAt.page]->chunks[endAt.chunk]->points.size();
+
+        // Take in a neighbor rather than leave a sliver of a chunk behind.
+        auto chunkSize = [&](const Cursor& at) { return pages[at.page]->chunks[at.chunk]->points.size(); };
+        if (spanEnd - spanStart + newEnd - baseEnd < CHUNK_POINTS / 4) {
+            if (endAt.chunk + 1 < pages[endAt.page]->chunks.size()) {
+                ++endAt.chunk;
+                spanEnd += chunkSize(endAt);
+            } else if (endAt.page + 1 < pages.size()) {
+                endAt = {endAt.page + 1, 0, spanEnd};
+                spanEnd += chunkSize(endAt);
+            } else if (startAt.chunk > 0) {
+                --startAt.chunk;
+                spanStart -= chunkSize(startAt);
+            } else if (startAt.page > 0) {
+                --startAt.page;
+                startAt.chunk = pages[startAt.page]->chunks.size() - 1;
+                spanStart -= chunkSize(startAt);
+            }
+        }
+    }
+    size_t count = spanEnd - spanStart + newEnd - baseEnd;
+
+    std::vector<ChunkPtr> chunks;
+    size_t firstPage = startAt.page, lastPage = endAt.page;
+    if (!pages.empty()) {
+        const auto& before = pages[firstPage]->chunks;
+        chunks.assign(before.begin(), before.begin() + startAt.chunk);
+    }
+    for (size_t k = 0, at = spanStart; at < spanStart + count; ++k) {
+        size_t size = pieceSize(count, CHUNK_POINTS, k);
+        chunks.push_back(makeChunk(points, at, size));
+        at += size;
+    }
+    if (!pages.empty()) {
+        const auto& after = pages[lastPage]->chunks;
+        chunks.insert(chunks.end(), after.begin() + endAt.chunk + 1, after.end());
+
+        // Same for pages: a nearly empty one is merged with its neighbor.
+        if (chunks.size() < PAGE_CHUNKS / 4) {
+            if (lastPage + 1 < pages.size()) {
+                ++lastPage;
+                const auto& next = pages[lastPage]->chunks;
+                chunks.insert(chunks.end(), next.begin(), next.end());
+            } else if (firstPage > 0) {
+                --firstPage;
+                const auto& previous = pages[firstPage]->chunks;
+                chunks.insert(chunks.begin(), previous.begin(), previous.end());
+            }
+        }
+    }
+
+    std::vector<PagePtr> rootPages;
+    rootPages.reserve(pages.size() + chunks.size() / PAGE_CHUNKS + 1);
+    if (!pages.empty()) rootPages.assign(pages.begin(), pages.begin() + firstPage);
+    for (size_t k = 0, at = 0; at < chunks.size(); ++k) {
+        size_t size = pieceSize(chunks.size(), PAGE_CHUNKS, k);
+        rootPages.push_back(makePage({chunks.begin() + at, chunks.begin() + at + size}));
+        at += size;
+    }
+    if (!pages.empty()) rootPages.insert(rootPages.end(), pages.begin() + lastPage + 1, pages.end());
+    return makeRoot(std::move(rootPages));
+}
+
+void CurveHistory::reset(CurveStore& store) {
+    steps.clear();
+    auto empty = makeRoot({});
+    allocated = 0;
+    auto start = std::chrono::steady_clock::now();
+    steps.push_back({snapshot(*empty, store.view(), 0, 0)});
+    current.lastCommitNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    current.lastCommitBytes = allocated;
+    position = 0;
+    store.clearChanges();
+    updateStats();
+}
+
+bool CurveHistory::commit(CurveStore& store) {
+    CurveStore::Changes changes = store.changes();
+    if (changes.first == CurveStore::npos) return false;
+    store.clearChanges();
+
+    auto start = std::chrono::steady_clock::now();
+    const Root& base = *steps[position].root;
+    CurveView points = store.view();
+    size_t first = std::min({changes.first, base.size, points.size()});
+    size_t tail = std::min({changes.tail, base.size - first, points.size() - first});
+
+    // An edit that was taken back, like a point refused for not fitting, is not a step.
+    if (base.size == points.size()) {
+        bool same = true;
+        visit(base, first, base.size - tail, [&](const DataPoint* span, size_t count, size_t at) {
+            for (size_t i = 0; same && i < count; ++i) same = span[i] == points[at + i];
+        });
+        if (same) return false;
+    }
+
+    allocated = 0;
+    Step step{snapshot(base, points, first, tail), first, tail};
+    steps.erase(steps.begin() + position + 1, steps.end());
+    steps.push_back(std::move(step));
+    if (steps.size() > maxSteps) steps.pop_front();
+    position = steps.size() - 1;
+
+    current.lastCommitNanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    current.lastCommitBytes = allocated;
+    updateStats();
+    return true;
+}
+
+bool CurveHistory::undo(CurveStore& store) {
+    if (!canUndo()) return false;
+    const Step& from = steps[position];
+    --position;
+    restore(steps[position], from.first, from.tail, store);
+    return true;
+}
+
+bool CurveHistory::redo(CurveStore& store) {
+    if (!canRedo()) return false;
+    ++position;
+    restore(steps[position], steps[position].first, steps[position].tail, store);
+    return true;
+}
+
+void CurveHistory::restore(const Step& target, size_t first, size_t tail, CurveStore& store) {
+    std::vector<DataPoint> span;
+    span.reserve(target.root->size - tail - first);
+    visit(*target.root, first, target.root->size - tail,
+          [&](const DataPoint* points, size_t count, size_t) { span.insert(span.end(), points, points + count); });
+    store.replace(first, store.size() - tail, span.data(), span.size());
+    store.clearChanges();
+    updateStats();
+}
+
+void CurveHistory::updateStats() {
+    current.steps = steps.size();
+    current.position = position;
+    current.bytes = *liveBytes;
+}
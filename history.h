@@ -0,0 +1,87 @@
+#pragma once
+
+#include "curve.h"
+#include "curve_store.h"
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Undo and redo for the editor's curve. Every step is a complete snapshot, but snapshots are
+// persistent: points live in immutable chunks of at most CHUNK_POINTS, grouped into immutable
+// pages, and a step shares every chunk and page its edit did not touch with the step before.
+// Committing a drag copies one chunk, one page and the short list of pages, so thousands of
+// steps on a million-point curve cost a small multiple of the curve itself.
+class CurveHistory {
+public:
+    static constexpr size_t CHUNK_POINTS = 256;
+    static constexpr size_t PAGE_CHUNKS = 64;
+
+    struct Stats {
+        size_t steps = 0;             // snapshots held, the current one included
+        size_t position = 0;          // index of the current snapshot
+        size_t bytes = 0;             // memory of all snapshots, shared chunks counted once
+        size_t lastCommitBytes = 0;   // allocated by the latest commit
+        double lastCommitNanos = 0;   // how long the latest commit took
+    };
+
+    // Older steps are dropped once there are more than `maxSteps`.
+    explicit CurveHistory(size_t maxSteps = 5000);
+    CurveHistory(const CurveHistory&) = delete;
+    CurveHistory& operator=(const CurveHistory&) = delete;
+
+    // Forgets every step; the store's curve becomes the only one.
+    void reset(CurveStore& store);
+
+    // Saves the store's curve as a new step if it changed since the last commit, reset, undo or
+    // redo, and drops the steps that could have been redone. Returns whether a step was added.
+    bool commit(CurveStore& store);
+
+    bool canUndo() const { return position > 0; }
+    bool canRedo() const { return position + 1 < steps.size(); }
+
+    // Puts the previous or next step back into the store, rewriting only the span in which the
+    // two steps differ. The store's curve must be the current step's, so commit first.
+    bool undo(CurveStore& store);
+    bool redo(CurveStore& store);
+
+    const Stats& stats() const { return current; }
+
+private:
+    struct Node;
+    struct Chunk;
+    struct Page;
+    struct Root;
+    struct Cursor;
+    using ChunkPtr = std::shared_ptr<const Chunk>;
+    using PagePtr = std::shared_ptr<const Page>;
+
+    struct Step {
+        std::shared_ptr<const Root> root;
+        size_t first = 0;  // the span this step differs from the previous one in, as in
+        size_t tail = 0;   // CurveStore::Changes
+    };
+
+    static Cursor locate(const Root& root, size_t index);
+    // Calls fn(points, count, index) for the runs of points [first, last) of `root`.
+    template <typename Fn>
+    static void visit(const Root& root, size_t first, size_t last, Fn&& fn);
+
+    std::shared_ptr<const Root> snapshot(const Root& base, CurveView points, size_t first, size_t tail);
+    ChunkPtr makeChunk(CurveView points, size_t first, size_t count);
+    PagePtr makePage(std::vector<ChunkPtr> chunks);
+    std::shared_ptr<const Root> makeRoot(std::vector<PagePtr> pages);
+    void track(Node& node, size_t bytes);
+    void restore(const Step& target, size_t first, size_t tail, CurveStore& store);
+    void updateStats();
+
+    // Live bytes of every node, kept up to date by the nodes themselves. Declared first so it
+    // outlives the steps.
+    std::unique_ptr<size_t> liveBytes;
+    size_t maxSteps;
+    std::deque<Step> steps;
+    size_t position = 0;
+    size_t allocated = 0;  // bytes allocated by the commit in progress
+    Stats current;
+};
@@ -0,0 +1,83 @@
+#include "i18n.h"
+
+#include <cstddef>
+
+namespace {
+
+constexpr size_t LANGUAGES = static_cast<size_t>(Language::Count);
+constexpr size_t TEXTS = static_cast<size_t>(Text::Count);
+
+struct Entry {
+    Text text;
+    const char* strings[LANGUAGES];  // English, Chinese, Korean
+};
+
+constexpr Entry TABLE[] = {
+    {Text::TimeScale, {"Time Scale", "时间比例", "시간 축척"}},
+    {Text::GenerateCode, {"Generate Arduino Code", "生成Arduino代码", "아두이노 코드 생성"}},
+    {Text::ResetChart, {"Reset Chart", "重置图表", "차트 리셋"}},
+    {Text::Waveform, {"Waveform Generator", "波形生成器", "파형 생성기"}},
+    {Text::Amplitude, {"Amplitude (%)", "幅度 (%)", "진폭 (%)"}},
+    {Text::Frequency, {"Frequency (Hz)", "频率 (Hz)", "주파수 (Hz)"}},
+    {Text::Density, {"Wave Density", "波形密度", "파동 밀도"}},
+    {Text::AppendWave, {"Append to last point", "追加到最后一点", "마지막 지점에 추가"}},
+    {Text::GenerateWave, {"Generate Wave", "生成波形", "파형 생성"}},
+    {Text::FileGenerated, {"File generated: ", "文件已生成: ", "파일 생성됨: "}},
+    {Text::AlertPoints, {"Create points first!", "请先创建数据点!", "먼저 점을 생성해 주세요!"}},
+    {Text::MemoryWarning, {"Curve does not fit in the board's flash!", "曲线超出开发板Flash容量!",
+                           "커브가 보드 Flash 용량을 초과합니다!"}},
+    {Text::Ok, {"OK", "确定", "확인"}},
+    {Text::PointBudget, {"Point budget", "点数预算", "포인트 예산"}},
+    {Text::Player, {"Player", "播放方式", "재생 방식"}},
+    {Text::TickPeriod, {"Tick period", "更新周期", "갱신 주기"}},
+    {Text::Board, {"Board", "开发板", "보드"}},
+    {Text::Encoding, {"Encoding", "编码", "인코딩"}},
+    {Text::ImportTelemetry, {"Import Telemetry", "导入遥测数据", "텔레메트리 가져오기"}},
+    {Text::ImportTolerance, {"Import tolerance", "导入容差", "가져오기 허용 오차"}},
+    {Text::Import, {"Import", "导入", "가져오기"}},
+    {Text::Cancel, {"Cancel", "取消", "취소"}},
+    {Text::Shape, {"Shape", "波形", "모양"}},
+    {Text::RampFraction, {"Ramp share", "斜坡占比", "램프 비율"}},
+    {Text::EndFrequency, {"End frequency (Hz)", "终止频率 (Hz)", "종료 주파수 (Hz)"}},
+    {Text::Undo, {"Undo", "撤销", "실행 취소"}},
+    {Text::Redo, {"Redo", "重做", "다시 실행"}},
+    {Text::Channel, {"Channel", "通道", "채널"}},
+    {Text::AddChannel, {"Add", "添加", "추가"}},
+    {Text::RemoveChannel, {"Remove", "删除", "삭제"}},
+    {Text::Pin, {"Pin", "引脚", "핀"}},
+    {Text::Simulate, {"Simulate", "仿真", "시뮬레이션"}},
+    {Text::Simplifier, {"Simplifier", "简化算法", "단순화 방식"}},
+    {Text::Tolerance, {"Tolerance", "容差", "허용 오차"}},
+    {Text::LiveTuning, {"Live tuning", "实时调参", "실시간 튜닝"}},
+    {Text::Connect, {"Connect", "连接", "연결"}},
+    {Text::Disconnect, {"Disconnect", "断开", "연결 해제"}},
+    {Text::ResidentPlayer, {"Resident player in sketch", "草图内置常驻播放器", "스케치에 상주 플레이어 포함"}},
+    {Text::Session, {"Session (autosaved)", "会话（自动保存）", "세션 (자동 저장)"}},
+    {Text::OpenSession, {"Open", "打开", "열기"}},
+    {Text::SaveSession, {"Save as", "另存为", "다른 이름으로 저장"}},
+};
+
+constexpr const char* NAMES[LANGUAGES] = {"English", "中文", "한국어"};
+
+constexpr bool complete() {
+    if (sizeof(TABLE) / sizeof(TABLE[0]) != TEXTS) return false;
+    for (size_t i = 0; i < TEXTS; ++i) {
+        if (TABLE[i].text != static_cast<Text>(i)) return false;
+        for (const char* string : TABLE[i].strings) {
+            if (!string || !*string) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(complete(), "every Text needs an entry in enum order, translated into every language");
+
+}  // namespace
+
+const char* tr(Language language, Text text) {
+    return TABLE[static_cast<size_t>(text)].strings[static_cast<size_t>(language)];
+}
+
+const char* languageName(Language language) {
+    return NAMES[static_cast<size_t>(language)];
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+// The editor's languages and UI strings. Lookups index a constant table, so drawing a label costs
+// no map search and no string construction; the table is checked at compile time to have every
+// text in every language, in enum order.
+enum class Language { English, Chinese, Korean, Count };
+
+enum class Text {
+    TimeScale,
+    GenerateCode,
+    ResetChart,
+    Waveform,
+    Amplitude,
+    Frequency,
+    Density,
+    AppendWave,
+    GenerateWave,
+    FileGenerated,
+    AlertPoints,
+    MemoryWarning,
+    Ok,
+    PointBudget,
+    Player,
+    TickPeriod,
+    Board,
+    Encoding,
+    ImportTelemetry,
+    ImportTolerance,
+    Import,
+    Cancel,
+    Shape,
+    RampFraction,
+    EndFrequency,
+    Undo,
+    Redo,
+    Channel,
+    AddChannel,
+    RemoveChannel,
+    Pin,
+    Simulate,
+    Simplifier,
+    Tolerance,
+    LiveTuning,
+    Connect,
+    Disconnect,
+    ResidentPlayer,
+    Session,
+    OpenSession,
+    SaveSession,
+    Count
+};
+
+// The text in `language`; never null.
+const char* tr(Language language, Text text);
+
+// The language's own name for itself, for the language picker.
+const char* languageName(Language language);
@@ -0,0 +1,633 @@
+#include "live_link.h"
+
+#include "codegen.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint8_t FRAME_START = 0xA5;
+constexpr uint8_t REPLY_START = 0x5A;
+
+// A board answers within a few milliseconds; the first update also waits out the reset an AVR
+// board does when its port is opened.
+constexpr unsigned REPLY_TIMEOUT_MS = 500;
+constexpr unsigned FIRST_REPLY_TIMEOUT_MS = 3000;
+
+// RAM an AVR sketch needs besides the tables: the core, Serial's buffers, the frame buffer and
+// the stack. The ESP32 has far more than a player of this kind needs.
+constexpr size_t LIVE_RESERVED_RAM = 1024;
+constexpr size_t LIVE_MAX_CAPACITY = 4096;
+
+uint16_t crc16(uint16_t crc, uint8_t byte) {
+    crc ^= static_cast<uint16_t>(byte << 8);
+    for (int bit = 0; bit < 8; ++bit) crc = crc & 0x8000 ? static_cast<uint16_t>(crc << 1 ^ 0x1021) : crc << 1;
+    return crc;
+}
+
+void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putWord(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+// Fills in the length of the frame begun at `frameAt` and appends its CRC.
+void sealFrame(std::vector<uint8_t>& out, size_t frameAt) {
+    out[frameAt + 3] = static_cast<uint8_t>(out.size() - frameAt - 4);
+    uint16_t crc = 0xFFFF;
+    for (size_t i = frameAt + 1; i < out.size(); ++i) crc = crc16(crc, out[i]);
+    putWord(out, crc);
+}
+
+size_t beginFrame(std::vector<uint8_t>& out, uint8_t type, uint8_t sequence) {
+    size_t at = out.size();
+    out.insert(out.end(), {FRAME_START, type, sequence, 0});
+    return at;
+}
+
+// Patches carrying to[first, last) into the board's table from `at` on, `removed` points
+// replaced by the first. Each frame holds as many points as fit in a payload.
+void appendPatches(std::vector<uint8_t>& out, const std::vector<LivePoint>& to, size_t first, size_t last,
+                   size_t removed, uint8_t& sequence) {
+    std::vector<uint8_t> record;
+    size_t i = first;
+    do {
+        size_t frameAt = beginFrame(out, 'P', sequence++);
+        putWord(out, static_cast<uint16_t>(i));
+        putWord(out, static_cast<uint16_t>(removed));
+        removed = 0;
+        while (i < last) {
+            record.clear();
+            putVarint(record, to[i].ms - (i > 0 ? to[i - 1].ms : 0));
+            record.push_back(to[i].value);
+            if (out.size() - frameAt - 4 + record.size() > LIVE_MAX_PAYLOAD) break;
+            out.insert(out.end(), record.begin(), record.end());
+            ++i;
+        }
+        sealFrame(out, frameAt);
+    } while (i < last);
+}
+
+template <typename T>
+void writeList(std::ostream& out, const std::vector<T>& items) {
+    for (size_t i = 0; i < items.size(); ++i) {
+        out << +items[i] << (i == items.size() - 1 ? "" : ", ");
+    }
+}
+
+const char* const LIVE_PLAYER = R"(
+uint32_t pointTimes[2][CAPACITY];
+uint8_t pointValues[2][CAPACITY];
+uint16_t pointCounts[2];
+uint8_t playing;  // table the player reads; the other one takes updates
+bool staging;     // the other table holds the update being received
+bool broken;      // a frame of that update was damaged or did not fit
+uint16_t segment;
+uint32_t cycleStart, lastTick;
+
+uint8_t frame[3 + MAX_PAYLOAD + 2];  // type, sequence, length, payload, CRC
+uint16_t frameLength;
+bool inFrame;
+
+uint16_t crc16(uint16_t crc, uint8_t b) {
+  crc ^= (uint16_t)b << 8;
+  for (uint8_t i = 0; i < 8; i++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  return crc;
+}
+
+// Replaces `removed` staged points from `at` on with the points of the payload.
+bool patch(const uint8_t* data, uint8_t length) {
+  uint8_t s = playing ^ 1;
+  if (!staging) {
+    pointCounts[s] = pointCounts[playing];
+    memcpy(pointTimes[s], pointTimes[playing], pointCounts[s] * sizeof(uint32_t));
+    memcpy(pointValues[s], pointValues[playing], pointCounts[s]);
+    staging = true;
+  }
+  if (length < 4) return false;
+  uint16_t at = data[0] | data[1] << 8;
+  uint16_t removed = data[2] | data[3] << 8;
+  uint16_t count = pointCounts[s];
+  if (at > count || removed > count - at) return false;
+
+  uint16_t added = 0;
+  uint8_t i = 4;
+  while (i < length) {
+    while (i < length && (data[i] & 0x80)) i++;
+    i += 2;
+    added++;
+  }
+  if (i != length || count - removed + added > CAPACITY) return false;
+
+  uint16_t tail = count - at - removed;
+  memmove(&pointTimes[s][at + added], &pointTimes[s][at + removed], tail * sizeof(uint32_t));
+  memmove(&pointValues[s][at + added], &pointValues[s][at + removed], tail);
+  uint32_t t = at ? pointTimes[s][at - 1] : 0;
+  i = 4;
+  for (uint16_t k = 0; k < added; k++) {
+    uint32_t step = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+    do {
+      b = data[i++];
+      step |= (uint32_t)(b & 0x7F) << shift;
+      shift += 7;
+    } while (b & 0x80);
+    t += step;
+    pointTimes[s][at + k] = t;
+    pointValues[s][at + k] = data[i++];
+  }
+  pointCounts[s] = count - removed + added;
+  return true;
+}
+
+// Swaps the staging table in if it is whole; the player picks it up on its next tick.
+bool commit(const uint8_t* data, uint8_t length) {
+  uint8_t s = playing ^ 1;
+  bool whole = staging && !broken && length == 4;
+  staging = false;
+  broken = false;
+  if (!whole) return false;
+  uint16_t count = data[0] | data[1] << 8;
+  uint16_t check = data[2] | data[3] << 8;
+  if (count == 0 || count != pointCounts[s]) return false;
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t t = pointTimes[s][i];
+    for (uint8_t b = 0; b < 4; b++) crc = crc16(crc, (uint8_t)(t >> (8 * b)));
+    crc = crc16(crc, pointValues[s][i]);
+  }
+  if (crc != check) return false;
+  playing = s;
+  segment = 0;
+  return true;
+}
+
+void handleFrame() {
+  uint8_t type = frame[0];
+  uint8_t length = frame[2];
+  const uint8_t* data = frame + 3;
+  if (type == 'R') {
+    pointCounts[playing ^ 1] = 0;
+    staging = true;
+  } else if (type == 'P') {
+    if (!patch(data, length)) broken = true;
+  } else if (type == 'C') {
+    bool swapped = commit(data, length);
+    Serial.write((uint8_t)0x5A);
+    Serial.write((uint8_t)(swapped ? 'K' : 'N'));
+    Serial.write(frame[1]);
+  }
+}
+
+void receive() {
+  while (Serial.available() > 0) {
+    uint8_t b = Serial.read();
+    if (!inFrame) {
+      inFrame = b == 0xA5;
+      frameLength = 0;
+      continue;
+    }
+    frame[frameLength++] = b;
+    if (frameLength == 3 && frame[2] > MAX_PAYLOAD) {
+      inFrame = false;
+      broken = true;
+    } else if (frameLength >= 3 && frameLength == 3 + frame[2] + 2) {
+      inFrame = false;
+      uint16_t crc = 0xFFFF;
+      for (uint16_t i = 0; i < frameLength - 2; i++) crc = crc16(crc, frame[i]);
+      if (crc == (uint16_t)(frame[frameLength - 2] | frame[frameLength - 1] << 8)) {
+        handleFrame();
+      } else {
+        broken = true;
+      }
+    }
+  }
+}
+
+void setup() {
+  Serial.begin(BAUD);
+  pinMode(PIN, OUTPUT);
+  pointCounts[0] = INITIAL_POINTS;
+  for (uint16_t i = 0; i < INITIAL_POINTS; i++) {
+    pointTimes[0][i] = pgm_read_dword(&initialTimes[i]);
+    pointValues[0][i] = pgm_read_byte(&initialValues[i]);
+  }
+  cycleStart = millis();
+}
+
+void loop() {
+  receive();
+  uint32_t now = millis();
+)";
+
+// The rest of loop(): the cursor player of codegen, on whichever table is playing.
+const char* const LIVE_PLAYER_TICK = R"(
+  const uint32_t* t = pointTimes[playing];
+  const uint8_t* v = pointValues[playing];
+  uint16_t n = pointCounts[playing];
+  if (n < 2) {
+    analogWrite(PIN, n ? v[0] : 0);
+    return;
+  }
+  uint32_t total = t[n - 1] > 0 ? t[n - 1] : 1;
+  uint32_t elapsed = now - cycleStart;
+  if (elapsed >= total) {
+    // Wrap to the start; after a long stall resynchronise instead of replaying.
+    cycleStart += total;
+    elapsed -= total;
+    if (elapsed >= total) {
+      cycleStart = now;
+      elapsed = 0;
+    }
+    segment = 0;
+  }
+  while (segment < n - 2 && elapsed >= t[segment + 1]) segment++;
+
+  int16_t outputValue = v[segment];
+  if (elapsed > t[segment]) {
+    outputValue = v[segment] + (int32_t)(v[segment + 1] - v[segment]) * (int32_t)(elapsed - t[segment]) /
+                  (int32_t)(t[segment + 1] - t[segment]);
+  }
+  analogWrite(PIN, outputValue);
+}
+)";
+
+#ifndef _WIN32
+speed_t speedFor(uint32_t baud) {
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    default: return B0;
+    }
+}
+#endif
+
+}  // namespace
+
+size_t liveCapacity(const BoardProfile& board) {
+    size_t free = board.ramBytes > LIVE_RESERVED_RAM ? board.ramBytes - LIVE_RESERVED_RAM : 0;
+    return std::min(free / (2 * (sizeof(uint32_t) + 1)), LIVE_MAX_CAPACITY);
+}
+
+void quantizeLive(const std::vector<DataPoint>& points, std::vector<LivePoint>& out) {
+    out.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        out[i] = {toMs(points[i].x), static_cast<uint8_t>(toPwm(points[i].y))};
+    }
+}
+
+uint16_t liveChecksum(const std::vector<LivePoint>& table) {
+    uint16_t crc = 0xFFFF;
+    for (const LivePoint& p : table) {
+        for (int b = 0; b < 4; ++b) crc = crc16(crc, static_cast<uint8_t>(p.ms >> (8 * b)));
+        crc = crc16(crc, p.value);
+    }
+    return crc;
+}
+
+uint8_t encodeLiveUpdate(const std::vector<LivePoint>* from, const std::vector<LivePoint>& to, uint8_t& sequence,
+                         std::vector<uint8_t>& out) {
+    if (!from) {
+        sealFrame(out, beginFrame(out, 'R', sequence++));
+        appendPatches(out, to, 0, to.size(), 0, sequence);
+    } else {
+        size_t shared = std::min(from->size(), to.size());
+        size_t head = std::mismatch(from->begin(), from->begin() + shared, to.begin()).first - from->begin();
+        size_t tail = 0;
+        while (tail < shared - head && (*from)[from->size() - 1 - tail] == to[to.size() - 1 - tail]) ++tail;
+        size_t removed = from->size() - head - tail;
+        size_t last = to.size() - tail;
+        if (removed > 0 || last > head) appendPatches(out, to, head, last, removed, sequence);
+    }
+    uint8_t commitSequence = sequence;
+    size_t frameAt = beginFrame(out, 'C', sequence++);
+    putWord(out, static_cast<uint16_t>(to.size()));
+    putWord(out, liveChecksum(to));
+    sealFrame(out, frameAt);
+    return commitSequence;
+}
+
+void writeLiveSketch(std::ostream& out, const std::vector<DataPoint>& points, const LiveOptions& options) {
+    std::vector<LivePoint> table;
+    quantizeLive(points, table);
+    std::vector<uint32_t> times;
+    std::vector<int> values;
+    for (const LivePoint& p : table) {
+        times.push_back(p.ms);
+        values.push_back(p.value);
+    }
+    size_t capacity = std::max({options.capacity, table.size(), size_t{2}});
+
+    out << "#include <avr/pgmspace.h>\n\n";
+    out << "// Player: live, " << capacity << " points in RAM (" << 2 * capacity * (sizeof(uint32_t) + 1)
+        << " bytes for two tables)\n";
+    out << "// Plays the curve from RAM and takes updates over serial from the editor's live link.\n\n";
+    out << "const uint8_t PIN = " << options.pin << ";\n";
+    out << "const uint16_t CAPACITY = " << capacity << ";\n";
+    out << "const uint32_t BAUD = " << options.baud << ";\n";
+    out << "const uint8_t MAX_PAYLOAD = " << LIVE_MAX_PAYLOAD << ";\n\n";
+    out << "// The curve at export, copied to RAM at startup\n";
+    out << "const uint16_t INITIAL_POINTS = " << table.size() << ";\n";
+    out << "const uint32_t initialTimes[] PROGMEM = {";
+    writeList(out, times);
+    out << "};\n";
+    out << "const uint8_t initialValues[] PROGMEM = {";
+    writeList(out, values);
+    out << "};\n";
+    out << LIVE_PLAYER;
+    if (options.tickMs > 0) {
+        out << "  if (now - lastTick < " << options.tickMs << ") return;\n";
+        out << "  lastTick = now;\n";
+    }
+    out << LIVE_PLAYER_TICK;
+}
+
+#ifdef _WIN32
+
+bool SerialPort::open(const std::string& name, uint32_t baud, std::string& error) {
+    close();
+    std::string path = name.rfind("\\\\.\\", 0) == 0 ? name : "\\\\.\\" + name;
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + name;
+        return false;
+    }
+    DCB dcb{};
+    dcb.DCBlength = sizeof(dcb);
+    GetCommState(h, &dcb);
+    dcb.BaudRate = baud;
+    dcb.ByteSize = 8;
+    dcb.Parity = NOPARITY;
+    dcb.StopBits = ONESTOPBIT;
+    dcb.fBinary = TRUE;
+    dcb.fOutxCtsFlow = FALSE;
+    dcb.fOutX = dcb.fInX = FALSE;
+    dcb.fDtrControl = DTR_CONTROL_ENABLE;
+    dcb.fRtsControl = RTS_CONTROL_ENABLE;
+    if (!SetCommState(h, &dcb)) {
+        CloseHandle(h);
+        error = "cannot set " + name + " to " + std::to_string(baud) + " baud";
+        return false;
+    }
+    PurgeComm(h, PURGE_RXCLEAR | PURGE_TXCLEAR);
+    handle = h;
+    return true;
+}
+
+void SerialPort::close() {
+    if (handle) CloseHandle(static_cast<HANDLE>(handle));
+    handle = nullptr;
+}
+
+bool SerialPort::isOpen() const {
+    return handle != nullptr;
+}
+
+bool SerialPort::write(const uint8_t* data, size_t size) {
+    DWORD written = 0;
+    return WriteFile(static_cast<HANDLE>(handle), data, static_cast<DWORD>(size), &written, nullptr) &&
+           written == size;
+}
+
+size_t SerialPort::read(uint8_t* data, size_t size, unsigned timeoutMs) {
+    // Return as soon as a byte is there, or after timeoutMs without one.
+    COMMTIMEOUTS timeouts{MAXDWORD, MAXDWORD, timeoutMs, 0, 0};
+    SetCommTimeouts(static_cast<HANDLE>(handle), &timeouts);
+    DWORD got = 0;
+    if (!ReadFile(static_cast<HANDLE>(handle), data, static_cast<DWORD>(size), &got, nullptr)) return 0;
+    return got;
+}
+
+#else
+
+bool SerialPort::open(const std::string& name, uint32_t baud, std::string& error) {
+    close();
+    speed_t speed = speedFor(baud);
+    if (speed == B0) {
+        error = std::to_string(baud) + " baud is not supported";
+        return false;
+    }
+    int handle = ::open(name.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    termios mode{};
+    if (handle < 0 || tcgetattr(handle, &mode) != 0) {
+        if (handle >= 0) ::close(handle);
+        error = "cannot open " + name;
+        return false;
+    }
+    cfmakeraw(&mode);
+    mode.c_cflag |= CLOCAL | CREAD;
+    mode.c_cc[VMIN] = 0;
+    mode.c_cc[VTIME] = 0;
+    cfsetispeed(&mode, speed);
+    cfsetospeed(&mode, speed);
+    if (tcsetattr(handle, TCSANOW, &mode) != 0) {
+        ::close(handle);
+        error = "cannot set " + name + " to " + std::to_string(baud) + " baud";
+        return false;
+    }
+    tcflush(handle, TCIOFLUSH);
+    fd = handle;
+    return true;
+}
+
+void SerialPort::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool SerialPort::isOpen() const {
+    return fd >= 0;
+}
+
+bool SerialPort::write(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno != EAGAIN) return false;
+            pollfd ready{fd, POLLOUT, 0};
+            if (poll(&ready, 1, static_cast<int>(REPLY_TIMEOUT_MS)) <= 0) return false;
+            continue;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+size_t SerialPort::read(uint8_t* data, size_t size, unsigned timeoutMs) {
+    pollfd ready{fd, POLLIN, 0};
+    if (poll(&ready, 1, static_cast<int>(timeoutMs)) <= 0) return 0;
+    ssize_t n = ::read(fd, data, size);
+    return n > 0 ? static_cast<size_t>(n) : 0;
+}
+
+#endif
+
+bool LiveLink::open(const std::string& name, const LiveOptions& linkOptions, std::string& failure) {
+    close();
+    if (!port.open(name, linkOptions.baud, failure)) return false;
+    portName = name;
+    options = linkOptions;
+    stopping = pending = busy = false;
+    counters = LiveStats();
+    error.clear();
+    synced = answered = false;
+    sender = std::thread([this] { run(); });
+    return true;
+}
+
+void LiveLink::close() {
+    if (!sender.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    sender.join();
+    port.close();
+}
+
+void LiveLink::submit(const std::vector<DataPoint>& points) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!pending) firstEdit = std::chrono::steady_clock::now();
+        quantizeLive(points, next);
+        pending = true;
+        ++counters.edits;
+    }
+    wake.notify_one();
+}
+
+bool LiveLink::flush(unsigned timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return settled.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return !pending && !busy; });
+}
+
+bool LiveLink::idle() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !pending && !busy;
+}
+
+LiveStats LiveLink::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void LiveLink::lastError(std::string& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    out.assign(error);
+}
+
+// A failed update is resent once, whole; if that fails too the link waits for the next edit.
+void LiveLink::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool retrying = false;
+    while (true) {
+        wake.wait(lock, [this] { return stopping || pending; });
+        if (stopping) break;
+        sending.swap(next);
+        pending = false;
+        busy = true;
+        auto edited = firstEdit;
+        lock.unlock();
+
+        size_t bytes = 0;
+        std::string failure;
+        bool confirmed = true;
+        bool unchanged = synced && sending == applied;
+        if (sending.empty()) {
+            unchanged = true;
+        } else if (sending.size() > options.capacity) {
+            failure = "the curve has " + std::to_string(sending.size()) + " points; the board holds " +
+                      std::to_string(options.capacity);
+            confirmed = false;
+        } else if (!unchanged) {
+            confirmed = transmit(sending, bytes, failure);
+        }
+        double latencyMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - edited).count();
+
+        lock.lock();
+        busy = false;
+        counters.bytesSent += bytes;
+        if (confirmed && !unchanged) {
+            applied.swap(sending);
+            ++counters.updates;
+            counters.lastBytes = bytes;
+            counters.lastLatencyMs = latencyMs;
+            counters.maxLatencyMs = std::max(counters.maxLatencyMs, latencyMs);
+            counters.totalLatencyMs += latencyMs;
+            error.clear();
+            retrying = false;
+        } else if (!confirmed) {
+            error = failure;
+            bool resend = bytes > 0 && !retrying && !pending;
+            retrying = resend;
+            if (resend) {
+                ++counters.resyncs;
+                next.swap(sending);
+                firstEdit = edited;
+                pending = true;
+            }
+        }
+        settled.notify_all();
+    }
+}
+
+bool LiveLink::transmit(const std::vector<LivePoint>& curve, size_t& bytes, std::string& failure) {
+    frames.clear();
+    uint8_t commit = encodeLiveUpdate(synced ? &applied : nullptr, curve, sequence, frames);
+    synced = false;
+    if (!port.write(frames.data(), frames.size())) {
+        failure = "cannot write to " + portName;
+        return false;
+    }
+    bytes = frames.size();
+
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(answered ? REPLY_TIMEOUT_MS : FIRST_REPLY_TIMEOUT_MS);
+    uint8_t reply[3];
+    size_t have = 0;
+    while (true) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) break;
+        uint8_t byte;
+        if (port.read(&byte, 1, static_cast<unsigned>(left.count())) == 0) continue;
+        if (have == 0 && byte != REPLY_START) continue;
+        reply[have++] = byte;
+        if (have < 3) continue;
+        have = 0;
+        if (reply[2] != commit) continue;  // the answer to an update given up on
+        answered = true;
+        if (reply[1] == 'K') {
+            synced = true;
+            return true;
+        }
+        failure = "the board rejected the update";
+        return false;
+    }
+    failure = "no answer from the board on " + portName;
+    return false;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "board.h"
+#include "curve.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Live tuning: a resident player in the sketch keeps the curve in RAM and takes updates over
+// serial, so an edit reaches the board without rebuilding and reflashing.
+//
+// Frames to the board: 0xA5, type, sequence, payload length (at most LIVE_MAX_PAYLOAD), the
+// payload, and a CRC-16/CCITT of type through payload, low byte first. Types:
+//   'R'  empties the staging table
+//   'P'  at (u16), removed (u16), then points as a LEB128 millisecond step from the point before
+//        and a PWM value: replaces `removed` staged points from `at` on
+//   'C'  count (u16), CRC-16 of the table (u16): checks the staging table and swaps it in
+// The first 'P' after a swap starts from a copy of the table being played. Only 'C' is answered,
+// with 0x5A, 'K' or 'N', sequence; a frame that arrives damaged makes the next 'C' fail.
+constexpr size_t LIVE_MAX_PAYLOAD = 128;
+
+// A point as the resident player stores it, quantized with toMs and toPwm.
+struct LivePoint {
+    uint32_t ms = 0;
+    uint8_t value = 0;
+
+    bool operator==(const LivePoint& other) const { return ms == other.ms && value == other.value; }
+};
+
+struct LiveOptions {
+    int pin = 10;
+    size_t capacity = 100;   // points the board holds, in each of its two tables
+    uint32_t baud = 115200;
+    unsigned tickMs = 10;    // between output updates; serial is read on every loop()
+};
+
+// Points of the two tables fit in the board's RAM next to the core and the frame buffer.
+size_t liveCapacity(const BoardProfile& board);
+
+void quantizeLive(const std::vector<DataPoint>& points, std::vector<LivePoint>& out);
+
+// CRC-16/CCITT of a table as the board checks it: each time as four bytes, low first, then the value.
+uint16_t liveChecksum(const std::vector<LivePoint>& table);
+
+// Appends the frames that turn the board's `from` into `to`: the span between their common
+// start and end as patches, then a commit. With `from` null the staging table is emptied and
+// `to` sent whole. Returns the sequence number of the commit.
+uint8_t encodeLiveUpdate(const std::vector<LivePoint>* from, const std::vector<LivePoint>& to, uint8_t& sequence,
+                         std::vector<uint8_t>& out);
+
+// Writes a sketch that starts with `points` and plays them from RAM with a segment cursor,
+// reading update frames between ticks. Holds at least points.size() points.
+void writeLiveSketch(std::ostream& out, const std::vector<DataPoint>& points, const LiveOptions& options = {});
+
+// A serial device set to raw 8N1, or any terminal such as a pseudo-terminal.
+class SerialPort {
+public:
+    SerialPort() = default;
+    ~SerialPort() { close(); }
+    SerialPort(const SerialPort&) = delete;
+    SerialPort& operator=(const SerialPort&) = delete;
+
+    bool open(const std::string& name, uint32_t baud, std::string& error);
+    void close();
+    bool isOpen() const;
+    bool write(const uint8_t* data, size_t size);
+    // Waits up to timeoutMs for input and returns what arrived, at most `size` bytes; 0 on timeout.
+    size_t read(uint8_t* data, size_t size, unsigned timeoutMs);
+
+private:
+#ifdef _WIN32
+    void* handle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+struct LiveStats {
+    size_t edits = 0;           // curves submitted
+    size_t updates = 0;         // swaps the board confirmed
+    size_t resyncs = 0;         // whole curves resent after a rejected or unanswered update
+    size_t bytesSent = 0;
+    size_t lastBytes = 0;       // frames of the last confirmed update
+    double lastLatencyMs = 0;   // oldest edit in the last update to the board's confirmation
+    double maxLatencyMs = 0;
+    double totalLatencyMs = 0;  // over all updates, for the mean
+};
+
+// Sends curves to a resident player from a thread of its own, so a drag never waits on the port.
+// One update is on the wire at a time; curves submitted meanwhile are merged and only the newest
+// goes next, as a patch against what the board confirmed.
+class LiveLink {
+public:
+    LiveLink() = default;
+    ~LiveLink() { close(); }
+    LiveLink(const LiveLink&) = delete;
+    LiveLink& operator=(const LiveLink&) = delete;
+
+    // Opens the port and starts the sender. The first update sends the whole curve.
+    bool open(const std::string& port, const LiveOptions& options, std::string& error);
+    void close();
+    bool isOpen() const { return sender.joinable(); }
+
+    // Queues the curve without blocking. Empty curves and curves over the capacity are not sent.
+    void submit(const std::vector<DataPoint>& points);
+
+    // Waits until nothing is queued or on the wire, at most timeoutMs; false if that ran out.
+    bool flush(unsigned timeoutMs);
+    // Whether the sender has nothing queued or on the wire.
+    bool idle() const;
+
+    LiveStats stats() const;
+    // The failure of the last update, empty once one succeeds; copied into `out` to reuse its buffer.
+    void lastError(std::string& out) const;
+
+private:
+    void run();
+    bool transmit(const std::vector<LivePoint>& curve, size_t& bytes, std::string& failure);
+
+    SerialPort port;
+    std::string portName;
+    LiveOptions options;
+    std::thread sender;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable settled;
+    bool stopping = false;
+    bool pending = false;
+    bool busy = false;
+    std::vector<LivePoint> next;                      // newest curve submitted
+    std::chrono::steady_clock::time_point firstEdit;  // oldest edit merged into `next`
+    LiveStats counters;
+    std::string error;
+
+    // Owned by the sender thread.
+    std::vector<LivePoint> sending;
+    std::vector<LivePoint> applied;  // what the board plays, once synced
+    bool synced = false;
+    bool answered = false;           // the board has confirmed an update since open
+    uint8_t sequence = 0;
+    std::vector<uint8_t> frames;
+};
@@ -0,0 +1,129 @@
+// Regression check of the live link against the live player, compiled for the host and run
+// behind a pseudo-terminal by SketchStandIn: a damaged frame must make the next commit answer
+// 'N', and LiveLink must confirm a whole curve and a one-point edit, then recover from a
+// damaged frame by resending the whole curve. POSIX only; needs the host C++ compiler.
+#include "curve.h"
+#include "firmware_sim.h"
+#include "live_link.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+size_t failures = 0;
+
+void expect(bool ok, const char* what) {
+    if (ok) return;
+    ++failures;
+    std::printf("FAIL %s\n", what);
+}
+
+// Waits for the board's three-byte answer to a commit: REPLY_START, 'K' or 'N', the sequence.
+bool readReply(SerialPort& port, uint8_t reply[3]) {
+    size_t have = 0;
+    while (have < 3) {
+        uint8_t byte;
+        if (port.read(&byte, 1, 3000) == 0) return false;
+        if (have == 0 && byte != 0x5A) continue;
+        reply[have++] = byte;
+    }
+    return true;
+}
+
+// The first frame of `frames` with one payload bit flipped, so its CRC no longer matches.
+std::vector<uint8_t> damagedFrame(const std::vector<uint8_t>& frames) {
+    size_t length = 4 + frames[3] + 2;
+    std::vector<uint8_t> frame(frames.begin(), frames.begin() + static_cast<std::ptrdiff_t>(length));
+    frame[4] ^= 1;
+    return frame;
+}
+
+}  // namespace
+
+int main() {
+    std::vector<DataPoint> curve;
+    for (int i = 0; i <= 40; ++i) {
+        float x = static_cast<float>(i) * 0.05f;
+        curve.push_back({x, 50.0f + 40.0f * std::sin(x * PI)});
+    }
+    std::vector<DataPoint> edited = curve;
+    edited[20].y = 10.0f;
+    std::vector<LivePoint> whole, patched;
+    quantizeLive(curve, whole);
+    quantizeLive(edited, patched);
+
+    LiveOptions options;
+    std::ostringstream sketch;
+    writeLiveSketch(sketch, curve, options);
+    SketchStandIn board;
+    std::string error;
+    if (!board.start(sketch.str(), {}, error)) {
+        std::printf("FAIL the stand-in board does not start: %s\n", error.c_str());
+        return 1;
+    }
+
+    // The protocol by hand: a whole curve is confirmed, an edit with a damaged patch is not.
+    {
+        SerialPort port;
+        if (!port.open(board.port(), options.baud, error)) {
+            std::printf("FAIL cannot open %s: %s\n", board.port().c_str(), error.c_str());
+            return 1;
+        }
+        uint8_t sequence = 0;
+        std::vector<uint8_t> frames;
+        uint8_t commit = encodeLiveUpdate(nullptr, whole, sequence, frames);
+        uint8_t reply[3];
+        expect(port.write(frames.data(), frames.size()) && readReply(port, reply) && reply[1] == 'K' &&
+                   reply[2] == commit, "a whole curve is confirmed with 'K'");
+
+        frames.clear();
+        commit = encodeLiveUpdate(&whole, patched, sequence, frames);
+        frames[4] ^= 1;
+        expect(port.write(frames.data(), frames.size()) && readReply(port, reply) && reply[1] == 'N' &&
+                   reply[2] == commit, "a commit after a damaged patch is answered with 'N'");
+    }
+
+    LiveLink link;
+    if (!link.open(board.port(), options, error)) {
+        std::printf("FAIL the live link does not open: %s\n", error.c_str());
+        return 1;
+    }
+    link.submit(curve);
+    expect(link.flush(5000), "the whole curve is sent");
+    link.submit(edited);
+    expect(link.flush(5000), "the one-point edit is sent");
+    LiveStats stats = link.stats();
+    expect(stats.updates == 2, "a whole curve and an edit make two updates");
+    expect(stats.resyncs == 0, "a whole curve and an edit need no resync");
+
+    // A damaged frame on the wire between updates spoils the next one, which the link then
+    // resends whole.
+    {
+        uint8_t sequence = 0;
+        std::vector<uint8_t> frames;
+        encodeLiveUpdate(&patched, whole, sequence, frames);
+        std::vector<uint8_t> damaged = damagedFrame(frames);
+        SerialPort injector;
+        expect(injector.open(board.port(), options.baud, error) && injector.write(damaged.data(), damaged.size()),
+            "the damaged frame is written");
+    }
+    link.submit(curve);
+    expect(link.flush(5000), "the update after the damaged frame is sent");
+    stats = link.stats();
+    uint8_t sequence = 0;
+    std::vector<uint8_t> wholeFrames;
+    encodeLiveUpdate(nullptr, whole, sequence, wholeFrames);
+    expect(stats.resyncs == 1, "the rejected update is resent");
+    expect(stats.updates == 3, "the resent update is confirmed");
+    expect(stats.lastBytes == wholeFrames.size(), "the resent update carries the whole curve");
+    link.lastError(error);
+    expect(error.empty(), "no error remains after the resync");
+
+    std::printf("%s\n", failures ? "live link checks failed" : "live link checks passed");
+    return failures ? 1 : 0;
+}
@@ -2,83 +2,253 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <vector>
-#include <map>
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <algorithm>
+#include <thread>
 #include <ImGuiFileDialog.h>
-#include "NotoSansMonoCJKkr-Regular.h"
-#include "NotoSansMonoCJKsc-Regular.h"
+#include "board.h"
+#include "alloc_counter.h"
+#include "budget.h"
+#include "codegen.h"
+#include "curve.h"
+#include "curve_store.h"
+#include "embedded_fonts.h"
+#include "firmware_sim.h"
+#include "frame_arena.h"
+#include "glyph_set.h"
+#include "history.h"
+#include "i18n.h"
+#include "live_link.h"
+#include "multichannel.h"
+#include "plot_geometry.h"
+#include "profiler.h"
+#include "selection.h"
+#include "session.h"
+#include "simplify.h"
+#include "telemetry.h"
+#include "thread_pool.h"
+#include "ui_glyphs.h"
+#include "waveform.h"
 
 #ifdef _WIN32
 #include <windows.h>
 #include <commdlg.h>
 #endif
 
-struct DataPoint {
-    float x, y;
-    bool operator<(const DataPoint& other) const { return x < other.x; }
-    bool operator==(const DataPoint& other) const { return x == other.x && y == other.y; }
+// Player cost and encoding sizes of the exported curve. Both quantize and encode the whole
+// simplified curve, so they are kept until the curve or the code options change.
+struct ExportCost {
+    uint64_t revision = UINT64_MAX;
+    bool budgetMode = false;
+    Simplifier simplifier = Simplifier::Rdp;
+    float tolerance = 0;
+    int pointBudget = 0;
+    PlayerKind player = PlayerKind::Scan;
+    unsigned tickMs = 0;
+    unsigned lookupShift = 0;
+    TableEncoding encoding = TableEncoding::Auto;
+
+    PlayerCost cost;
+    std::vector<EncodingSize> sizes;
 };
 
-struct AppState {
+// A curve simplified by the swing-door or Visvalingam engine, for one revision and tolerance.
+struct EngineResult {
+    uint64_t revision = UINT64_MAX;
+    Simplifier simplifier = Simplifier::Rdp;
+    float toleranceCounts = 0;
     std::vector<DataPoint> points;
+};
+
+// Shared time base plan of a rig with several channels. Planning simplifies every channel, so
+// it is kept until a curve, a pin or the code options change, and not redone during a drag.
+struct RigPlan {
+    uint64_t revision = UINT64_MAX;
+    uint64_t rigRevision = UINT64_MAX;
+    float tolerance = 0;
+    PlayerKind player = PlayerKind::Scan;
+    unsigned tickMs = 0;
+    unsigned lookupShift = 0;
+    TableEncoding encoding = TableEncoding::Auto;
+
+    ChannelPlan plan;
+};
+
+// The exported curve as the live link last sent it: its revision and the settings that shape it.
+struct LiveSync {
+    uint64_t revision = UINT64_MAX;
+    bool budgetMode = false;
+    Simplifier simplifier = Simplifier::Rdp;
+    float tolerance = 0;
+    int pointBudget = 0;
+};
+
+// A motor of the rig. The channel being edited lives in AppState::points and history; selecting
+// another one swaps them with its slot, so every edit path works on one channel unchanged.
+struct ChannelSlot {
+    int pin = 10;
+    CurveStore points;
+    std::unique_ptr<CurveHistory> history = std::make_unique<CurveHistory>();
+    uint64_t revision = 0;  // pointsRevision when the channel was parked
+    PlotGeometryCache geometry;
+};
+
+// Stage times and heap allocations per frame for the F3 overlay. Once warmed up, a frame of the
+// editor allocates nothing unless the user edits something; the overlay shows when that breaks.
+struct FrameStats {
+    bool visible = false;
+    FrameProfiler profiler;
+    std::chrono::steady_clock::time_point started;
+    AllocationTotals atStart;
+    uint64_t allocations = 0;     // by the previous frame
+    uint64_t bytes = 0;
+    uint64_t quietFrames = 0;     // frames in a row that allocated nothing
+    uint64_t drawnFrames = 0;
+    float startupMs = 0;          // launch to the end of the first frame; 0 until then
+};
+
+// Frames are drawn only when the screen may change: after input, when a popup's timer runs out,
+// while an import reports progress. Otherwise the loop sleeps in glfwWaitEvents. Input owes a
+// few frames rather than one, since ImGui settles hover state and auto-sized windows over the
+// frames that follow an event.
+struct Redraw {
+    static constexpr int AFTER_INPUT = 3;
+    int framesOwed = AFTER_INPUT;
+};
+
+struct AppState {
+    CurveStore points;
     float timeScale = 1.0f;
-    float amplitude = 50.0f;
-    float frequency = 1.0f;
-    float sineDensity = 0.02f;
-    bool appendWave = false;
-    std::string currentLang = "en";
+    WaveSettings wave;  // timeScale is taken from the chart when generating
+    Language language = Language::English;
     ImVec2 plotSize;
     ImVec2 plotMin;
     float warningTimer = 0.0f;
     float successTimer = 0.0f;
     std::string lastSavedFile;
-    float rdpEpsilon = 0.5f;
+    uint64_t pointsRevision = 0;
+
+    // Simplification of the exported curve: the engine and the vertical error it may leave, in
+    // PWM counts. RDP runs through simplifyCache, which also serves budget mode; the other
+    // engines rerun into engineResult.
+    Simplifier simplifier = Simplifier::Rdp;
+    float toleranceCounts = 1.0f;
+    SimplifyCache simplifyCache;
+    EngineResult engineResult;
+
+    // Undo history. The edits of a frame are committed as one step, a drag once it is released.
+    std::unique_ptr<CurveHistory> history = std::make_unique<CurveHistory>();
+    // The dragged point is held by id, so it is found again however the curve was edited.
+    bool dragging = false;
+    CurveStore::Id draggedId = 0;
+
+    // Point budget mode: export the lowest-error curve within pointBudget points.
+    bool budgetMode = false;
+    int pointBudget = 128;
+    ThreadPool workers;
+    BudgetSimplifier budget{&workers};
+    uint64_t budgetRevision = UINT64_MAX;
+    int budgetSolvedFor = 0;
+
+    // Playback code emitted by generateCode.
+    CodeOptions codeOptions;
+    size_t boardIndex = 0;
+
+    // Channels of the rig; the slot of activeChannel is empty while it is edited. rigRevision
+    // counts changes to the set of channels and their pins.
+    std::vector<ChannelSlot> channels = std::vector<ChannelSlot>(1);
+    size_t activeChannel = 0;
+    uint64_t rigRevision = 0;
+    RigPlan rigPlan;
+
+    // Telemetry import, run on its own thread so the editor keeps drawing. The thread owns
+    // importedPoints and importError until it sets importDone.
+    char importPath[512] = "";
+    float importTolerance = 0.2f;
+    ImportProgress importProgress;
+    std::thread importThread;
+    std::atomic<bool> importDone{false};
+    std::vector<DataPoint> importedPoints;
+    std::string importError;
+    std::chrono::steady_clock::time_point importStarted;
+
+    // Host simulation of the sketch generateCode would write, also on its own thread. The thread
+    // owns simReport and simError until it sets simDone.
+    std::thread simThread;
+    std::atomic<bool> simDone{false};
+    SimReport simReport;
+    std::string simError;
+    bool simulated = false;
+    uint64_t simRevision = 0;  // of the curve simulated; older results are not shown
+
+    // Live tuning: while connected, the exported curve of the channel being edited is streamed to
+    // a resident player on every change. With liveSketch, generateCode writes that player.
+    LiveLink live;
+#ifdef _WIN32
+    char livePort[256] = "COM3";
+#else
+    char livePort[256] = "/dev/ttyACM0";
+#endif
+    bool liveSketch = false;
+    LiveSync liveSync;
+    LiveStats liveStats;
+    std::string liveError;
+
+    // Session file, once opened or saved: the full-resolution curves and the settings. Edits
+    // since the last autosave are appended to its journal; a change to the channels or their
+    // pins rewrites it. sessionPins are the pins it holds, in channel order.
+    char sessionPath[512] = "session.mcs";
+    SessionWriter session;
+    std::string sessionError;
+    std::vector<int> sessionPins;
+    std::vector<SessionChannel> sessionChannels;  // reused by every save
+    std::chrono::steady_clock::time_point lastAutosave;
+    size_t autosaveBytes = 0;  // appended by the last autosave that wrote anything
+    double autosaveMicros = 0;
+    double sessionOpenMs = 0;
     
     // Selection system
     ImVec2 selectionStart;
     ImVec2 selectionEnd;
     bool isSelecting = false;
-    std::vector<int> selectedPoints;
-
-    std::map<std::string, std::map<std::string, std::string>> i18n = {
-        {"en", {
-            {"timeScale", "Time Scale"}, {"generateCode", "Generate Arduino Code"},
-            {"resetChart", "Reset Chart"}, {"sineWave", "Sine Wave Generator"},
-            {"amplitude", "Amplitude (%)"}, {"frequency", "Frequency (Hz)"},
-            {"density", "Wave Density"}, {"appendWave", "Append to last point"},
-            {"generateWave", "Generate Sine Wave"}, {"fileGenerated", "File generated: "},
-            {"alertPoints", "Create points first!"}, {"memoryWarning", "Too many points for Arduino memory!"},
-            {"ok", "OK"}
-        }},
-        {"zh", {
-            {"timeScale", "时间比例"}, {"generateCode", "生成Arduino代码"},
-            {"resetChart", "重置图表"}, {"sineWave", "正弦波生成器"},
-            {"amplitude", "幅度 (%)"}, {"frequency", "频率 (Hz)"},
-            {"density", "波形密度"}, {"appendWave", "追加到最后一点"},
-            {"generateWave", "生成正弦波"}, {"fileGenerated", "文件已生成: "},
-            {"alertPoints", "请先创建数据点!"}, {"memoryWarning", "点数超过Arduino内存限制!"},
-            {"ok", "确定"}
-        }},
-        {"ko", {
-            {"timeScale", "시간 축척"}, {"generateCode", "아두이노 코드 생성"},
-            {"resetChart", "차트 리셋"}, {"sineWave", "사인파 생성기"},
-            {"amplitude", "진폭 (%)"}, {"frequency", "주파수 (Hz)"},
-            {"density", "파동 밀도"}, {"appendWave", "마지막 지점에 추가"},
-            {"generateWave", "사인파 생성"}, {"fileGenerated", "파일 생성됨: "},
-            {"alertPoints", "먼저 점을 생성해 주세요!"}, {"memoryWarning", "아두이노 메모리 초과 경고!"},
-            {"ok", "확인"}
-        }}
-    };
+    PointSelection selection;
+
+    // Decimated plot geometry; it is translated to the current plot position every frame.
+    PlotGeometryCache plotGeometry;
+
+    // Scratch arrays that live for one frame.
+    FrameArena frame;
+
+    // Player cost and encoding sizes of the exported curve, for the panel below the plot.
+    ExportCost exportCost;
+
+    // Frame profile and allocation overlay, toggled with F3.
+    FrameStats frameStats;
+    Redraw redraw;
+
+    // Characters in the font atlas. User text adds to them and the atlas is rebuilt before the
+    // next frame; the atlas keeps pointing into glyphRanges.
+    GlyphSet glyphs;
+    std::vector<uint16_t> glyphRanges;
+    bool glyphsChanged = false;
 };
 
 constexpr float POINT_RADIUS = 5.0f;
 const ImU32 GRID_COLOR = IM_COL32(61, 61, 61, 255);
 const ImU32 LINE_COLOR = IM_COL32(74, 144, 226, 255);
-constexpr float PI = 3.14159265358979323846f;
-constexpr int ARDUINO_MEMORY_LIMIT = 128;
+const ImU32 PARKED_LINE_COLOR = IM_COL32(74, 144, 226, 90);
+
+// PWM pins of an Uno first, in the order new channels take them.
+constexpr int CHANNEL_PINS[] = {10, 9, 6, 5, 3, 11, 2, 4, 7, 8, 12, 13};
+constexpr size_t MAX_CHANNELS = 8;
 
 ImVec2 dataToScreen(const DataPoint& p, const AppState& state) {
     return {
@@ -94,42 +264,98 @@ DataPoint screenToData(const ImVec2& screen, const AppState& state) {
     };
 }
 
-float perpendicularDistance(const DataPoint& p, const DataPoint& a, const DataPoint& b) {
-    float dx = b.x - a.x;
-    float dy = b.y - a.y;
-    if (dx == 0 && dy == 0) return std::sqrt(std::pow(p.x - a.x, 2) + std::pow(p.y - a.y, 2));
-    float t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / (dx * dx + dy * dy);
-    t = std::max(0.0f, std::min(1.0f, t));
-    return std::sqrt(std::pow(p.x - (a.x + t * dx), 2) + std::pow(p.y - (a.y + t * dy), 2));
+PlotScale plotScale(const AppState& state) {
+    return {state.plotSize.x / state.timeScale, state.plotSize.y / 100.0f};
 }
 
-void rdpSimplify(const std::vector<DataPoint>& points, float epsilon, std::vector<DataPoint>& out) {
-    if (points.size() < 3) {
-        out = points;
-        return;
+// `points` (under `revision`) simplified with the chosen engine and tolerance. RDP is updated
+// incrementally by the cache; the other engines are linear or n log n and rerun on a change, but
+// not on every frame of a drag.
+const std::vector<DataPoint>& simplifiedWith(AppState& state, CurveView points, uint64_t revision) {
+    if (state.simplifier == Simplifier::Rdp) {
+        return state.simplifyCache.get(points, pwmCountsToPercent(state.toleranceCounts), revision,
+                                       DistanceMetric::Vertical);
+    }
+    EngineResult& cached = state.engineResult;
+    bool settings = cached.simplifier == state.simplifier && cached.toleranceCounts == state.toleranceCounts;
+    if (settings && (cached.revision == revision || (state.dragging && cached.revision != UINT64_MAX))) {
+        return cached.points;
     }
+    simplifyCurve(points, state.simplifier, state.toleranceCounts, cached.points);
+    cached.revision = revision;
+    cached.simplifier = state.simplifier;
+    cached.toleranceCounts = state.toleranceCounts;
+    return cached.points;
+}
 
-    float maxDist = 0;
-    size_t index = 0;
-    for (size_t i = 1; i < points.size() - 1; ++i) {
-        float d = perpendicularDistance(points[i], points.front(), points.back());
-        if (d > maxDist) {
-            index = i;
-            maxDist = d;
-        }
+// The curve that gets exported: simplified to the tolerance, or the best fit within the point
+// budget. Budget mode keeps the cache at epsilon 0 so its tree is the full, incrementally updated
+// hierarchy.
+const std::vector<DataPoint>& simplifiedPoints(AppState& state) {
+    ScopedTimer timer(state.frameStats.profiler, ProfileStage::Simplify);
+    if (!state.budgetMode) return simplifiedWith(state, state.points.view(), state.pointsRevision);
+    if (state.budgetRevision != state.pointsRevision || state.budgetSolvedFor != state.pointBudget) {
+        state.simplifyCache.sync(state.points.view(), 0.0f, state.pointsRevision);
+        state.budget.solve(state.points.view(), state.pointBudget, &state.simplifyCache);
+        state.budgetRevision = state.pointsRevision;
+        state.budgetSolvedFor = state.pointBudget;
     }
+    return state.budget.result().points;
+}
 
-    if (maxDist > epsilon) {
-        std::vector<DataPoint> left, right;
-        std::vector<DataPoint> leftIn(points.begin(), points.begin() + index + 1);
-        std::vector<DataPoint> rightIn(points.begin() + index, points.end());
-        rdpSimplify(leftIn, epsilon, left);
-        rdpSimplify(rightIn, epsilon, right);
-        out = left;
-        out.insert(out.end(), right.begin() + 1, right.end());
-    } else {
-        out = {points.front(), points.back()};
+const ExportCost& exportCost(AppState& state) {
+    ExportCost& cached = state.exportCost;
+    const CodeOptions& options = state.codeOptions;
+    const std::vector<DataPoint>& simplified = simplifiedPoints(state);
+    if (cached.revision == state.pointsRevision && cached.budgetMode == state.budgetMode &&
+        cached.simplifier == state.simplifier && cached.tolerance == state.toleranceCounts &&
+        cached.pointBudget == state.pointBudget &&
+        cached.player == options.player && cached.tickMs == options.tickMs &&
+        cached.lookupShift == options.lookupShift && cached.encoding == options.encoding) {
+        return cached;
     }
+    cached.revision = state.pointsRevision;
+    cached.budgetMode = state.budgetMode;
+    cached.simplifier = state.simplifier;
+    cached.tolerance = state.toleranceCounts;
+    cached.pointBudget = state.pointBudget;
+    cached.player = options.player;
+    cached.tickMs = options.tickMs;
+    cached.lookupShift = options.lookupShift;
+    cached.encoding = options.encoding;
+    cached.cost = estimatePlayerCost(simplified, options);
+    cached.sizes = measureEncodings(simplified, options);
+    return cached;
+}
+
+const ChannelPlan& rigPlan(AppState& state) {
+    RigPlan& cached = state.rigPlan;
+    const CodeOptions& options = state.codeOptions;
+    bool current = cached.revision == state.pointsRevision && cached.rigRevision == state.rigRevision &&
+        cached.tolerance == state.toleranceCounts && cached.player == options.player && cached.tickMs == options.tickMs &&
+        cached.lookupShift == options.lookupShift && cached.encoding == options.encoding;
+    if (current || (state.dragging && cached.revision != UINT64_MAX)) return cached.plan;
+    cached.revision = state.pointsRevision;
+    cached.rigRevision = state.rigRevision;
+    cached.tolerance = state.toleranceCounts;
+    cached.player = options.player;
+    cached.tickMs = options.tickMs;
+    cached.lookupShift = options.lookupShift;
+    cached.encoding = options.encoding;
+
+    std::vector<Channel> channels;
+    for (size_t c = 0; c < state.channels.size(); ++c) {
+        const ChannelSlot& slot = state.channels[c];
+        channels.push_back({slot.pin, c == state.activeChannel ? state.points.view() : slot.points.view()});
+    }
+    cached.plan = planChannels(channels, pwmCountsToPercent(state.toleranceCounts), options);
+    return cached.plan;
+}
+
+// Whether the exported tables, in the encoding generateCode would pick, fit the selected board.
+bool fitsBoard(const AppState& state, const std::vector<DataPoint>& simplified) {
+    PlayerCost cost = estimatePlayerCost(simplified, state.codeOptions);
+    return boardProfiles()[state.boardIndex].fits(cost.flashBytes, cost.largestArray);
 }
 
 void showSaveDialog(std::string& filePath) {
@@ -153,6 +379,148 @@ void showSaveDialog(std::string& filePath) {
 #endif
 }
 
+#ifdef _WIN32
+void showOpenDialog(char* filePath, size_t size) {
+    char filename[MAX_PATH] = "";
+    OPENFILENAME ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = NULL;
+    ofn.lpstrFilter = "Telemetry (*.csv;*.bin;*.raw;*.f32)\0*.csv;*.bin;*.raw;*.f32\0All Files (*.*)\0*.*\0";
+    ofn.lpstrFile = filename;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST;
+
+    if (GetOpenFileName(&ofn)) {
+        std::snprintf(filePath, size, "%s", filename);
+    }
+}
+#endif
+
+// Builds the font atlas for the glyph set: the Chinese face, with the Korean one merged in for
+// anything it lacks.
+void buildFonts(AppState& state) {
+    ImGuiIO& io = ImGui::GetIO();
+    state.glyphRanges = state.glyphs.ranges();
+    io.Fonts->Clear();
+
+    ImFontConfig fontConfig;
+    fontConfig.FontDataOwnedByAtlas = false;
+    EmbeddedFont chinese = chineseFont();
+    io.Fonts->AddFontFromMemoryTTF((void*)chinese.data, chinese.size, 16.0f, &fontConfig, state.glyphRanges.data());
+
+    fontConfig.MergeMode = true;
+    EmbeddedFont korean = koreanFont();
+    io.Fonts->AddFontFromMemoryTTF((void*)korean.data, korean.size, 16.0f, &fontConfig, state.glyphRanges.data());
+    io.Fonts->Build();
+}
+
+// Call for text that does not come from the i18n table, such as paths and error messages.
+void showsText(AppState& state, const std::string& text) {
+    if (state.glyphs.addText(text.c_str())) state.glyphsChanged = true;
+}
+
+void beginFrameStats(FrameStats& stats) {
+    stats.profiler.beginFrame();
+    stats.started = std::chrono::steady_clock::now();
+    stats.atStart = allocationTotals();
+}
+
+void endFrameStats(FrameStats& stats) {
+    AllocationTotals now = allocationTotals();
+    stats.allocations = now.count - stats.atStart.count;
+    stats.bytes = now.bytes - stats.atStart.bytes;
+    stats.quietFrames = stats.allocations ? 0 : stats.quietFrames + 1;
+    stats.profiler.add(ProfileStage::Frame,
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - stats.started).count());
+    ++stats.drawnFrames;
+}
+
+// Shows the previous frames, so the overlay's own cost is counted from the next frame on.
+void drawFrameStats(const FrameStats& stats, const ImGuiIO& io, size_t glyphs) {
+    const FrameProfiler& profiler = stats.profiler;
+    float worst = profiler.worst(ProfileStage::Frame);
+    ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - 10, 10), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    if (ImGui::Begin("Frame stats", nullptr,
+            ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoInputs)) {
+        ImGui::Text("%llu frames drawn; last %d, vsync wait excluded:",
+            static_cast<unsigned long long>(stats.drawnFrames), FrameProfiler::HISTORY);
+        ImGui::PlotLines("##frameMs", profiler.history(ProfileStage::Frame), FrameProfiler::HISTORY, profiler.oldest(),
+            nullptr, 0.0f, std::max(worst, 1.0f), ImVec2(260, 50));
+        for (int i = 0; i < FrameProfiler::STAGES; ++i) {
+            ProfileStage stage = static_cast<ProfileStage>(i);
+            ImGui::Text("%-9s %6.2f ms  avg %6.2f  worst %6.2f", profileStageName(stage), profiler.last(stage),
+                profiler.average(stage), profiler.worst(stage));
+        }
+        ImVec4 color = stats.allocations ? ImVec4(1.0f, 0.6f, 0.2f, 1.0f) : ImVec4(0.6f, 1.0f, 0.6f, 1.0f);
+        ImGui::TextColored(color, "Heap: %llu allocations, %llu bytes last frame",
+            static_cast<unsigned long long>(stats.allocations), static_cast<unsigned long long>(stats.bytes));
+        ImGui::Text("%llu frames without allocating", static_cast<unsigned long long>(stats.quietFrames));
+        ImGui::Text("First frame after %.0f ms; font atlas %dx%d, %zu characters", stats.startupMs,
+            io.Fonts->TexWidth, io.Fonts->TexHeight, glyphs);
+    }
+    ImGui::End();
+}
+
+void owe(GLFWwindow* window) {
+    static_cast<Redraw*>(glfwGetWindowUserPointer(window))->framesOwed = Redraw::AFTER_INPUT;
+}
+
+// Input of any kind owes frames. ImGui chains to these callbacks from its own.
+void installRedrawCallbacks(GLFWwindow* window, Redraw* redraw) {
+    glfwSetWindowUserPointer(window, redraw);
+    glfwSetCursorPosCallback(window, [](GLFWwindow* w, double, double) { owe(w); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int, int, int) { owe(w); });
+    glfwSetScrollCallback(window, [](GLFWwindow* w, double, double) { owe(w); });
+    glfwSetKeyCallback(window, [](GLFWwindow* w, int, int, int, int) { owe(w); });
+    glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int) { owe(w); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow* w, int) { owe(w); });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow* w, int) { owe(w); });
+    glfwSetFramebufferSizeCallback(window, [](GLFWwindow* w, int, int) { owe(w); });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) { owe(w); });
+}
+
+constexpr auto AUTOSAVE_PERIOD = std::chrono::seconds(2);
+
+// The curve of channel `index`, wherever it is kept.
+CurveStore& channelPoints(AppState& state, size_t index) {
+    return index == state.activeChannel ? state.points : state.channels[index].points;
+}
+
+const CurveStore& channelPoints(const AppState& state, size_t index) {
+    return index == state.activeChannel ? state.points : state.channels[index].points;
+}
+
+// Whether a channel has edits the session file does not have yet.
+bool sessionBehind(const AppState& state) {
+    if (!state.session.isOpen()) return false;
+    for (size_t c = 0; c < state.channels.size(); ++c) {
+        if (channelPoints(state, c).unsaved().first != CurveStore::npos) return true;
+    }
+    return false;
+}
+
+// Seconds the loop may sleep before the next frame is due, or a negative value to sleep until
+// the next event. A running popup timer wakes it when it runs out; an import in progress, the
+// live link's status and a text field's blinking cursor wake it a few times a second, and an
+// edit the session does not have yet when the autosave is due.
+double idleWait(const AppState& state, const ImGuiIO& io) {
+    if (state.redraw.framesOwed > 0) return 0.0;
+    double wait = -1.0;
+    auto until = [&](double seconds) { wait = wait < 0 ? seconds : std::min(wait, seconds); };
+    if (state.warningTimer > 0.0f) until(state.warningTimer);
+    if (state.successTimer > 0.0f) until(state.successTimer);
+    if (state.importThread.joinable()) until(0.1);
+    if (state.live.isOpen()) until(state.live.idle() ? 0.5 : 0.05);
+    if (io.WantTextInput) until(0.25);
+    if (!state.dragging && sessionBehind(state)) {
+        auto due = state.lastAutosave + AUTOSAVE_PERIOD - std::chrono::steady_clock::now();
+        until(std::max(std::chrono::duration<double>(due).count(), 0.01));
+    }
+    return wait;
+}
+
 void drawGridWithLabels(ImDrawList* draw_list, const AppState& state) {
     for (float x = 0; x <= state.timeScale; x += 0.1f) {
         ImVec2 start = {state.plotMin.x + (x / state.timeScale) * state.plotSize.x, state.plotMin.y};
@@ -161,7 +529,9 @@ void drawGridWithLabels(ImDrawList* draw_list, const AppState& state) {
 
         if (x > 0 && x < state.timeScale) {
             ImVec2 labelPos = {start.x - 10, state.plotMin.y + state.plotSize.y + 5};
-            draw_list->AddText(labelPos, IM_COL32(255, 255, 255, 255), std::to_string(x).c_str());
+            char label[32];
+            std::snprintf(label, sizeof(label), "%f", x);
+            draw_list->AddText(labelPos, IM_COL32(255, 255, 255, 255), label);
         }
     }
 
@@ -172,88 +542,97 @@ void drawGridWithLabels(ImDrawList* draw_list, const AppState& state) {
 
         if (y > 0 && y < 100) {
             ImVec2 labelPos = {state.plotMin.x - 30, start.y - 5};
-            draw_list->AddText(labelPos, IM_COL32(255, 255, 255, 255), (std::to_string(y) + "%").c_str());
+            char label[16];
+            std::snprintf(label, sizeof(label), "%d%%", y);
+            draw_list->AddText(labelPos, IM_COL32(255, 255, 255, 255), label);
         }
     }
 }
 
 void drawPlot(AppState& state) {
+    ScopedTimer timer(state.frameStats.profiler, ProfileStage::Plot);
     ImGui::BeginChild("Plot", ImVec2(-1, 400), true);
     state.plotMin = ImGui::GetCursorScreenPos();
     state.plotSize = ImGui::GetContentRegionAvail();
     ImDrawList* draw_list = ImGui::GetWindowDrawList();
 
-    drawGridWithLabels(draw_list, state);
+    {
+        ScopedTimer gridTimer(state.frameStats.profiler, ProfileStage::Grid);
+        drawGridWithLabels(draw_list, state);
+    }
+
+    PlotViewport viewport{state.plotSize.x, state.plotSize.y, state.timeScale, POINT_RADIUS};
+    for (size_t c = 0; c < state.channels.size(); ++c) {
+        ChannelSlot& slot = state.channels[c];
+        if (c == state.activeChannel || slot.points.empty()) continue;
+        slot.geometry.update(slot.points.view(), slot.revision, viewport);
+        const auto& line = slot.geometry.polyline();
+        ImVec2* screenLine = state.frame.allocate<ImVec2>(line.size());
+        for (size_t i = 0; i < line.size(); ++i) {
+            screenLine[i] = ImVec2(state.plotMin.x + line[i].x, state.plotMin.y + line[i].y);
+        }
+        draw_list->AddPolyline(screenLine, static_cast<int>(line.size()), PARKED_LINE_COLOR, false, 1.5f);
+    }
 
     if (!state.points.empty()) {
-        std::vector<ImVec2> screenPoints;
-        for (const auto& p : state.points) {
-            screenPoints.push_back(dataToScreen(p, state));
+        state.plotGeometry.update(state.points.view(), state.pointsRevision, viewport);
+
+        const auto& line = state.plotGeometry.polyline();
+        ImVec2* screenLine = state.frame.allocate<ImVec2>(line.size());
+        for (size_t i = 0; i < line.size(); ++i) {
+            screenLine[i] = ImVec2(state.plotMin.x + line[i].x, state.plotMin.y + line[i].y);
         }
+        draw_list->AddPolyline(screenLine, static_cast<int>(line.size()), LINE_COLOR, false, 2.0f);
         
-        draw_list->AddPolyline(screenPoints.data(), screenPoints.size(), 
-                             LINE_COLOR, false, 2.0f);
-        
-        for (size_t i = 0; i < state.points.size(); ++i) {
-            ImVec2 sp = dataToScreen(state.points[i], state);
-            bool isSelected = std::find(state.selectedPoints.begin(), 
-                                      state.selectedPoints.end(), i) != state.selectedPoints.end();
-            ImU32 color = isSelected ? IM_COL32(255, 255, 0, 255) : IM_COL32(255, 68, 68, 255);
+        // A handle stands for every point hidden behind it, so it shows selected if any of them is.
+        const auto& handlePositions = state.plotGeometry.handlePositions();
+        const auto& selectedHandles = state.plotGeometry.selectedHandles(state.points.view(), state.selection);
+        for (size_t h = 0; h < handlePositions.size(); ++h) {
+            ImVec2 sp(state.plotMin.x + handlePositions[h].x, state.plotMin.y + handlePositions[h].y);
+            ImU32 color = selectedHandles[h] ? IM_COL32(255, 255, 0, 255) : IM_COL32(255, 68, 68, 255);
             draw_list->AddCircleFilled(sp, POINT_RADIUS, color);
         }
     }
 
     if (ImGui::IsWindowHovered()) {
         ImVec2 mousePos = ImGui::GetMousePos();
-        static int draggedPoint = -1;
         
         // Left click handling
         if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-            float minDist = FLT_MAX;
-            for (size_t i = 0; i < state.points.size(); ++i) {
-                ImVec2 pointPos = dataToScreen(state.points[i], state);
-                float dx = mousePos.x - pointPos.x;
-                float dy = mousePos.y - pointPos.y;
-                float dist = dx*dx + dy*dy;
-                
-                if (dist < (POINT_RADIUS*2)*(POINT_RADIUS*2) && dist < minDist) {
-                    minDist = dist;
-                    draggedPoint = static_cast<int>(i);
-                }
-            }
+            int picked = pickPoint(state.points.view(), screenToData(mousePos, state), plotScale(state), POINT_RADIUS * 2);
+            state.dragging = picked != -1;
+            if (state.dragging) state.draggedId = state.points.id(static_cast<size_t>(picked));
             
-            if (draggedPoint == -1) {
+            if (!state.dragging) {
                 DataPoint newPoint = screenToData(mousePos, state);
                 newPoint.x = std::clamp(newPoint.x, 0.0f, state.timeScale);
                 newPoint.y = std::clamp(newPoint.y, 0.0f, 100.0f);
                 
-                std::vector<DataPoint> tempPoints = state.points;
-                tempPoints.push_back(newPoint);
-                std::sort(tempPoints.begin(), tempPoints.end());
+                size_t index = state.points.insert(newPoint);
+                state.simplifyCache.pointInserted(state.points.view(), index, state.pointsRevision);
+                state.selection.pointInserted(index);
                 
-                std::vector<DataPoint> simplified;
-                rdpSimplify(tempPoints, state.rdpEpsilon, simplified);
-                
-                if (simplified.size() > ARDUINO_MEMORY_LIMIT) {
+                if (!fitsBoard(state, simplifiedPoints(state))) {
+                    state.points.erase(index);
+                    state.simplifyCache.pointErased(state.points.view(), index, state.pointsRevision);
+                    state.selection.pointErased(index);
                     state.warningTimer = 2.0f;
-                    return;
                 }
-                state.points = tempPoints;
             }
         }
         
-        if (ImGui::IsMouseDragging(ImGuiMouseButton_Left) && draggedPoint != -1) {
+        size_t from = state.dragging ? state.points.indexOf(state.draggedId) : CurveStore::npos;
+        if (ImGui::IsMouseDragging(ImGuiMouseButton_Left) && from != CurveStore::npos) {
             DataPoint newPoint = screenToData(mousePos, state);
             newPoint.x = std::clamp(newPoint.x, 0.0f, state.timeScale);
             newPoint.y = std::clamp(newPoint.y, 0.0f, 100.0f);
-            state.points[draggedPoint] = newPoint;
-            std::sort(state.points.begin(), state.points.end());
-            auto it = std::find(state.points.begin(), state.points.end(), newPoint);
-            draggedPoint = static_cast<int>(std::distance(state.points.begin(), it));
+            size_t to = state.points.move(from, newPoint);
+            state.simplifyCache.pointRelocated(state.points.view(), from, to, state.pointsRevision);
+            state.selection.pointMoved(from, to);
         }
         
         if (ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
-            draggedPoint = -1;
+            state.dragging = false;
         }
         
         // Right click selection
@@ -279,13 +658,9 @@ void drawPlot(AppState& state) {
                     std::max(state.selectionStart.y, state.selectionEnd.y)
                 );
                 
-                state.selectedPoints.clear();
-                for (size_t i = 0; i < state.points.size(); ++i) {
-                    ImVec2 sp = dataToScreen(state.points[i], state);
-                    if (sp.x >= min.x && sp.x <= max.x && sp.y >= min.y && sp.y <= max.y) {
-                        state.selectedPoints.push_back(i);
-                    }
-                }
+                // Screen y grows downwards, so the box's bottom edge is the lowest duty.
+                state.selection.selectBox(state.points.view(),
+                    screenToData(ImVec2(min.x, max.y), state), screenToData(ImVec2(max.x, min.y), state));
             }
             
             // Draw selection rectangle
@@ -297,42 +672,236 @@ void drawPlot(AppState& state) {
     ImGui::EndChild();
 }
 
-void generateSineWave(AppState& state) {
-    float startX = state.appendWave && !state.points.empty() ? 
-                  state.points.back().x : 0.0f;
-    float duration = state.timeScale - startX;
-    
-    std::vector<DataPoint> newPoints;
-    for (float t = 0; t <= duration; t += state.sineDensity) {
-        float x = startX + t;
-        float y = 50.0f + state.amplitude * std::sin(2 * PI * state.frequency * t);
-        y = std::clamp(y, 0.0f, 100.0f);
-        newPoints.push_back({x, y});
+void generateWave(AppState& state) {
+    state.wave.timeScale = state.timeScale;
+    std::vector<DataPoint> tempPoints = spliceWave(state.points.view(), state.wave);
+
+    // Simplify through the cache under the next revision, so an accepted wave is already cached.
+    // A point budget bounds the points, not the bytes the player's tables take, so the budget
+    // result is checked against the board too.
+    uint64_t next = state.pointsRevision + 1;
+    const std::vector<DataPoint>* simplified = nullptr;
+    if (state.budgetMode) {
+        state.simplifyCache.sync(tempPoints, 0.0f, next);
+        simplified = &state.budget.solve(tempPoints, state.pointBudget, &state.simplifyCache).points;
+        state.budgetRevision = next;
+        state.budgetSolvedFor = state.pointBudget;
+    } else {
+        simplified = &simplifiedWith(state, tempPoints, next);
     }
-    
-    std::vector<DataPoint> tempPoints = state.points;
-    auto it = std::remove_if(tempPoints.begin(), tempPoints.end(),
-        [startX](const DataPoint& p) { return p.x >= startX; });
-    tempPoints.erase(it, tempPoints.end());
-    tempPoints.insert(tempPoints.end(), newPoints.begin(), newPoints.end());
-    std::sort(tempPoints.begin(), tempPoints.end());
-
-    std::vector<DataPoint> simplified;
-    rdpSimplify(tempPoints, state.rdpEpsilon, simplified);
-    
-    if (simplified.size() > ARDUINO_MEMORY_LIMIT) {
+    if (!fitsBoard(state, *simplified)) {
+        state.simplifyCache.invalidate();
+        state.engineResult.revision = UINT64_MAX;
+        state.budgetRevision = UINT64_MAX;
         state.warningTimer = 2.0f;
         return;
     }
-    
-    state.points = tempPoints;
+
+    // Only the replaced tail is written, so the undo step shares the kept points.
+    size_t keep = waveSpliceStart(state.points.view(), state.wave);
+    state.points.replace(keep, state.points.size(), tempPoints.data() + keep, tempPoints.size() - keep);
+    state.selection.reset(state.points.size());
+    ++state.pointsRevision;
 }
 
-void generateCode(AppState& state) {
-    if (state.points.empty()) return;
+// Steps the curve back or forward through the history. Edits not committed yet become a step
+// first, so they can be redone.
+void undoRedo(AppState& state, bool redo) {
+    if (state.dragging) return;
+    state.history->commit(state.points);
+    if (!(redo ? state.history->redo(state.points) : state.history->undo(state.points))) return;
+    state.selection.reset(state.points.size());
+    ++state.pointsRevision;
+}
+
+// Moves the edited curve and its history into the active slot and takes the curve of `index`.
+void selectChannel(AppState& state, size_t index) {
+    if (index == state.activeChannel || state.dragging) return;
+    state.history->commit(state.points);
+    ChannelSlot& parked = state.channels[state.activeChannel];
+    std::swap(state.points, parked.points);
+    std::swap(state.history, parked.history);
+    parked.revision = ++state.pointsRevision;
+
+    ChannelSlot& taken = state.channels[index];
+    std::swap(state.points, taken.points);
+    std::swap(state.history, taken.history);
+    state.activeChannel = index;
+    state.selection.reset(state.points.size());
+    state.simplifyCache.invalidate();
+    ++state.pointsRevision;
+    ++state.rigRevision;
+}
 
-    std::vector<DataPoint> simplifiedPoints;
-    rdpSimplify(state.points, state.rdpEpsilon, simplifiedPoints);
+// Adds an empty channel on the first pin no channel uses and selects it.
+void addChannel(AppState& state) {
+    if (state.channels.size() >= MAX_CHANNELS || state.dragging) return;
+    ChannelSlot slot;
+    for (int pin : CHANNEL_PINS) {
+        bool used = std::any_of(state.channels.begin(), state.channels.end(),
+                                [pin](const ChannelSlot& other) { return other.pin == pin; });
+        if (!used) {
+            slot.pin = pin;
+            break;
+        }
+    }
+    state.channels.push_back(std::move(slot));
+    selectChannel(state, state.channels.size() - 1);
+}
+
+// Drops the edited channel with its history and selects its neighbour.
+void removeChannel(AppState& state) {
+    if (state.channels.size() < 2 || state.dragging) return;
+    state.channels.erase(state.channels.begin() + static_cast<std::ptrdiff_t>(state.activeChannel));
+    state.activeChannel = std::min(state.activeChannel, state.channels.size() - 1);
+    ChannelSlot& taken = state.channels[state.activeChannel];
+    std::swap(state.points, taken.points);
+    std::swap(state.history, taken.history);
+    taken.points.clear();
+    taken.history->reset(taken.points);
+    state.selection.reset(state.points.size());
+    state.simplifyCache.invalidate();
+    ++state.pointsRevision;
+    ++state.rigRevision;
+}
+
+void startImport(AppState& state) {
+    if (state.importThread.joinable() || state.importPath[0] == '\0') return;
+    state.importError.clear();
+    state.importDone = false;
+    state.importProgress.cancel = false;
+    state.importStarted = std::chrono::steady_clock::now();
+
+    ImportOptions options;
+    options.tolerance = state.importTolerance;
+    std::string path = state.importPath;
+    state.importThread = std::thread([&state, path, options] {
+        importTelemetry(path, options, state.importedPoints, state.importError, &state.importProgress);
+        state.importDone = true;
+        glfwPostEmptyEvent();  // wake the loop to take the curve over
+    });
+}
+
+// Takes over the curve of a finished import; called every frame.
+void finishImport(AppState& state) {
+    if (!state.importThread.joinable() || !state.importDone) return;
+    state.importThread.join();
+    if (!state.importError.empty()) {
+        showsText(state, state.importError);
+        return;
+    }
+
+    state.points.assign(state.importedPoints);
+    std::vector<DataPoint>().swap(state.importedPoints);
+    state.selection.reset(state.points.size());
+    ++state.pointsRevision;
+    if (!state.points.empty()) {
+        state.timeScale = std::clamp(state.points[state.points.size() - 1].x, 0.1f, 10.0f);
+    }
+    if (!fitsBoard(state, simplifiedPoints(state))) {
+        state.warningTimer = 2.0f;
+    }
+}
+
+// The resident player drives the pin of the channel being edited and holds what the board's RAM
+// allows.
+LiveOptions liveOptions(const AppState& state) {
+    LiveOptions options;
+    options.pin = state.channels[state.activeChannel].pin;
+    options.capacity = liveCapacity(boardProfiles()[state.boardIndex]);
+    options.tickMs = state.codeOptions.tickMs;
+    return options;
+}
+
+// A single curve is exported with the chosen player, or as a sketch with the resident player.
+void writeCurveCode(std::ostream& out, AppState& state, const CodeOptions& options) {
+    if (state.liveSketch && options.format == CodeFormat::Sketch) {
+        writeLiveSketch(out, simplifiedPoints(state), liveOptions(state));
+    } else {
+        writeArduinoCode(out, simplifiedPoints(state), options);
+    }
+}
+
+// The sketch generateCode writes, in the Sketch format whatever the chosen one.
+std::string sketchCode(AppState& state) {
+    CodeOptions options = state.codeOptions;
+    options.format = CodeFormat::Sketch;
+    std::ostringstream code;
+    if (state.channels.size() > 1) {
+        writeMultiChannelCode(code, rigPlan(state), options);
+    } else {
+        writeCurveCode(code, state, options);
+    }
+    return code.str();
+}
+
+void toggleLive(AppState& state) {
+    state.liveError.clear();
+    if (state.live.isOpen()) {
+        state.live.close();
+        return;
+    }
+    if (state.live.open(state.livePort, liveOptions(state), state.liveError)) state.liveSync = LiveSync();
+}
+
+// Hands the exported curve to the live link when it or the settings that shape it changed; the
+// link sends from its own thread and merges what arrives while an update is on the wire.
+void streamLive(AppState& state) {
+    if (!state.live.isOpen()) return;
+    LiveSync& sent = state.liveSync;
+    if (sent.revision == state.pointsRevision && sent.budgetMode == state.budgetMode &&
+        sent.simplifier == state.simplifier && sent.tolerance == state.toleranceCounts &&
+        sent.pointBudget == state.pointBudget) {
+        return;
+    }
+    sent.revision = state.pointsRevision;
+    sent.budgetMode = state.budgetMode;
+    sent.simplifier = state.simplifier;
+    sent.tolerance = state.toleranceCounts;
+    sent.pointBudget = state.pointBudget;
+    state.live.submit(simplifiedPoints(state));
+}
+
+// Compiles and plays the exported sketch on the host against copies of the original curves.
+void startSimulation(AppState& state) {
+    if (state.simThread.joinable() || state.dragging) return;
+    std::string sketch = sketchCode(state);
+    std::vector<std::pair<int, std::vector<DataPoint>>> curves;
+    for (size_t c = 0; c < state.channels.size(); ++c) {
+        const ChannelSlot& slot = state.channels[c];
+        curves.push_back({slot.pin, c == state.activeChannel ? state.points.toPoints() : slot.points.toPoints()});
+    }
+    state.simError.clear();
+    state.simDone = false;
+    state.simRevision = state.pointsRevision;
+    state.simThread = std::thread([&state, sketch = std::move(sketch), curves = std::move(curves)] {
+        std::vector<Channel> channels;
+        for (const auto& [pin, points] : curves) channels.push_back({pin, points});
+        simulateSketch(sketch, channels, {}, state.simReport, state.simError);
+        state.simDone = true;
+        glfwPostEmptyEvent();
+    });
+}
+
+void finishSimulation(AppState& state) {
+    if (!state.simThread.joinable() || !state.simDone) return;
+    state.simThread.join();
+    state.simulated = state.simError.empty();
+    showsText(state, state.simError);
+}
+
+// A rig of several channels is exported as one sketch on a shared time base; point budgets
+// apply to single curves only, so a rig is simplified to the tolerance.
+void generateCode(AppState& state) {
+    bool rig = state.channels.size() > 1;
+    if (!rig && state.points.empty()) return;
+    if (rig) {
+        const ChannelPlan& plan = rigPlan(state);
+        if (!boardProfiles()[state.boardIndex].fits(plan.flashBytes, plan.largestArray)) {
+            state.warningTimer = 2.0f;
+            return;
+        }
+    }
 
     std::string filePath;
     showSaveDialog(filePath);
@@ -340,65 +909,155 @@ void generateCode(AppState& state) {
 
     std::ofstream file(filePath);
     if (file.is_open()) {
-        file << "#include <avr/pgmspace.h>\n";
-        file << "#include <math.h>\n\n";
-        file << "const int NUM_POINTS = " << simplifiedPoints.size() << ";\n\n";
-        
-        file << "const float timePoints[] PROGMEM = {";
-        for (size_t i = 0; i < simplifiedPoints.size(); ++i) {
-            file << simplifiedPoints[i].x << (i == simplifiedPoints.size() - 1 ? "" : ", ");
+        if (rig) {
+            writeMultiChannelCode(file, rigPlan(state), state.codeOptions);
+        } else {
+            writeCurveCode(file, state, state.codeOptions);
         }
-        file << "};\n\n";
-
-        file << "const uint8_t values[] PROGMEM = {";
-        for (size_t i = 0; i < simplifiedPoints.size(); ++i) {
-            int pwmVal = (int)(simplifiedPoints[i].y * 2.55f);
-            pwmVal = std::clamp(pwmVal, 0, 255);
-            file << pwmVal << (i == simplifiedPoints.size() - 1 ? "" : ", ");
-        }
-        file << "};\n\n";
+        file.close();
+        state.successTimer = 3.0f;
+        state.lastSavedFile = filePath.substr(filePath.find_last_of("/\\") + 1);
+        showsText(state, state.lastSavedFile);
+    }
+}
 
-        file << R"(
-void setup() {
-  pinMode(10, OUTPUT);
-  TCCR1A = _BV(COM1A1) | _BV(WGM10);
-  TCCR1B = _BV(CS10);
+SessionSettings sessionSettings(const AppState& state) {
+    SessionSettings settings;
+    settings.language = state.language;
+    settings.timeScale = state.timeScale;
+    settings.simplifier = state.simplifier;
+    settings.toleranceCounts = state.toleranceCounts;
+    settings.budgetMode = state.budgetMode;
+    settings.pointBudget = state.pointBudget;
+    settings.wave = state.wave;
+    settings.player = state.codeOptions.player;
+    settings.tickMs = state.codeOptions.tickMs;
+    settings.lookupShift = state.codeOptions.lookupShift;
+    settings.encoding = state.codeOptions.encoding;
+    settings.board = boardProfiles()[state.boardIndex].name;
+    settings.activeChannel = static_cast<uint32_t>(state.activeChannel);
+    return settings;
 }
 
-float getPointTime(int index) {
-  return pgm_read_float(&timePoints[index]);
+void applySessionSettings(AppState& state, const SessionSettings& settings) {
+    state.language = settings.language;
+    state.timeScale = std::clamp(settings.timeScale, 0.1f, 10.0f);
+    state.simplifier = settings.simplifier;
+    state.toleranceCounts = settings.toleranceCounts;
+    state.budgetMode = settings.budgetMode;
+    state.pointBudget = std::max(settings.pointBudget, 2);
+    state.wave = settings.wave;
+    state.codeOptions.player = settings.player;
+    state.codeOptions.tickMs = settings.tickMs;
+    state.codeOptions.lookupShift = settings.lookupShift;
+    state.codeOptions.encoding = settings.encoding;
+    if (const BoardProfile* board = findBoard(settings.board)) {
+        state.boardIndex = static_cast<size_t>(board - boardProfiles().data());
+    }
 }
 
-uint8_t getPointValue(int index) {
-  return pgm_read_byte(&values[index]);
+// Writes every channel to the session path and autosaves there from now on.
+void saveSession(AppState& state) {
+    state.sessionError.clear();
+    state.sessionChannels.clear();
+    state.sessionPins.clear();
+    for (size_t c = 0; c < state.channels.size(); ++c) {
+        state.sessionChannels.push_back({state.channels[c].pin, channelPoints(state, c).view()});
+        state.sessionPins.push_back(state.channels[c].pin);
+    }
+    state.lastAutosave = std::chrono::steady_clock::now();
+    if (!state.session.save(state.sessionPath, sessionSettings(state), state.sessionChannels, state.sessionError)) {
+        showsText(state, state.sessionError);
+        return;
+    }
+    for (size_t c = 0; c < state.channels.size(); ++c) channelPoints(state, c).clearUnsaved();
 }
 
-void loop() {
-  float totalDuration = getPointTime(NUM_POINTS - 1);
-  float currentTime = fmod(millis() / 1000.0, totalDuration);
-  float outputValue = 0.0;
+// Replaces the rig with the session at the session path, histories starting over, and
+// continues its journal.
+void openSession(AppState& state) {
+    if (state.dragging) return;
+    state.sessionError.clear();
+    auto start = std::chrono::steady_clock::now();
+    SessionData session;
+    if (!loadSession(state.sessionPath, session, state.sessionError)) {
+        showsText(state, state.sessionError);
+        return;
+    }
+    if (session.channels.empty()) session.channels.resize(1);
 
-  for(int i = 0; i < NUM_POINTS - 1; i++) {
-    float t1 = getPointTime(i);
-    float t2 = getPointTime(i+1);
-    if(currentTime >= t1 && currentTime <= t2) {
-      float lerpT = (currentTime - t1) / (t2 - t1);
-      outputValue = getPointValue(i) + lerpT * (getPointValue(i+1) - getPointValue(i));
-      break;
+    state.channels.clear();
+    state.sessionPins.clear();
+    for (SessionCurve& curve : session.channels) {
+        ChannelSlot slot;
+        slot.pin = curve.pin;
+        std::swap(slot.points, curve.points);
+        slot.history->reset(slot.points);
+        state.channels.push_back(std::move(slot));
+        state.sessionPins.push_back(curve.pin);
     }
-  }
+    applySessionSettings(state, session.settings);
+    state.activeChannel = std::min<size_t>(session.settings.activeChannel, state.channels.size() - 1);
+    ChannelSlot& taken = state.channels[state.activeChannel];
+    std::swap(state.points, taken.points);
+    std::swap(state.history, taken.history);
+    state.selection.reset(state.points.size());
+    state.simplifyCache.invalidate();
+    state.engineResult.revision = UINT64_MAX;
+    ++state.pointsRevision;
+    ++state.rigRevision;
 
-  analogWrite(10, (int)outputValue);
-  delay(10);
+    // The swapped-in stores hold what the file holds, so the journal continues from there.
+    if (!state.session.resume(state.sessionPath, session, state.sessionError)) {
+        showsText(state, state.sessionError);
+    }
+    state.lastAutosave = std::chrono::steady_clock::now();
+    state.sessionOpenMs = std::chrono::duration<double, std::milli>(state.lastAutosave - start).count();
 }
-)";
-        file.close();
-        state.successTimer = 3.0f;
-        state.lastSavedFile = filePath.substr(filePath.find_last_of("/\\") + 1);
+
+// Every AUTOSAVE_PERIOD, and when `now`, appends the edits of each channel and any change of
+// settings to the session's journal. A drag is saved once released. The file is rewritten when
+// the channels changed, an append failed, or the journal outgrew the snapshot.
+void autosave(AppState& state, bool now) {
+    if (!state.session.isOpen() || state.dragging) return;
+    auto start = std::chrono::steady_clock::now();
+    if (!now && start - state.lastAutosave < AUTOSAVE_PERIOD) return;
+    state.lastAutosave = start;
+
+    bool rigChanged = state.sessionPins.size() != state.channels.size();
+    for (size_t c = 0; !rigChanged && c < state.channels.size(); ++c) {
+        rigChanged = state.sessionPins[c] != state.channels[c].pin;
+    }
+    if (rigChanged) {
+        saveSession(state);
+        return;
+    }
+
+    uint64_t journalBefore = state.session.stats().journalBytes;
+    bool ok = true;
+    for (size_t c = 0; ok && c < state.channels.size(); ++c) {
+        CurveStore& points = channelPoints(state, c);
+        const CurveStore::Changes& edit = points.unsaved();
+        if (edit.first == CurveStore::npos) continue;
+        ok = state.session.appendSplice(c, points.view(), edit.first, edit.tail, state.sessionError);
+        points.clearUnsaved();
+    }
+    ok = ok && state.session.appendSettings(sessionSettings(state), state.sessionError) &&
+         state.session.flush(state.sessionError);
+    if (!ok || state.session.needsCompaction()) {
+        saveSession(state);
+        return;
+    }
+    uint64_t appended = state.session.stats().journalBytes - journalBefore;
+    if (appended > 0) {
+        state.autosaveBytes = static_cast<size_t>(appended);
+        state.autosaveMicros =
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
     }
 }
 
 int main() {
+    auto launched = std::chrono::steady_clock::now();
     if (!glfwInit()) return 1;
     
     GLFWwindow* window = glfwCreateWindow(1280, 720, "Motor Curve Generator", NULL, NULL);
@@ -413,57 +1072,86 @@ int main() {
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
 
-    ImFontConfig fontConfig;
-    fontConfig.MergeMode = false;
-    fontConfig.FontDataOwnedByAtlas = false;
-    io.Fonts->AddFontFromMemoryTTF((void*)NotoSansMonoCJKsc_Regular_otf, NotoSansMonoCJKsc_Regular_otf_len, 16.0f, &fontConfig, io.Fonts->GetGlyphRangesChineseFull());
-
-    fontConfig.MergeMode = true;
-    fontConfig.FontDataOwnedByAtlas = false;
-    io.Fonts->AddFontFromMemoryTTF((void*)NotoSansMonoCJKkr_Regular_otf, NotoSansMonoCJKkr_Regular_otf_len, 16.0f, &fontConfig, io.Fonts->GetGlyphRangesKorean());
+    AppState state;
+    state.glyphs.addText(UI_GLYPHS);
+    buildFonts(state);
 
+    installRedrawCallbacks(window, &state.redraw);
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 130");
 
-    AppState state;
-
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        // Nothing new to show: sleep until an event or the next timer instead of redrawing the
+        // same frame at the display's refresh rate.
+        double wait = idleWait(state, io);
+        if (wait == 0.0) {
+            glfwPollEvents();
+        } else if (wait > 0.0) {
+            glfwWaitEventsTimeout(wait);
+        } else {
+            glfwWaitEvents();
+        }
+        beginFrameStats(state.frameStats);
+        state.frame.reset();
+
+        if (state.glyphsChanged) {
+            state.glyphsChanged = false;
+            buildFonts(state);
+            ImGui_ImplOpenGL3_DestroyFontsTexture();
+            ImGui_ImplOpenGL3_CreateFontsTexture();
+        }
         
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        finishImport(state);
+        finishSimulation(state);
+
+        // The timers count down before the popups are drawn, so the frame drawn when one runs out
+        // already leaves its popup off.
+        if (state.warningTimer > 0.0f) state.warningTimer -= io.DeltaTime;
+        if (state.successTimer > 0.0f) state.successTimer -= io.DeltaTime;
+
         if (state.warningTimer > 0.0f) {
-            state.warningTimer -= io.DeltaTime;
             ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
             ImGui::SetNextWindowBgAlpha(0.8f);
             if (ImGui::Begin("Warning", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize)) {
-                ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "%s", state.i18n[state.currentLang]["memoryWarning"].c_str());
+                ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "%s", tr(state.language, Text::MemoryWarning));
                 ImGui::End();
             }
         }
 
         if (state.successTimer > 0.0f) {
-            state.successTimer -= io.DeltaTime;
             ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
             ImGui::SetNextWindowBgAlpha(0.8f);
             if (ImGui::Begin("Success", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize)) {
                 ImGui::TextColored(ImVec4(0.2f, 1.0f, 0.2f, 1.0f), "%s %s", 
-                    state.i18n[state.currentLang]["fileGenerated"].c_str(), state.lastSavedFile.c_str());
+                    tr(state.language, Text::FileGenerated), state.lastSavedFile.c_str());
                 ImGui::End();
             }
         }
 
-        if (ImGui::IsKeyPressed(ImGuiKey_Delete)) {
-            if (!state.selectedPoints.empty()) {
-                std::sort(state.selectedPoints.begin(), state.selectedPoints.end(), std::greater<int>());
-                for (int idx : state.selectedPoints) {
-                    if (idx >= 0 && idx < static_cast<int>(state.points.size())) {
-                        state.points.erase(state.points.begin() + idx);
-                    }
+        if (ImGui::IsKeyPressed(ImGuiKey_F3, false)) state.frameStats.visible = !state.frameStats.visible;
+
+        if (io.KeyCtrl && !io.WantTextInput) {
+            if (ImGui::IsKeyPressed(ImGuiKey_Z)) undoRedo(state, io.KeyShift);
+            if (ImGui::IsKeyPressed(ImGuiKey_Y)) undoRedo(state, true);
+        }
+
+        // Delete in a text field edits the text, not the curve.
+        if (ImGui::IsKeyPressed(ImGuiKey_Delete) && !io.WantTextInput) {
+            // A few points are erased one by one so the simplification updates incrementally;
+            // larger selections are compacted in one pass and the cache is rebuilt once.
+            if (state.selection.count() <= 16) {
+                for (size_t idx : state.selection.indicesDescending()) {
+                    state.points.erase(idx);
+                    state.simplifyCache.pointErased(state.points.view(), idx, state.pointsRevision);
                 }
-                state.selectedPoints.clear();
+                state.selection.reset(state.points.size());
+            } else {
+                state.selection.eraseSelected(state.points);
+                ++state.pointsRevision;
             }
         }
 
@@ -473,62 +1161,307 @@ int main() {
             ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoResize);
 
         ImGui::SetNextItemWidth(150);
-        if (ImGui::BeginCombo("Language", state.currentLang.c_str())) {
-            if (ImGui::Selectable("English", state.currentLang == "en")) 
-                state.currentLang = "en";
-            if (ImGui::Selectable("中文", state.currentLang == "zh")) 
-                state.currentLang = "zh";
-            if (ImGui::Selectable("한국어", state.currentLang == "ko")) 
-                state.currentLang = "ko";
+        if (ImGui::BeginCombo("Language", languageName(state.language))) {
+            for (Language language : {Language::English, Language::Chinese, Language::Korean}) {
+                if (ImGui::Selectable(languageName(language), state.language == language))
+                    state.language = language;
+            }
             ImGui::EndCombo();
         }
 
+        ImGui::Text("%s", tr(state.language, Text::Channel));
+        for (size_t c = 0; c < state.channels.size(); ++c) {
+            char label[16];
+            std::snprintf(label, sizeof(label), "%zu##channel", c + 1);
+            ImGui::SameLine();
+            if (ImGui::RadioButton(label, state.activeChannel == c)) selectChannel(state, c);
+        }
+        ImGui::SameLine();
+        ImGui::BeginDisabled(state.channels.size() >= MAX_CHANNELS);
+        if (ImGui::Button(tr(state.language, Text::AddChannel))) addChannel(state);
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(state.channels.size() < 2);
+        if (ImGui::Button(tr(state.language, Text::RemoveChannel))) removeChannel(state);
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100);
+        int& pin = state.channels[state.activeChannel].pin;
+        if (ImGui::InputInt(tr(state.language, Text::Pin), &pin)) {
+            pin = std::clamp(pin, 0, 255);
+            ++state.rigRevision;
+        }
+
         drawPlot(state);
 
-        std::vector<DataPoint> simplified;
-        rdpSimplify(state.points, state.rdpEpsilon, simplified);
-        ImGui::Text("Points: %zu (Simplified: %zu / %d)", 
-            state.points.size(), simplified.size(), ARDUINO_MEMORY_LIMIT);
+        const auto& simplified = simplifiedPoints(state);
+        if (state.budgetMode) {
+            const FitError& error = state.budget.result().error;
+            ImGui::Text("Points: %zu (Simplified: %zu / %d, max error %.2f%%, RMS %.2f%%)",
+                state.points.size(), simplified.size(), state.pointBudget, error.maxError, error.rmsError);
+        } else {
+            ImGui::Text("Points: %zu (Simplified: %zu)", state.points.size(), simplified.size());
+        }
+        ImGui::Text("%.1f fps, %d vertices (%zu of %zu visible points drawn)", io.Framerate,
+            io.MetricsRenderVertices, state.plotGeometry.polyline().size(), state.plotGeometry.visiblePoints());
 
-        ImGui::SliderFloat(state.i18n[state.currentLang]["timeScale"].c_str(), 
+        ImGui::SliderFloat(tr(state.language, Text::TimeScale), 
             &state.timeScale, 0.1f, 10.0f, "%.1fx");
         
         ImGui::Separator();
-        ImGui::Text("%s", state.i18n[state.currentLang]["sineWave"].c_str());
-        ImGui::SliderFloat(state.i18n[state.currentLang]["amplitude"].c_str(), 
-            &state.amplitude, 0.0f, 50.0f, "%.1f%%");
-        ImGui::SliderFloat(state.i18n[state.currentLang]["frequency"].c_str(), 
-            &state.frequency, 0.1f, 10.0f, "%.1f Hz");
-        ImGui::SliderFloat(state.i18n[state.currentLang]["density"].c_str(), 
-            &state.sineDensity, 0.005f, 0.1f, "%.3f", ImGuiSliderFlags_Logarithmic);
-        ImGui::SliderFloat("Optimization", &state.rdpEpsilon, 0.0f, 2.0f, "%.2f");
-        ImGui::Checkbox(state.i18n[state.currentLang]["appendWave"].c_str(), &state.appendWave);
-        if (ImGui::Button(state.i18n[state.currentLang]["generateWave"].c_str())) {
-            generateSineWave(state);
+        ImGui::Text("%s", tr(state.language, Text::Waveform));
+        if (ImGui::BeginCombo(tr(state.language, Text::Shape), waveShapeName(state.wave.shape))) {
+            for (WaveShape shape : {WaveShape::Sine, WaveShape::Triangle, WaveShape::Trapezoid, WaveShape::SCurve, WaveShape::Chirp}) {
+                if (ImGui::Selectable(waveShapeName(shape), state.wave.shape == shape))
+                    state.wave.shape = shape;
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SliderFloat(tr(state.language, Text::Amplitude), 
+            &state.wave.amplitude, 0.0f, 50.0f, "%.1f%%");
+        ImGui::SliderFloat(tr(state.language, Text::Frequency), 
+            &state.wave.frequency, 0.1f, 10.0f, "%.1f Hz");
+        if (state.wave.shape == WaveShape::Trapezoid || state.wave.shape == WaveShape::SCurve) {
+            ImGui::SliderFloat(tr(state.language, Text::RampFraction),
+                &state.wave.rampFraction, 0.01f, 0.5f, "%.2f");
+        }
+        if (state.wave.shape == WaveShape::Chirp) {
+            ImGui::SliderFloat(tr(state.language, Text::EndFrequency),
+                &state.wave.endFrequency, 0.1f, 50.0f, "%.1f Hz");
+        }
+        ImGui::SliderFloat(tr(state.language, Text::Density), 
+            &state.wave.density, 0.0001f, 0.1f, "%.4f", ImGuiSliderFlags_Logarithmic);
+        ImGui::BeginDisabled(state.budgetMode);
+        if (ImGui::BeginCombo(tr(state.language, Text::Simplifier), simplifierName(state.simplifier))) {
+            for (Simplifier engine : {Simplifier::Rdp, Simplifier::SwingDoor, Simplifier::Visvalingam}) {
+                if (ImGui::Selectable(simplifierName(engine), state.simplifier == engine))
+                    state.simplifier = engine;
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SliderFloat(tr(state.language, Text::Tolerance), &state.toleranceCounts, 0.0f, 10.0f, "%.1f PWM counts");
+        ImGui::EndDisabled();
+        ImGui::Checkbox("##budgetMode", &state.budgetMode);
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!state.budgetMode);
+        // Two bytes per point is the best any encoding does on typical curves.
+        const BoardProfile& board = boardProfiles()[state.boardIndex];
+        int maxBudget = static_cast<int>(std::min<size_t>(board.curveBytes / 2, 65535));
+        state.pointBudget = std::min(state.pointBudget, maxBudget);
+        ImGui::SliderInt(tr(state.language, Text::PointBudget),
+            &state.pointBudget, 2, maxBudget, "%d", ImGuiSliderFlags_Logarithmic);
+        ImGui::EndDisabled();
+        ImGui::Checkbox(tr(state.language, Text::AppendWave), &state.wave.append);
+        if (ImGui::Button(tr(state.language, Text::GenerateWave))) {
+            generateWave(state);
+        }
+
+        ImGui::Separator();
+        ImGui::Text("%s", tr(state.language, Text::ImportTelemetry));
+        bool importing = state.importThread.joinable();
+        ImGui::BeginDisabled(importing);
+        if (ImGui::InputText("##importPath", state.importPath, sizeof(state.importPath))) {
+            showsText(state, state.importPath);
+        }
+#ifdef _WIN32
+        ImGui::SameLine();
+        if (ImGui::Button("...")) {
+            showOpenDialog(state.importPath, sizeof(state.importPath));
+            showsText(state, state.importPath);
+        }
+#endif
+        ImGui::SliderFloat(tr(state.language, Text::ImportTolerance),
+            &state.importTolerance, 0.01f, 5.0f, "%.2f%%", ImGuiSliderFlags_Logarithmic);
+        if (ImGui::Button(tr(state.language, Text::Import))) {
+            startImport(state);
+        }
+        ImGui::EndDisabled();
+        if (importing) {
+            uint64_t done = state.importProgress.bytesRead, total = state.importProgress.bytesTotal;
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - state.importStarted).count();
+            char overlay[64];
+            std::snprintf(overlay, sizeof(overlay), "%.0f MB, %.0f MB/s", done / 1e6, seconds > 0 ? done / 1e6 / seconds : 0.0);
+            ImGui::ProgressBar(total > 0 ? static_cast<float>(done) / total : 0.0f, ImVec2(-1.0f, 0.0f), overlay);
+            if (ImGui::Button(tr(state.language, Text::Cancel))) {
+                state.importProgress.cancel = true;
+            }
+        } else if (!state.importError.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "%s", state.importError.c_str());
         }
         
         ImGui::Separator();
-        if (ImGui::Button(state.i18n[state.currentLang]["resetChart"].c_str())) {
+        if (ImGui::BeginCombo(tr(state.language, Text::Player), playerName(state.codeOptions.player))) {
+            for (PlayerKind kind : {PlayerKind::Scan, PlayerKind::Cursor, PlayerKind::FixedPoint, PlayerKind::Lookup}) {
+                if (ImGui::Selectable(playerName(kind), state.codeOptions.player == kind))
+                    state.codeOptions.player = kind;
+            }
+            ImGui::EndCombo();
+        }
+        int tickMs = static_cast<int>(state.codeOptions.tickMs);
+        ImGui::BeginDisabled(state.codeOptions.player == PlayerKind::Scan);
+        if (ImGui::SliderInt(tr(state.language, Text::TickPeriod), &tickMs, 0, 50, "%d ms"))
+            state.codeOptions.tickMs = static_cast<unsigned>(tickMs);
+        ImGui::EndDisabled();
+        if (ImGui::BeginCombo(tr(state.language, Text::Board), board.label)) {
+            for (size_t i = 0; i < boardProfiles().size(); ++i) {
+                if (ImGui::Selectable(boardProfiles()[i].label, state.boardIndex == i))
+                    state.boardIndex = i;
+            }
+            ImGui::EndCombo();
+        }
+        if (ImGui::BeginCombo(tr(state.language, Text::Encoding), encodingName(state.codeOptions.encoding))) {
+            if (ImGui::Selectable(encodingName(TableEncoding::Auto), state.codeOptions.encoding == TableEncoding::Auto))
+                state.codeOptions.encoding = TableEncoding::Auto;
+            for (const EncodingSize& size : exportCost(state).sizes) {
+                char label[64];
+                if (size.available) {
+                    std::snprintf(label, sizeof(label), "%s (%zu bytes)", encodingName(size.encoding), size.bytes);
+                } else {
+                    std::snprintf(label, sizeof(label), "%s (n/a)", encodingName(size.encoding));
+                }
+                ImGui::BeginDisabled(!size.available);
+                if (ImGui::Selectable(label, state.codeOptions.encoding == size.encoding))
+                    state.codeOptions.encoding = size.encoding;
+                ImGui::EndDisabled();
+            }
+            ImGui::EndCombo();
+        }
+        const PlayerCost& cost = exportCost(state).cost;
+        ImVec4 costColor = board.fits(cost.flashBytes, cost.largestArray)
+            ? ImVec4(1.0f, 1.0f, 1.0f, 1.0f) : ImVec4(1.0f, 0.2f, 0.2f, 1.0f);
+        ImGui::TextColored(costColor, "~%u cycles/tick, %zu / %zu bytes flash (%s)",
+            cost.cycles, cost.flashBytes, board.curveBytes, encodingName(cost.encoding));
+        if (state.channels.size() > 1) {
+            const ChannelPlan& plan = rigPlan(state);
+            ImVec4 rigColor = board.fits(plan.flashBytes, plan.largestArray)
+                ? ImVec4(1.0f, 1.0f, 1.0f, 1.0f) : ImVec4(1.0f, 0.2f, 0.2f, 1.0f);
+            double change = plan.separateBytes ? 100.0 * (static_cast<double>(plan.flashBytes) / plan.separateBytes - 1.0) : 0.0;
+            ImGui::TextColored(rigColor, "%zu channels: %zu bytes on %zu time tables vs %zu as separate sketches (%+.0f%%)",
+                state.channels.size(), plan.flashBytes, plan.tracks.size(), plan.separateBytes, change);
+        }
+
+        ImGui::Separator();
+        if (ImGui::Button(tr(state.language, Text::ResetChart))) {
             state.points.clear();
-            state.selectedPoints.clear();
+            state.selection.reset(0);
+            ++state.pointsRevision;
         }
         
         ImGui::SameLine();
-        if (ImGui::Button(state.i18n[state.currentLang]["generateCode"].c_str())) {
+        if (ImGui::Button(tr(state.language, Text::GenerateCode))) {
             generateCode(state);
         }
 
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!state.history->canUndo());
+        if (ImGui::Button(tr(state.language, Text::Undo))) undoRedo(state, false);
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(!state.history->canRedo());
+        if (ImGui::Button(tr(state.language, Text::Redo))) undoRedo(state, true);
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::BeginDisabled(state.simThread.joinable());
+        if (ImGui::Button(tr(state.language, Text::Simulate))) startSimulation(state);
+        ImGui::EndDisabled();
+        const CurveHistory::Stats& history = state.history->stats();
+        ImGui::Text("History: step %zu of %zu, %.1f MB; last snapshot %.1f KB in %.0f us", history.position + 1,
+            history.steps, history.bytes / 1e6, history.lastCommitBytes / 1024.0, history.lastCommitNanos / 1e3);
+        if (state.simThread.joinable()) {
+            ImGui::Text("Simulating...");
+        } else if (!state.simError.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "%s", state.simError.c_str());
+        } else if (state.simulated && state.simRevision == state.pointsRevision) {
+            const SimReport& sim = state.simReport;
+            ImGui::Text("Simulated: max error %.2f%% at %.3f s, RMS %.2f%%; %.1f flash reads per loop (worst %u), "
+                "worst loop %u cycles in flash reads and I/O", sim.maxError, sim.maxErrorAt, sim.rmsError,
+                sim.flashReadsPerLoop, sim.maxFlashReads, sim.worstCycles);
+        }
+
+        ImGui::Separator();
+        ImGui::Text("%s", tr(state.language, Text::LiveTuning));
+        bool connected = state.live.isOpen();
+        ImGui::BeginDisabled(connected);
+        ImGui::SetNextItemWidth(200);
+        if (ImGui::InputText("##livePort", state.livePort, sizeof(state.livePort))) {
+            showsText(state, state.livePort);
+        }
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        if (ImGui::Button(tr(state.language, connected ? Text::Disconnect : Text::Connect))) toggleLive(state);
+        ImGui::SameLine();
+        ImGui::Checkbox(tr(state.language, Text::ResidentPlayer), &state.liveSketch);
+        if (state.live.isOpen()) {
+            streamLive(state);
+            state.liveStats = state.live.stats();
+            state.live.lastError(state.liveError);
+            const LiveStats& live = state.liveStats;
+            ImGui::Text("%zu edits sent in %zu updates, last %zu bytes; edit to board %.1f ms (mean %.1f, max %.1f)",
+                live.edits, live.updates, live.lastBytes, live.lastLatencyMs,
+                live.updates ? live.totalLatencyMs / live.updates : 0.0, live.maxLatencyMs);
+        }
+        if (!state.liveError.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "%s", state.liveError.c_str());
+        }
+
+        ImGui::Separator();
+        ImGui::Text("%s", tr(state.language, Text::Session));
+        ImGui::SetNextItemWidth(300);
+        if (ImGui::InputText("##sessionPath", state.sessionPath, sizeof(state.sessionPath))) {
+            showsText(state, state.sessionPath);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button(tr(state.language, Text::OpenSession))) openSession(state);
+        ImGui::SameLine();
+        if (ImGui::Button(tr(state.language, Text::SaveSession))) saveSession(state);
+        if (state.session.isOpen()) {
+            const SessionStats& saved = state.session.stats();
+            ImGui::Text("Snapshot %.1f MB (written in %.1f ms, %zu compactions), journal %.1f KB in %zu records; "
+                "last autosave %zu bytes in %.0f us", saved.snapshotBytes / 1e6, saved.lastSnapshotNanos / 1e6,
+                saved.compactions, saved.journalBytes / 1024.0, saved.journalRecords, state.autosaveBytes,
+                state.autosaveMicros);
+            if (state.sessionOpenMs > 0) {
+                ImGui::SameLine();
+                ImGui::Text("; opened in %.1f ms", state.sessionOpenMs);
+            }
+        }
+        if (!state.sessionError.empty()) {
+            ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.2f, 1.0f), "%s", state.sessionError.c_str());
+        }
+
         ImGui::End();
 
-        ImGui::Render();
-        int display_w, display_h;
-        glfwGetFramebufferSize(window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (!state.dragging) state.history->commit(state.points);
+        autosave(state, false);
+
+        if (state.frameStats.visible) drawFrameStats(state.frameStats, io, state.glyphs.size());
+
+        {
+            ScopedTimer renderTimer(state.frameStats.profiler, ProfileStage::Render);
+            ImGui::Render();
+            int display_w, display_h;
+            glfwGetFramebufferSize(window, &display_w, &display_h);
+            glViewport(0, 0, display_w, display_h);
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        endFrameStats(state.frameStats);
         glfwSwapBuffers(window);
+        if (state.redraw.framesOwed > 0) --state.redraw.framesOwed;
+        if (state.frameStats.startupMs == 0) {
+            state.frameStats.startupMs =
+                std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - launched).count();
+        }
+    }
+
+    if (state.importThread.joinable()) {
+        state.importProgress.cancel = true;
+        state.importThread.join();
     }
+    if (state.simThread.joinable()) state.simThread.join();
+    state.dragging = false;
+    autosave(state, true);
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
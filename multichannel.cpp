@@ -0,0 +1,321 @@
+#include "multichannel.h"
+
+#include "simplify.h"
+
+#include <algorithm>
+
+namespace {
+
+// The members' curves resampled on the union of their point times. A time appears as often as
+// the channel with the most points at it has them, so vertical steps survive; outside its own
+// points a channel holds its first or last value.
+struct Merged {
+    std::vector<float> times;
+    std::vector<std::vector<float>> values;  // per member, one per time
+};
+
+Merged merge(const std::vector<Channel>& channels, const std::vector<size_t>& members) {
+    Merged merged;
+    std::vector<float> all;
+    for (size_t c : members) {
+        CurveView points = channels[c].points;
+        for (size_t i = 0; i < points.size(); ++i) all.push_back(points.x(i));
+    }
+    std::sort(all.begin(), all.end());
+
+    // Distinct times with the largest number of points any member has at each.
+    std::vector<std::pair<float, size_t>> distinct;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j] == all[i]) ++j;
+        distinct.push_back({all[i], 1});
+        i = j;
+    }
+    for (size_t c : members) {
+        CurveView points = channels[c].points;
+        for (size_t i = 0, d = 0; i < points.size();) {
+            size_t j = i;
+            while (j < points.size() && points.x(j) == points.x(i)) ++j;
+            while (distinct[d].first < points.x(i)) ++d;
+            distinct[d].second = std::max(distinct[d].second, j - i);
+            i = j;
+        }
+    }
+    for (const auto& [time, repeats] : distinct) merged.times.insert(merged.times.end(), repeats, time);
+
+    for (size_t c : members) {
+        CurveView points = channels[c].points;
+        std::vector<float> row;
+        row.reserve(merged.times.size());
+        size_t at = 0;
+        for (const auto& [time, repeats] : distinct) {
+            while (at < points.size() && points.x(at) < time) ++at;
+            size_t end = at;
+            while (end < points.size() && points.x(end) == time) ++end;
+            for (size_t k = 0; k < repeats; ++k) {
+                float value = 0;
+                if (end > at) {
+                    value = points.y(std::min(at + k, end - 1));
+                } else if (at == 0) {
+                    value = points.empty() ? 0.0f : points.y(0);
+                } else if (at == points.size()) {
+                    value = points.y(at - 1);
+                } else {
+                    DataPoint a = points[at - 1], b = points[at];
+                    value = a.y + (b.y - a.y) * (time - a.x) / (b.x - a.x);
+                }
+                row.push_back(value);
+            }
+        }
+        merged.values.push_back(std::move(row));
+    }
+    return merged;
+}
+
+// RDP over all members at once: a time is kept when any member is farther than `tolerance`
+// (percent duty) from its chord at that time.
+std::vector<uint8_t> jointKeep(const Merged& merged, float tolerance) {
+    size_t n = merged.times.size();
+    std::vector<uint8_t> keep(n, 0);
+    if (n == 0) return keep;
+    keep[0] = keep[n - 1] = 1;
+    std::vector<std::pair<size_t, size_t>> stack{{0, n - 1}};
+    while (!stack.empty()) {
+        auto [first, last] = stack.back();
+        stack.pop_back();
+        if (last - first < 2) continue;
+
+        size_t split = 0;
+        float maxDist = 0;
+        for (size_t k = first + 1; k < last; ++k) {
+            float dist = 0;
+            for (const auto& row : merged.values) {
+                dist = std::max(dist, verticalDistance({merged.times[k], row[k]}, {merged.times[first], row[first]},
+                                                       {merged.times[last], row[last]}));
+            }
+            if (dist > maxDist) {
+                maxDist = dist;
+                split = k;
+            }
+        }
+        if (maxDist > tolerance) {
+            keep[split] = 1;
+            stack.push_back({first, split});
+            stack.push_back({split, last});
+        }
+    }
+    return keep;
+}
+
+ChannelTrack makeTrack(const std::vector<Channel>& channels, const std::vector<size_t>& members, float tolerance) {
+    ChannelTrack track;
+    track.channels = members;
+    for (size_t c : members) track.pins.push_back(channels[c].pin);
+    track.values.resize(members.size());
+
+    Merged merged = merge(channels, members);
+    std::vector<uint8_t> keep = jointKeep(merged, tolerance);
+    for (size_t i = 0; i < keep.size(); ++i) {
+        if (!keep[i]) continue;
+        track.times.push_back(toMs(merged.times[i]));
+        for (size_t m = 0; m < members.size(); ++m) track.values[m].push_back(toPwm(merged.values[m][i]));
+    }
+    // The player interpolates between two points, so a single point becomes a hold.
+    while (track.times.size() < 2) {
+        track.times.push_back(track.times.empty() ? 0 : track.times.back());
+        for (auto& row : track.values) row.push_back(row.empty() ? 0 : row.back());
+    }
+    return track;
+}
+
+void measure(ChannelPlan& plan) {
+    uint32_t maxStep = 0;
+    plan.totalMs = 1;
+    for (const auto& track : plan.tracks) {
+        for (size_t i = 1; i < track.times.size(); ++i) maxStep = std::max(maxStep, track.times[i] - track.times[i - 1]);
+        plan.totalMs = std::max(plan.totalMs, track.times.back());
+    }
+    plan.stepBytes = maxStep > 0xFFFF ? 4 : maxStep > 0xFF ? 2 : 1;
+    plan.flashBytes = plan.largestArray = 0;
+    for (const auto& track : plan.tracks) {
+        size_t steps = (track.times.size() - 1) * plan.stepBytes;
+        size_t values = track.times.size() * track.channels.size();
+        plan.flashBytes += steps + values;
+        plan.largestArray = std::max({plan.largestArray, steps, values});
+    }
+}
+
+ChannelPlan makePlan(const std::vector<Channel>& channels, const std::vector<size_t>& shared,
+                     const std::vector<size_t>& solo, float tolerance) {
+    ChannelPlan plan;
+    if (!shared.empty()) plan.tracks.push_back(makeTrack(channels, shared, tolerance));
+    for (size_t c : solo) plan.tracks.push_back(makeTrack(channels, {c}, tolerance));
+    measure(plan);
+    return plan;
+}
+
+const char* stepReader(unsigned stepBytes) {
+    return stepBytes == 1 ? "pgm_read_byte" : stepBytes == 2 ? "pgm_read_word" : "pgm_read_dword";
+}
+
+template <typename T>
+void writeRow(std::ostream& out, const std::vector<T>& items) {
+    for (size_t i = 0; i < items.size(); ++i) out << +items[i] << (i + 1 == items.size() ? "" : ", ");
+}
+
+}  // namespace
+
+ChannelPlan planChannels(const std::vector<Channel>& channels, float tolerance, const CodeOptions& options) {
+    // Which channels share the time base is decided on the channels simplified one by one, which
+    // is fast and ranks the choices the same way; the plan itself is made from the full curves.
+    std::vector<std::vector<DataPoint>> simplified(channels.size());
+    std::vector<Channel> coarse = channels;
+    size_t separateBytes = 0;
+    for (size_t c = 0; c < channels.size(); ++c) {
+        rdpSimplify(channels[c].points, tolerance, simplified[c], DistanceMetric::Vertical);
+        coarse[c].points = simplified[c];
+        separateBytes += estimatePlayerCost(simplified[c], options).flashBytes;
+    }
+
+    std::vector<size_t> shared(channels.size()), solo;
+    for (size_t c = 0; c < channels.size(); ++c) shared[c] = c;
+    size_t bestBytes = makePlan(coarse, shared, solo, tolerance).flashBytes;
+    while (shared.size() > 1) {
+        size_t bestMove = shared.size();
+        for (size_t k = 0; k < shared.size(); ++k) {
+            std::vector<size_t> rest = shared, alone = solo;
+            rest.erase(rest.begin() + k);
+            alone.push_back(shared[k]);
+            size_t bytes = makePlan(coarse, rest, alone, tolerance).flashBytes;
+            if (bytes < bestBytes) {
+                bestBytes = bytes;
+                bestMove = k;
+            }
+        }
+        if (bestMove == shared.size()) break;
+        solo.push_back(shared[bestMove]);
+        shared.erase(shared.begin() + bestMove);
+    }
+    std::sort(solo.begin(), solo.end());
+
+    ChannelPlan plan = makePlan(channels, shared, solo, tolerance);
+    plan.separateBytes = separateBytes;
+    return plan;
+}
+
+void writeMultiChannelCode(std::ostream& out, const ChannelPlan& plan, const CodeOptions& options) {
+    bool header = options.format == CodeFormat::Header;
+    const std::string& prefix = header ? options.symbolPrefix : std::string();
+    const char* stepType = plan.stepBytes == 1 ? "uint8_t" : plan.stepBytes == 2 ? "uint16_t" : "uint32_t";
+    size_t channelCount = 0;
+    for (const auto& track : plan.tracks) channelCount += track.channels.size();
+
+    if (header) out << "#pragma once\n\n";
+    out << "#include <avr/pgmspace.h>\n\n";
+    out << "// " << channelCount << " channels on " << plan.tracks.size() << " time tables: " << plan.flashBytes
+        << " bytes of curve data (" << plan.separateBytes << " as separate sketches)\n\n";
+    out << "const uint32_t " << prefix << "TOTAL_MS = " << plan.totalMs << ";\n\n";
+
+    for (size_t t = 0; t < plan.tracks.size(); ++t) {
+        const ChannelTrack& track = plan.tracks[t];
+        std::string name = prefix + "track" + std::to_string(t);
+        std::vector<uint32_t> steps;
+        for (size_t i = 1; i < track.times.size(); ++i) steps.push_back(track.times[i] - track.times[i - 1]);
+
+        out << "// Channels ";
+        for (size_t m = 0; m < track.channels.size(); ++m) out << (m ? ", " : "") << track.channels[m] + 1;
+        out << ": milliseconds from each point to the next, then one row of PWM values per channel\n";
+        out << "const uint16_t " << name << "Points = " << track.times.size() << ";\n";
+        out << "const uint32_t " << name << "StartMs = " << track.times.front() << ";\n";
+        out << "const " << stepType << " " << name << "Steps[] PROGMEM = {";
+        writeRow(out, steps);
+        out << "};\n";
+        out << "const uint8_t " << name << "Values[] PROGMEM = {\n";
+        for (size_t m = 0; m < track.values.size(); ++m) {
+            out << "  ";
+            writeRow(out, track.values[m]);
+            out << (m + 1 == track.values.size() ? "\n" : ",\n");
+        }
+        out << "};\n";
+        out << "const uint8_t " << name << "Pins[] = {";
+        writeRow(out, track.pins);
+        out << "};\n\n";
+    }
+    if (header) return;
+
+    out << "struct Track {\n";
+    out << "  const " << stepType << "* steps;\n";
+    out << "  const uint8_t* values;  // one row of `points` values per channel\n";
+    out << "  const uint8_t* pins;\n";
+    out << "  uint32_t startMs;\n";
+    out << "  uint16_t points;\n";
+    out << "  uint8_t channels;\n";
+    out << "  uint16_t segment;\n";
+    out << "  uint32_t t1, t2;\n";
+    out << "};\n\n";
+    out << "Track tracks[] = {\n";
+    for (size_t t = 0; t < plan.tracks.size(); ++t) {
+        std::string name = "track" + std::to_string(t);
+        out << "  {" << name << "Steps, " << name << "Values, " << name << "Pins, " << name << "StartMs, " << name
+            << "Points, " << plan.tracks[t].channels.size() << ", 0, 0, 0},\n";
+    }
+    out << "};\n";
+    out << "const uint8_t TRACKS = sizeof(tracks) / sizeof(tracks[0]);\n";
+    out << "uint32_t cycleStart;\n";
+
+    out << "\nvoid startTrack(Track& track) {\n";
+    out << "  track.segment = 0;\n";
+    out << "  track.t1 = track.startMs;\n";
+    out << "  track.t2 = track.t1 + " << stepReader(plan.stepBytes) << "(&track.steps[0]);\n";
+    out << "}\n";
+
+    out << "\nvoid setup() {\n";
+    out << "  for (uint8_t t = 0; t < TRACKS; t++) {\n";
+    out << "    for (uint8_t c = 0; c < tracks[t].channels; c++) pinMode(tracks[t].pins[c], OUTPUT);\n";
+    out << "    startTrack(tracks[t]);\n";
+    out << "  }\n";
+    out << "  cycleStart = millis();\n";
+    out << "}\n";
+
+    out << "\n// One pass per tick: each track moves its cursor and works out the position within the\n";
+    out << "// segment once, then every channel on it only interpolates its own row.\n";
+    out << "void loop() {\n";
+    out << "  uint32_t elapsed = millis() - cycleStart;\n";
+    out << "  if (elapsed >= TOTAL_MS) {\n";
+    out << "    // Wrap to the start; after a long stall resynchronise instead of replaying.\n";
+    out << "    cycleStart += TOTAL_MS;\n";
+    out << "    elapsed -= TOTAL_MS;\n";
+    out << "    if (elapsed >= TOTAL_MS) {\n";
+    out << "      cycleStart = millis();\n";
+    out << "      elapsed = 0;\n";
+    out << "    }\n";
+    out << "    for (uint8_t t = 0; t < TRACKS; t++) startTrack(tracks[t]);\n";
+    out << "  }\n\n";
+    out << "  for (uint8_t t = 0; t < TRACKS; t++) {\n";
+    out << "    Track& track = tracks[t];\n";
+    out << "    while (track.segment < track.points - 2 && elapsed >= track.t2) {\n";
+    out << "      track.segment++;\n";
+    out << "      track.t1 = track.t2;\n";
+    out << "      track.t2 += " << stepReader(plan.stepBytes) << "(&track.steps[track.segment]);\n";
+    out << "    }\n";
+    out << "    // Q16 fraction of the segment; one division for all channels of the track.\n";
+    out << "    uint32_t fraction = 0;\n";
+    out << "    if (elapsed >= track.t2) {\n";
+    out << "      fraction = 65536;\n";
+    out << "    } else if (elapsed > track.t1) {\n";
+    if (plan.stepBytes == 4) {
+        out << "      fraction = (uint32_t)(((uint64_t)(elapsed - track.t1) << 16) / (track.t2 - track.t1));\n";
+    } else {
+        out << "      fraction = ((elapsed - track.t1) << 16) / (track.t2 - track.t1);\n";
+    }
+    out << "    }\n";
+    out << "    const uint8_t* row = track.values + track.segment;\n";
+    out << "    for (uint8_t c = 0; c < track.channels; c++, row += track.points) {\n";
+    out << "      int16_t v1 = pgm_read_byte(row);\n";
+    out << "      int16_t v2 = pgm_read_byte(row + 1);\n";
+    out << "      analogWrite(track.pins[c], v1 + (int16_t)(((int32_t)(v2 - v1) * (int32_t)fraction + 0x8000) >> 16));\n";
+    out << "    }\n";
+    out << "  }\n";
+    if (options.tickMs > 0) out << "  delay(" << options.tickMs << ");\n";
+    out << "}\n";
+}
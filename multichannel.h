@@ -0,0 +1,47 @@
+#pragma once
+
+#include "codegen.h"
+#include "curve.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// One motor of a rig: a curve and the PWM pin it drives.
+struct Channel {
+    int pin = 10;
+    CurveView points;
+};
+
+// Channels that share one time table. Each member has a row of PWM values, one per time.
+struct ChannelTrack {
+    std::vector<size_t> channels;              // indices into the planned channels
+    std::vector<int> pins;
+    std::vector<uint32_t> times;               // milliseconds, at least two
+    std::vector<std::vector<uint8_t>> values;  // per member
+};
+
+// How a set of channels is stored in flash. Tables hold the first time of a track and then
+// millisecond steps, all of the same width.
+struct ChannelPlan {
+    std::vector<ChannelTrack> tracks;  // the shared time base first, then channels on their own
+    unsigned stepBytes = 1;            // width of every time step: 1, 2 or 4
+    uint32_t totalMs = 1;              // the cycle, up to the last time of any track
+    size_t flashBytes = 0;             // all curve tables
+    size_t largestArray = 0;           // biggest single table
+    size_t separateBytes = 0;          // the same channels as one single-channel sketch each
+};
+
+// Simplifies the channels together: a time is kept when any channel on the shared base lies
+// farther than `tolerance` (percent duty, vertically) from its chord, so breakpoints that the
+// channels have in common are stored once. A channel that would cost more sampled at every shared
+// time than with its own breakpoints is moved to a track of its own. separateBytes is what the
+// single-channel exporter with `options` would need for each channel, simplified alone.
+ChannelPlan planChannels(const std::vector<Channel>& channels, float tolerance, const CodeOptions& options);
+
+// Writes a sketch that plays every track with one segment cursor, computes the position within
+// the segment once per track and tick, and then updates all its outputs. Only the format, the
+// tick and the symbol prefix of `options` apply; the tables are always delta times and plain
+// PWM rows.
+void writeMultiChannelCode(std::ostream& out, const ChannelPlan& plan, const CodeOptions& options = {});
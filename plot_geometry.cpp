@@ -0,0 +1,117 @@
+#include "plot_geometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool PlotGeometryCache::update(CurveView points, uint64_t revision,
+                               const PlotViewport& viewport) {
+    if (valid && revision == cachedRevision && viewport == cachedViewport) return false;
+    cachedViewport = viewport;
+    cachedRevision = revision;
+    valid = true;
+    rebuild(points);
+    selectionValid = false;
+    return true;
+}
+
+ScreenPoint PlotGeometryCache::toScreen(CurveView points, size_t i) const {
+    const PlotViewport& view = cachedViewport;
+    return {points.x(i) * (view.width / view.timeScale), view.height - points.y(i) * (view.height / 100.0f)};
+}
+
+size_t PlotGeometryCache::cellAt(const ScreenPoint& sp) const {
+    float cell = cachedViewport.handleRadius;
+    size_t cx = static_cast<size_t>(std::clamp(sp.x / cell + 1, 0.0f, static_cast<float>(gridWidth - 1)));
+    size_t cy = static_cast<size_t>(std::clamp(sp.y / cell + 1, 0.0f, static_cast<float>(gridHeight - 1)));
+    return cy * gridWidth + cx;
+}
+
+void PlotGeometryCache::rebuild(CurveView points) {
+    line.clear();
+    lineIndices.clear();
+    handleIndices.clear();
+    handlePoints.clear();
+    vertexHandles.clear();
+    visibleCount = 0;
+    const PlotViewport& view = cachedViewport;
+    if (points.empty() || view.width <= 0 || view.timeScale <= 0) return;
+
+    float scaleX = view.width / view.timeScale;
+
+    size_t first = points.lowerBound(0.0f);
+    size_t last = points.upperBound(view.timeScale);
+    visibleCount = last - first;
+    // One point beyond each edge, so the line runs to the border of the plot.
+    if (first > 0) --first;
+    if (last < points.size()) ++last;
+
+    // Sparse curves are drawn as they are.
+    size_t columns = static_cast<size_t>(view.width) + 1;
+    if (last - first <= 4 * columns) {
+        for (size_t i = first; i < last; ++i) lineIndices.push_back(i);
+    } else {
+        for (size_t i = first; i < last;) {
+            // Column boundaries come from a binary search, so the scan only compares duty values.
+            float columnEnd = (std::floor(points.x(i) * scaleX) + 1) / scaleX;
+            size_t end = points.lowerBound(columnEnd, i + 1, last);
+            size_t lowest = i, highest = i;
+            float low = points.y(i), high = low;
+            for (size_t j = i + 1; j < end; ++j) {
+                float y = points.y(j);
+                bool below = y < low, above = y > high;
+                low = below ? y : low;
+                lowest = below ? j : lowest;
+                high = above ? y : high;
+                highest = above ? j : highest;
+            }
+            size_t keep[4] = {i, std::min(lowest, highest), std::max(lowest, highest), end - 1};
+            for (size_t k = 0; k < 4; ++k) {
+                if (k == 0 || keep[k] != keep[k - 1]) lineIndices.push_back(keep[k]);
+            }
+            i = end;
+        }
+    }
+    for (size_t i : lineIndices) line.push_back(toScreen(points, i));
+
+    // Handles come from the drawn vertices, one per handle-sized grid cell, so dense or
+    // zigzagging stretches show a bounded number of handles that do not pile up.
+    float cell = view.handleRadius;
+    if (cell <= 0) {
+        handleIndices = lineIndices;
+        handlePoints = line;
+        for (size_t k = 0; k < lineIndices.size(); ++k) vertexHandles.push_back(static_cast<uint32_t>(k));
+        return;
+    }
+    gridWidth = static_cast<size_t>(view.width / cell) + 3;
+    gridHeight = static_cast<size_t>(view.height / cell) + 3;
+    cellHandles.assign(gridWidth * gridHeight, 0);
+    for (size_t k = 0; k < lineIndices.size(); ++k) {
+        const ScreenPoint& sp = line[k];
+        uint32_t& handle = cellHandles[cellAt(sp)];
+        if (!handle) {
+            handleIndices.push_back(lineIndices[k]);
+            handlePoints.push_back(sp);
+            handle = static_cast<uint32_t>(handleIndices.size());
+        }
+        vertexHandles.push_back(handle - 1);
+    }
+}
+
+const std::vector<uint8_t>& PlotGeometryCache::selectedHandles(CurveView points, const PointSelection& selection) {
+    if (selectionValid && selectionRevision == selection.revision()) return handleSelected;
+    selectionValid = true;
+    selectionRevision = selection.revision();
+    handleSelected.assign(handleIndices.size(), 0);
+    if (lineIndices.empty()) return handleSelected;
+
+    // A point stands behind the handle of its own cell; where no handle was drawn there it
+    // belongs to the line vertex before it, which starts its pixel column.
+    bool grid = cachedViewport.handleRadius > 0;
+    size_t k = 0;
+    selection.forEachSelected(lineIndices.front(), lineIndices.back() + 1, [&](size_t i) {
+        while (k + 1 < lineIndices.size() && lineIndices[k + 1] <= i) ++k;
+        uint32_t handle = grid ? cellHandles[cellAt(toScreen(points, i))] : 0;
+        handleSelected[handle ? handle - 1 : vertexHandles[k]] = 1;
+    });
+    return handleSelected;
+}
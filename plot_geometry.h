@@ -0,0 +1,70 @@
+#pragma once
+
+#include "curve.h"
+#include "selection.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ScreenPoint {
+    float x, y;
+};
+
+// What the geometry depends on besides the curve. Positions are relative to the plot's top-left
+// corner, so moving the window only translates the cached geometry.
+struct PlotViewport {
+    float width = 0;       // pixels
+    float height = 0;
+    float timeScale = 1;   // seconds across the full width
+    float handleRadius = 0;
+
+    bool operator==(const PlotViewport& other) const {
+        return width == other.width && height == other.height && timeScale == other.timeScale &&
+               handleRadius == other.handleRadius;
+    }
+};
+
+// Screen-space geometry of the plot, kept until the curve revision or the viewport changes.
+class PlotGeometryCache {
+public:
+    // Returns true if the geometry was rebuilt.
+    bool update(CurveView points, uint64_t revision, const PlotViewport& viewport);
+
+    // Polyline through the visible part of the curve plus one point either side. Where several
+    // points share a pixel column only the first, lowest, highest and last are kept, which
+    // rasterizes to the same pixels and keeps every peak.
+    const std::vector<ScreenPoint>& polyline() const { return line; }
+
+    // Points that get a handle: drawn vertices, at most one per handle-sized cell, so handles
+    // that would overlap are hidden.
+    const std::vector<size_t>& handles() const { return handleIndices; }
+    const std::vector<ScreenPoint>& handlePositions() const { return handlePoints; }
+
+    // Per handle, whether it stands for a selected point: its own, or one hidden in its cell or
+    // decimated out of the line there. Kept until the selection or the geometry changes.
+    const std::vector<uint8_t>& selectedHandles(CurveView points, const PointSelection& selection);
+
+    // Points between the first and last visible, before decimation.
+    size_t visiblePoints() const { return visibleCount; }
+
+private:
+    void rebuild(CurveView points);
+    ScreenPoint toScreen(CurveView points, size_t i) const;
+    size_t cellAt(const ScreenPoint& sp) const;
+
+    std::vector<ScreenPoint> line;
+    std::vector<size_t> lineIndices;
+    std::vector<uint32_t> cellHandles;    // per grid cell, 1 + the handle drawn there, or 0
+    std::vector<uint32_t> vertexHandles;  // per line vertex, the handle that stands for it
+    size_t gridWidth = 0, gridHeight = 0;
+    std::vector<size_t> handleIndices;
+    std::vector<ScreenPoint> handlePoints;
+    std::vector<uint8_t> handleSelected;
+    uint64_t selectionRevision = 0;
+    bool selectionValid = false;
+    size_t visibleCount = 0;
+    PlotViewport cachedViewport;
+    uint64_t cachedRevision = 0;
+    bool valid = false;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+// The parts of an editor frame that are timed separately. Grid is part of Plot.
+enum class ProfileStage { Frame, Plot, Grid, Simplify, Render, Count };
+
+inline const char* profileStageName(ProfileStage stage) {
+    switch (stage) {
+    case ProfileStage::Frame: return "Frame";
+    case ProfileStage::Plot: return "Plot";
+    case ProfileStage::Grid: return "Grid";
+    case ProfileStage::Simplify: return "Simplify";
+    case ProfileStage::Render: return "Render";
+    case ProfileStage::Count: break;
+    }
+    return "";
+}
+
+// CPU milliseconds per stage over the last HISTORY drawn frames. A stage timed several times in
+// one frame adds up. Fixed arrays, so recording costs no allocation.
+class FrameProfiler {
+public:
+    static constexpr int HISTORY = 120;
+    static constexpr int STAGES = static_cast<int>(ProfileStage::Count);
+
+    // Starts a new frame, overwriting the oldest one.
+    void beginFrame() {
+        current = (current + 1) % HISTORY;
+        for (auto& stage : samples) stage[current] = 0;
+    }
+
+    void add(ProfileStage stage, float ms) { samples[static_cast<int>(stage)][current] += ms; }
+
+    // The stage's samples as a ring starting at oldest(), as ImGui::PlotLines takes them.
+    const float* history(ProfileStage stage) const { return samples[static_cast<int>(stage)]; }
+    int oldest() const { return (current + 1) % HISTORY; }
+
+    float last(ProfileStage stage) const { return samples[static_cast<int>(stage)][current]; }
+    float worst(ProfileStage stage) const {
+        const float* s = history(stage);
+        return *std::max_element(s, s + HISTORY);
+    }
+    float average(ProfileStage stage) const {
+        const float* s = history(stage);
+        float sum = 0;
+        for (int i = 0; i < HISTORY; ++i) sum += s[i];
+        return sum / HISTORY;
+    }
+
+private:
+    float samples[STAGES][HISTORY] = {};
+    int current = HISTORY - 1;
+};
+
+// Adds the time until the end of the scope to a stage of the current frame.
+class ScopedTimer {
+public:
+    ScopedTimer(FrameProfiler& profiler, ProfileStage stage)
+        : profiler(profiler), stage(stage), start(std::chrono::steady_clock::now()) {}
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    ~ScopedTimer() {
+        profiler.add(stage, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    FrameProfiler& profiler;
+    ProfileStage stage;
+    std::chrono::steady_clock::time_point start;
+};
@@ -0,0 +1,219 @@
+// RdpSimplifier and SimplifyCache against the recursive rdpSimplify they replaced, which is kept
+// here as the reference: both must keep exactly the points it keeps, on random curves and on
+// degenerate ones, and the cache also after points are added, deleted and dragged to a new time.
+#include "curve.h"
+#include "simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The editor's original implementation, unchanged.
+float referenceDistance(const DataPoint& p, const DataPoint& a, const DataPoint& b) {
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    if (dx == 0 && dy == 0) return std::sqrt(std::pow(p.x - a.x, 2) + std::pow(p.y - a.y, 2));
+    float t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / (dx * dx + dy * dy);
+    t = std::max(0.0f, std::min(1.0f, t));
+    return std::sqrt(std::pow(p.x - (a.x + t * dx), 2) + std::pow(p.y - (a.y + t * dy), 2));
+}
+
+// The vertical metric the editor's tolerance uses came later; it shares the recursion.
+void referenceRdp(const std::vector<DataPoint>& points, float epsilon, std::vector<DataPoint>& out,
+                  DistanceMetric metric = DistanceMetric::Perpendicular) {
+    if (points.size() < 3) {
+        out = points;
+        return;
+    }
+
+    float maxDist = 0;
+    size_t index = 0;
+    for (size_t i = 1; i < points.size() - 1; ++i) {
+        float d = metric == DistanceMetric::Vertical ? verticalDistance(points[i], points.front(), points.back())
+                                                     : referenceDistance(points[i], points.front(), points.back());
+        if (d > maxDist) {
+            index = i;
+            maxDist = d;
+        }
+    }
+
+    if (maxDist > epsilon) {
+        std::vector<DataPoint> left, right;
+        std::vector<DataPoint> leftIn(points.begin(), points.begin() + index + 1);
+        std::vector<DataPoint> rightIn(points.begin() + index, points.end());
+        referenceRdp(leftIn, epsilon, left, metric);
+        referenceRdp(rightIn, epsilon, right, metric);
+        out = left;
+        out.insert(out.end(), right.begin() + 1, right.end());
+    } else {
+        out = {points.front(), points.back()};
+    }
+}
+
+bool samePoints(const std::vector<DataPoint>& a, const std::vector<DataPoint>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const DataPoint& p, const DataPoint& q) {
+        return p.x == q.x && p.y == q.y;
+    });
+}
+
+size_t failures = 0;
+
+void check(const std::string& name, const std::vector<DataPoint>& points, float epsilon) {
+    std::vector<DataPoint> expected, iterative;
+    referenceRdp(points, epsilon, expected);
+    rdpSimplify(points, epsilon, iterative);
+    SimplifyCache cache;
+    const std::vector<DataPoint>& cached = cache.get(points, epsilon, 1);
+    const char* failed = nullptr;
+    if (!samePoints(expected, iterative)) {
+        failed = "rdpSimplify";
+    } else if (!samePoints(expected, cached)) {
+        failed = "SimplifyCache";
+    } else {
+        return;
+    }
+    if (++failures <= 10) {
+        std::printf("FAIL %s, %zu points, epsilon %g: %s differs from the recursive reference\n", name.c_str(),
+            points.size(), epsilon, failed);
+    }
+}
+
+// Adds and deletes random points of `points`, one at a time as the editor does, and checks the
+// cache kept up to date by pointInserted and pointErased after every step.
+void checkEdits(const std::string& name, std::vector<DataPoint> points, float epsilon, DistanceMetric metric,
+                std::mt19937& rng) {
+    SimplifyCache cache;
+    uint64_t revision = 1;
+    cache.sync(points, epsilon, revision, metric);
+    std::uniform_real_distribution<float> value(0.0f, 100.0f), unit(-0.1f, 1.1f);
+    const char* metricName = metric == DistanceMetric::Vertical ? "vertical" : "perpendicular";
+    for (int step = 0; step < 40; ++step) {
+        // Inserts land anywhere, before the first point and after the last one included; every
+        // other one on a coarse grid, so that it ties with existing points.
+        bool insert = points.size() < 2 || rng() % 2;
+        size_t index;
+        if (insert) {
+            float span = points.empty() ? 1.0f : points.back().x - points.front().x;
+            float start = points.empty() ? 0.0f : points.front().x;
+            DataPoint added{start + unit(rng) * span, value(rng)};
+            if (step % 4 < 2) added = {std::round(added.x * 40.0f) / 40.0f, std::round(added.y)};
+            auto at = std::upper_bound(points.begin(), points.end(), added.x,
+                [](float t, const DataPoint& p) { return t < p.x; });
+            index = static_cast<size_t>(at - points.begin());
+            points.insert(at, added);
+            cache.pointInserted(points, index, revision);
+        } else {
+            index = rng() % points.size();
+            points.erase(points.begin() + static_cast<std::ptrdiff_t>(index));
+            cache.pointErased(points, index, revision);
+        }
+
+        std::vector<DataPoint> expected;
+        referenceRdp(points, epsilon, expected, metric);
+        if (samePoints(expected, cache.get(points, epsilon, revision, metric))) continue;
+        if (++failures <= 10) {
+            std::printf("FAIL %s, %zu points, epsilon %g, %s: SimplifyCache differs from the recursive reference "
+                        "after point %zu was %s\n", name.c_str(), points.size(), epsilon, metricName, index,
+                insert ? "added" : "deleted");
+        }
+        return;
+    }
+}
+
+// Drags random points of `points` to a new time, as the editor does, and checks the cache kept
+// up to date by pointRelocated after every step.
+void checkDrags(const std::string& name, std::vector<DataPoint> points, float epsilon, std::mt19937& rng) {
+    if (points.size() < 3) return;
+    SimplifyCache cache;
+    uint64_t revision = 1;
+    cache.sync(points, epsilon, revision);
+    std::uniform_int_distribution<size_t> pick(0, points.size() - 1);
+    std::uniform_real_distribution<float> value(0.0f, 100.0f), unit(0.0f, 1.0f);
+    for (int step = 0; step < 40; ++step) {
+        size_t from = pick(rng);
+        DataPoint moved = points[from];
+        // Half the drags pass a neighbour, the rest land anywhere on the curve.
+        float x = step % 2 ? points.front().x + unit(rng) * (points.back().x - points.front().x)
+                           : points[std::min(from + 1, points.size() - 1)].x + 0.001f;
+        moved = {x, step % 3 ? value(rng) : moved.y};
+        points.erase(points.begin() + static_cast<std::ptrdiff_t>(from));
+        auto at = std::upper_bound(points.begin(), points.end(), moved.x,
+            [](float t, const DataPoint& p) { return t < p.x; });
+        size_t to = static_cast<size_t>(at - points.begin());
+        points.insert(at, moved);
+        if (to == from) {
+            cache.pointMoved(points, to, revision);
+        } else {
+            cache.pointRelocated(points, from, to, revision);
+        }
+
+        std::vector<DataPoint> expected;
+        referenceRdp(points, epsilon, expected);
+        if (samePoints(expected, cache.get(points, epsilon, revision))) continue;
+        if (++failures <= 10) {
+            std::printf("FAIL %s, %zu points, epsilon %g: SimplifyCache differs from the recursive reference "
+                        "after point %zu was dragged to %zu\n", name.c_str(), points.size(), epsilon, from, to);
+        }
+        return;
+    }
+}
+
+}  // namespace
+
+int main() {
+    size_t cases = 0;
+    auto run = [&](const std::string& name, const std::vector<DataPoint>& points) {
+        for (float epsilon : {0.0f, 0.01f, 0.5f, 5.0f, 1000.0f}) {
+            check(name, points, epsilon);
+            ++cases;
+        }
+    };
+
+    run("empty", {});
+    run("one point", {{0.0f, 50.0f}});
+    run("two points", {{0.0f, 10.0f}, {1.0f, 90.0f}});
+    run("two points at one time", {{0.5f, 10.0f}, {0.5f, 90.0f}});
+    run("identical points", std::vector<DataPoint>(20, DataPoint{0.25f, 40.0f}));
+    run("duplicate times", {{0.0f, 0.0f}, {0.2f, 10.0f}, {0.2f, 80.0f}, {0.2f, 30.0f}, {0.6f, 30.0f}, {0.6f, 5.0f},
+                            {1.0f, 50.0f}});
+    std::vector<DataPoint> line, flat;
+    for (int i = 0; i < 50; ++i) {
+        line.push_back({static_cast<float>(i) * 0.1f, 2.0f * static_cast<float>(i)});
+        flat.push_back({static_cast<float>(i) * 0.1f, 25.0f});
+    }
+    run("collinear", line);
+    run("flat", flat);
+
+    // Random walks, some on a coarse grid so that ties and repeated times are common.
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<size_t> sizes(0, 400);
+    std::uniform_real_distribution<float> step(-5.0f, 5.0f), gap(0.0f, 0.05f);
+    for (int curve = 0; curve < 3000; ++curve) {
+        bool grid = curve % 3 == 0;
+        std::vector<DataPoint> points(sizes(rng));
+        float x = 0, y = 50;
+        for (DataPoint& p : points) {
+            x += grid ? std::round(gap(rng) * 40.0f) / 40.0f : gap(rng);
+            y = std::clamp(y + (grid ? std::round(step(rng)) : step(rng)), 0.0f, 100.0f);
+            p = {x, y};
+        }
+        run("random " + std::to_string(curve), points);
+        if (curve % 10 == 0) {
+            for (float epsilon : {0.0f, 0.5f, 5.0f}) {
+                checkDrags("dragged " + std::to_string(curve), points, epsilon, rng);
+                for (DistanceMetric metric : {DistanceMetric::Perpendicular, DistanceMetric::Vertical}) {
+                    checkEdits("edited " + std::to_string(curve), points, epsilon, metric, rng);
+                }
+                cases += 3;
+            }
+        }
+    }
+
+    std::printf("%zu of %zu simplifications match the recursive reference\n", cases - failures, cases);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,122 @@
+#include "selection.h"
+
+#include <algorithm>
+
+int pickPoint(CurveView points, const DataPoint& at, PlotScale scale, float radius) {
+    size_t split = points.lowerBound(at.x);
+
+    // Walk outwards from the click time; a side is done once its time distance alone is no
+    // closer than the best hit, so dense curves only touch the points near the cursor.
+    int best = -1;
+    float bestDist = radius * radius;
+    auto consider = [&](size_t i) {
+        float dx = (points.x(i) - at.x) * scale.x;
+        float dy = (points.y(i) - at.y) * scale.y;
+        float dist = dx * dx + dy * dy;
+        // Ties go to the lower index, as in a front-to-back scan.
+        if (dist < bestDist || (dist == bestDist && best >= 0 && i < static_cast<size_t>(best))) {
+            bestDist = dist;
+            best = static_cast<int>(i);
+        }
+        return dx * dx <= bestDist;
+    };
+    size_t left = split, right = split;
+    bool goLeft = left > 0, goRight = right < points.size();
+    while (goLeft || goRight) {
+        if (goLeft) goLeft = consider(--left) && left > 0;
+        if (goRight) goRight = consider(right++) && right < points.size();
+    }
+    return best;
+}
+
+void PointSelection::reset(size_t pointCount) {
+    ++changes;
+    flags.assign(pointCount, 0);
+    selectedCount = 0;
+    spanBegin = spanEnd = 0;
+}
+
+void PointSelection::clear() {
+    ++changes;
+    std::fill(flags.begin() + spanBegin, flags.begin() + spanEnd, 0);
+    selectedCount = 0;
+    spanBegin = spanEnd = 0;
+}
+
+void PointSelection::pointInserted(size_t index) {
+    ++changes;
+    flags.insert(flags.begin() + index, 0);
+    if (index < spanBegin) ++spanBegin;
+    if (index < spanEnd) ++spanEnd;
+}
+
+void PointSelection::pointErased(size_t index) {
+    ++changes;
+    if (flags[index]) --selectedCount;
+    flags.erase(flags.begin() + index);
+    if (index < spanBegin) --spanBegin;
+    if (index < spanEnd) --spanEnd;
+    if (selectedCount == 0) spanBegin = spanEnd = 0;
+}
+
+void PointSelection::pointMoved(size_t from, size_t to) {
+    if (from == to) return;
+    ++changes;
+    uint8_t flag = flags[from];
+    if (from < to) {
+        std::copy(flags.begin() + from + 1, flags.begin() + to + 1, flags.begin() + from);
+    } else {
+        std::copy_backward(flags.begin() + to, flags.begin() + from, flags.begin() + from + 1);
+    }
+    flags[to] = flag;
+    // The span may now include or exclude the moved point; widening it is always safe.
+    if (selectedCount > 0) {
+        spanBegin = std::min({spanBegin, from, to});
+        spanEnd = std::max({spanEnd, from + 1, to + 1});
+    }
+}
+
+size_t PointSelection::selectBox(CurveView points, DataPoint min, DataPoint max) {
+    clear();
+    flags.resize(points.size(), 0);
+    size_t first = points.lowerBound(min.x);
+
+    for (size_t i = first; i < points.size() && points.x(i) <= max.x; ++i) {
+        if (points.y(i) < min.y || points.y(i) > max.y) continue;
+        if (selectedCount == 0) spanBegin = i;
+        flags[i] = 1;
+        spanEnd = i + 1;
+        ++selectedCount;
+    }
+    return selectedCount;
+}
+
+std::vector<size_t> PointSelection::indicesDescending() const {
+    std::vector<size_t> indices;
+    indices.reserve(selectedCount);
+    for (size_t i = spanEnd; i-- > spanBegin;) {
+        if (flags[i]) indices.push_back(i);
+    }
+    return indices;
+}
+
+size_t PointSelection::eraseSelected(std::vector<DataPoint>& points) {
+    size_t removed = selectedCount;
+    if (removed == 0) return 0;
+    size_t out = spanBegin;
+    for (size_t i = spanBegin; i < points.size(); ++i) {
+        if (i < spanEnd && flags[i]) continue;
+        points[out++] = points[i];
+    }
+    points.resize(out);
+    reset(points.size());
+    return removed;
+}
+
+size_t PointSelection::eraseSelected(CurveStore& points) {
+    size_t removed = selectedCount;
+    if (removed == 0) return 0;
+    points.eraseIf([this](size_t i) { return i < spanEnd && flags[i]; }, spanBegin);
+    reset(points.size());
+    return removed;
+}
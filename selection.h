@@ -0,0 +1,64 @@
+#pragma once
+
+#include "curve.h"
+#include "curve_store.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pixels per data unit on each axis of the plot, so hit tests can be done in screen distance.
+struct PlotScale {
+    float x = 1.0f;
+    float y = 1.0f;
+};
+
+// Index of the point nearest to `at` within `radius` pixels, or -1. Points are sorted by time,
+// so only the time window the radius covers is searched: O(log n + k).
+int pickPoint(CurveView points, const DataPoint& at, PlotScale scale, float radius);
+
+// Selection flags kept parallel to the sorted point array. Lookups are O(1), and edits mirror
+// the point edits so the flags follow their points instead of their old indices.
+class PointSelection {
+public:
+    bool selected(size_t index) const { return index < flags.size() && flags[index]; }
+    size_t count() const { return selectedCount; }
+    bool empty() const { return selectedCount == 0; }
+    // Bumped by every change, so views of the selection know when to refresh.
+    uint64_t revision() const { return changes; }
+
+    // Calls fn(index) for each selected index in [first, last), ascending. O(span) where the
+    // span is what lies between the first and last selected point.
+    template <typename Fn>
+    void forEachSelected(size_t first, size_t last, Fn&& fn) const {
+        for (size_t i = std::max(first, spanBegin); i < std::min(last, spanEnd); ++i) {
+            if (flags[i]) fn(i);
+        }
+    }
+
+    // Resets to `pointCount` unselected points, for wholesale replacement of the curve.
+    void reset(size_t pointCount);
+    void clear();
+
+    void pointInserted(size_t index);
+    void pointErased(size_t index);
+    void pointMoved(size_t from, size_t to);
+
+    // Replaces the selection with the points inside the data-space box. O(log n + k) plus
+    // clearing the previous selection's index span.
+    size_t selectBox(CurveView points, DataPoint min, DataPoint max);
+
+    // Selected indices in descending order, the order in which erasing them one by one is safe.
+    std::vector<size_t> indicesDescending() const;
+
+    // Removes every selected point in one pass and clears the selection.
+    size_t eraseSelected(std::vector<DataPoint>& points);
+    size_t eraseSelected(CurveStore& points);
+
+private:
+    std::vector<uint8_t> flags;
+    size_t selectedCount = 0;
+    size_t spanBegin = 0, spanEnd = 0;  // all set flags lie in [spanBegin, spanEnd)
+    uint64_t changes = 0;
+};
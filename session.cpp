@@ -0,0 +1,632 @@
+#include "session.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char SESSION_MAGIC[8] = {'M', 'C', 'S', 'E', 'S', 'S', 'N', '\x1a'};
+constexpr uint32_t SESSION_VERSION = 1;
+constexpr uint64_t ARRAY_ALIGNMENT = 64;
+// Below this the journal is left to grow: rewriting a small snapshot on every autosave would
+// cost more than replaying a few records.
+constexpr uint64_t MIN_COMPACTION_JOURNAL = 1 << 20;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t channelCount;
+    uint64_t settingsOffset;
+    uint64_t settingsBytes;
+    uint64_t journalOffset;
+    uint64_t reserved;
+};
+
+struct ChannelEntry {
+    int32_t pin;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t xsOffset;
+    uint64_t ysOffset;
+};
+
+enum RecordType : uint32_t {
+    RECORD_SPLICE = 1,
+    RECORD_SETTINGS = 2,
+};
+
+struct RecordHeader {
+    uint32_t type;
+    uint32_t bytes;  // of the payload
+    uint32_t crc;    // CRC-32 of the payload
+    uint32_t reserved;
+};
+
+// Followed by `count` times and `count` duties.
+struct SplicePayload {
+    uint32_t channel;
+    uint32_t reserved;
+    uint64_t first;
+    uint64_t removed;
+    uint64_t count;
+};
+
+static_assert(sizeof(FileHeader) == 48 && sizeof(ChannelEntry) == 32 && sizeof(RecordHeader) == 16 &&
+                  sizeof(SplicePayload) == 32,
+              "session structures are written as they are laid out");
+
+enum SettingTag : uint16_t {
+    TAG_LANGUAGE = 1,
+    TAG_TIME_SCALE,
+    TAG_SIMPLIFIER,
+    TAG_TOLERANCE,
+    TAG_BUDGET_MODE,
+    TAG_POINT_BUDGET,
+    TAG_WAVE_SHAPE,
+    TAG_WAVE_AMPLITUDE,
+    TAG_WAVE_FREQUENCY,
+    TAG_WAVE_DENSITY,
+    TAG_WAVE_APPEND,
+    TAG_WAVE_RAMP,
+    TAG_WAVE_END_FREQUENCY,
+    TAG_PLAYER,
+    TAG_TICK_MS,
+    TAG_LOOKUP_SHIFT,
+    TAG_ENCODING,
+    TAG_BOARD,
+    TAG_ACTIVE_CHANNEL,
+};
+
+// Reflected CRC-32 (IEEE), as zlib computes it.
+uint32_t crc32(uint32_t crc, const void* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) c = c & 1 ? 0xEDB88320u ^ c >> 1 : c >> 1;
+            entries[i] = c;
+        }
+        return entries;
+    }();
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) crc = table[(crc ^ bytes[i]) & 0xFF] ^ crc >> 8;
+    return ~crc;
+}
+
+uint64_t alignUp(uint64_t offset) { return (offset + ARRAY_ALIGNMENT - 1) / ARRAY_ALIGNMENT * ARRAY_ALIGNMENT; }
+
+void putField(std::vector<uint8_t>& out, uint16_t tag, const void* value, size_t size) {
+    uint16_t length = static_cast<uint16_t>(size);
+    size_t at = out.size();
+    out.resize(at + 4 + size);
+    std::memcpy(&out[at], &tag, 2);
+    std::memcpy(&out[at + 2], &length, 2);
+    std::memcpy(&out[at + 4], value, size);
+}
+
+template <typename T>
+void putField(std::vector<uint8_t>& out, uint16_t tag, T value) {
+    putField(out, tag, &value, sizeof(value));
+}
+
+void encodeSettings(const SessionSettings& settings, std::vector<uint8_t>& out) {
+    out.clear();
+    putField(out, TAG_LANGUAGE, static_cast<uint32_t>(settings.language));
+    putField(out, TAG_TIME_SCALE, settings.timeScale);
+    putField(out, TAG_SIMPLIFIER, static_cast<uint32_t>(settings.simplifier));
+    putField(out, TAG_TOLERANCE, settings.toleranceCounts);
+    putField(out, TAG_BUDGET_MODE, static_cast<uint8_t>(settings.budgetMode));
+    putField(out, TAG_POINT_BUDGET, static_cast<int32_t>(settings.pointBudget));
+    putField(out, TAG_WAVE_SHAPE, static_cast<uint32_t>(settings.wave.shape));
+    putField(out, TAG_WAVE_AMPLITUDE, settings.wave.amplitude);
+    putField(out, TAG_WAVE_FREQUENCY, settings.wave.frequency);
+    putField(out, TAG_WAVE_DENSITY, settings.wave.density);
+    putField(out, TAG_WAVE_APPEND, static_cast<uint8_t>(settings.wave.append));
+    putField(out, TAG_WAVE_RAMP, settings.wave.rampFraction);
+    putField(out, TAG_WAVE_END_FREQUENCY, settings.wave.endFrequency);
+    putField(out, TAG_PLAYER, static_cast<uint32_t>(settings.player));
+    putField(out, TAG_TICK_MS, static_cast<uint32_t>(settings.tickMs));
+    putField(out, TAG_LOOKUP_SHIFT, static_cast<uint32_t>(settings.lookupShift));
+    putField(out, TAG_ENCODING, static_cast<uint32_t>(settings.encoding));
+    putField(out, TAG_BOARD, settings.board.data(), std::min<size_t>(settings.board.size(), UINT16_MAX));
+    putField(out, TAG_ACTIVE_CHANNEL, settings.activeChannel);
+}
+
+// Reads a field of the expected size; fields of another size keep the current value.
+template <typename T>
+bool readField(const uint8_t* value, size_t size, T& out) {
+    if (size != sizeof(T)) return false;
+    std::memcpy(&out, value, sizeof(T));
+    return true;
+}
+
+template <typename Enum>
+void readEnum(const uint8_t* value, size_t size, Enum last, Enum& out) {
+    uint32_t raw;
+    if (readField(value, size, raw) && raw <= static_cast<uint32_t>(last)) out = static_cast<Enum>(raw);
+}
+
+void readFlag(const uint8_t* value, size_t size, bool& out) {
+    uint8_t raw;
+    if (readField(value, size, raw)) out = raw != 0;
+}
+
+bool decodeSettings(const uint8_t* data, size_t size, SessionSettings& settings) {
+    size_t at = 0;
+    while (at < size) {
+        if (size - at < 4) return false;
+        uint16_t tag, length;
+        std::memcpy(&tag, data + at, 2);
+        std::memcpy(&length, data + at + 2, 2);
+        if (size - at - 4 < length) return false;
+        const uint8_t* value = data + at + 4;
+        at += 4 + length;
+
+        switch (tag) {
+        case TAG_LANGUAGE: {
+            uint32_t raw;
+            if (readField(value, length, raw) && raw < static_cast<uint32_t>(Language::Count))
+                settings.language = static_cast<Language>(raw);
+            break;
+        }
+        case TAG_TIME_SCALE: readField(value, length, settings.timeScale); break;
+        case TAG_SIMPLIFIER: readEnum(value, length, Simplifier::Visvalingam, settings.simplifier); break;
+        case TAG_TOLERANCE: readField(value, length, settings.toleranceCounts); break;
+        case TAG_BUDGET_MODE: readFlag(value, length, settings.budgetMode); break;
+        case TAG_POINT_BUDGET: {
+            int32_t budget;
+            if (readField(value, length, budget)) settings.pointBudget = budget;
+            break;
+        }
+        case TAG_WAVE_SHAPE: readEnum(value, length, WaveShape::Chirp, settings.wave.shape); break;
+        case TAG_WAVE_AMPLITUDE: readField(value, length, settings.wave.amplitude); break;
+        case TAG_WAVE_FREQUENCY: readField(value, length, settings.wave.frequency); break;
+        case TAG_WAVE_DENSITY: readField(value, length, settings.wave.density); break;
+        case TAG_WAVE_APPEND: readFlag(value, length, settings.wave.append); break;
+        case TAG_WAVE_RAMP: readField(value, length, settings.wave.rampFraction); break;
+        case TAG_WAVE_END_FREQUENCY: readField(value, length, settings.wave.endFrequency); break;
+        case TAG_PLAYER: readEnum(value, length, PlayerKind::Lookup, settings.player); break;
+        case TAG_TICK_MS: {
+            uint32_t tick;
+            if (readField(value, length, tick)) settings.tickMs = tick;
+            break;
+        }
+        case TAG_LOOKUP_SHIFT: {
+            uint32_t shift;
+            if (readField(value, length, shift)) settings.lookupShift = shift;
+            break;
+        }
+        case TAG_ENCODING: readEnum(value, length, TableEncoding::Rle, settings.encoding); break;
+        case TAG_BOARD: settings.board.assign(reinterpret_cast<const char*>(value), length); break;
+        case TAG_ACTIVE_CHANNEL: readField(value, length, settings.activeChannel); break;
+        default: break;  // written by a newer editor
+        }
+    }
+    settings.wave.timeScale = settings.timeScale;
+    return true;
+}
+
+// A file mapped read-only for as long as the object lives.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+    const uint8_t* data() const { return base; }
+    uint64_t size() const { return length; }
+
+private:
+    const uint8_t* base = nullptr;
+    uint64_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path, std::string& error) {
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        error = path + " is empty";
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        error = "Cannot map " + path;
+        close();
+        return false;
+    }
+    base = static_cast<const uint8_t*>(view);
+    length = static_cast<uint64_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (base) UnmapViewOfFile(base);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    base = nullptr;
+    length = 0;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+}
+#else
+bool MappedFile::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "Cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        error = path + " is empty";
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping keeps the file
+    if (view == MAP_FAILED) {
+        error = "Cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    // Channels are read front to back, once.
+    madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    base = static_cast<const uint8_t*>(view);
+    length = static_cast<uint64_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (base) munmap(const_cast<uint8_t*>(base), static_cast<size_t>(length));
+    base = nullptr;
+    length = 0;
+}
+#endif
+
+// Applies a splice record to the channels read so far; false if it does not fit them.
+bool applySplice(const uint8_t* payload, uint32_t bytes, std::vector<SessionCurve>& channels,
+                 std::vector<DataPoint>& span) {
+    SplicePayload splice;
+    if (bytes < sizeof(splice)) return false;
+    std::memcpy(&splice, payload, sizeof(splice));
+    if (splice.channel >= channels.size() || splice.count > (bytes - sizeof(splice)) / (2 * sizeof(float)) ||
+        bytes != sizeof(splice) + splice.count * 2 * sizeof(float))
+        return false;
+    CurveStore& store = channels[splice.channel].points;
+    if (splice.first > store.size() || splice.removed > store.size() - splice.first) return false;
+
+    const uint8_t* xs = payload + sizeof(splice);
+    const uint8_t* ys = xs + splice.count * sizeof(float);
+    span.resize(splice.count);
+    for (size_t i = 0; i < splice.count; ++i) {
+        std::memcpy(&span[i].x, xs + i * sizeof(float), sizeof(float));
+        std::memcpy(&span[i].y, ys + i * sizeof(float), sizeof(float));
+    }
+    store.replace(splice.first, splice.first + splice.removed, span.data(), span.size());
+    return true;
+}
+
+double nanosSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+bool loadSession(const std::string& path, SessionData& session, std::string& error) {
+    MappedFile file;
+    if (!file.open(path, error)) return false;
+    const uint8_t* data = file.data();
+    uint64_t size = file.size();
+
+    FileHeader header;
+    if (size < sizeof(header)) {
+        error = path + " is not a session file";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC)) != 0) {
+        error = path + " is not a session file";
+        return false;
+    }
+    if (header.version > SESSION_VERSION) {
+        error = path + " was saved by a newer version of the editor";
+        return false;
+    }
+    uint64_t snapshotEnd = header.journalOffset;
+    if (snapshotEnd > size || header.channelCount > (snapshotEnd - sizeof(header)) / sizeof(ChannelEntry) ||
+        header.settingsOffset > snapshotEnd || header.settingsBytes > snapshotEnd - header.settingsOffset) {
+        error = path + " is damaged";
+        return false;
+    }
+
+    session = SessionData();
+    if (!decodeSettings(data + header.settingsOffset, static_cast<size_t>(header.settingsBytes), session.settings)) {
+        error = path + " has damaged settings";
+        return false;
+    }
+    session.channels.resize(header.channelCount);
+    for (uint32_t c = 0; c < header.channelCount; ++c) {
+        ChannelEntry entry;
+        std::memcpy(&entry, data + sizeof(header) + c * sizeof(entry), sizeof(entry));
+        uint64_t arrayBytes = entry.count * sizeof(float);
+        if (entry.count > snapshotEnd / sizeof(float) || entry.xsOffset % sizeof(float) != 0 ||
+            entry.ysOffset % sizeof(float) != 0 || entry.xsOffset > snapshotEnd - arrayBytes ||
+            entry.ysOffset > snapshotEnd - arrayBytes) {
+            error = path + " is damaged";
+            return false;
+        }
+        SessionCurve& channel = session.channels[c];
+        channel.pin = entry.pin;
+        // The arrays are aligned in the file and the mapping is page aligned, so they are read in place.
+        channel.points.assign(CurveView(reinterpret_cast<const float*>(data + entry.xsOffset),
+                                        reinterpret_cast<const float*>(data + entry.ysOffset),
+                                        static_cast<size_t>(entry.count)));
+    }
+    session.snapshotBytes = snapshotEnd;
+
+    // Replay the journal; a record cut short by a crash, or damaged, ends it.
+    std::vector<DataPoint> span;
+    uint64_t at = snapshotEnd;
+    while (size - at >= sizeof(RecordHeader)) {
+        RecordHeader record;
+        std::memcpy(&record, data + at, sizeof(record));
+        const uint8_t* payload = data + at + sizeof(record);
+        if (size - at - sizeof(record) < record.bytes || crc32(0, payload, record.bytes) != record.crc) break;
+        if (record.type == RECORD_SPLICE) {
+            if (!applySplice(payload, record.bytes, session.channels, span)) break;
+        } else if (record.type == RECORD_SETTINGS) {
+            SessionSettings settings = session.settings;
+            if (!decodeSettings(payload, record.bytes, settings)) break;
+            session.settings = settings;
+        }
+        at += sizeof(record) + record.bytes;
+        ++session.journalRecords;
+    }
+    session.journalEnd = at;
+
+    for (SessionCurve& channel : session.channels) {
+        channel.points.clearChanges();
+        channel.points.clearUnsaved();
+    }
+    return true;
+}
+
+bool SessionWriter::save(const std::string& path, const SessionSettings& settings,
+                         const std::vector<SessionChannel>& channels, std::string& error) {
+    auto start = std::chrono::steady_clock::now();
+    encodeSettings(settings, scratch);
+
+    FileHeader header{};
+    std::memcpy(header.magic, SESSION_MAGIC, sizeof(SESSION_MAGIC));
+    header.version = SESSION_VERSION;
+    header.channelCount = static_cast<uint32_t>(channels.size());
+    header.settingsOffset = sizeof(header) + channels.size() * sizeof(ChannelEntry);
+    header.settingsBytes = scratch.size();
+    std::vector<ChannelEntry> entries(channels.size());
+    uint64_t offset = header.settingsOffset + header.settingsBytes;
+    for (size_t c = 0; c < channels.size(); ++c) {
+        entries[c].pin = channels[c].pin;
+        entries[c].count = channels[c].points.size();
+        entries[c].xsOffset = offset = alignUp(offset);
+        offset += entries[c].count * sizeof(float);
+        entries[c].ysOffset = offset = alignUp(offset);
+        offset += entries[c].count * sizeof(float);
+    }
+    header.journalOffset = offset;
+
+    std::string temporary = path + ".tmp";
+    std::FILE* out = std::fopen(temporary.c_str(), "wb");
+    if (!out) {
+        error = "Cannot write " + temporary;
+        return false;
+    }
+    uint64_t written = 0;
+    auto put = [&](const void* bytes, size_t size) {
+        if (size > 0 && std::fwrite(bytes, 1, size, out) != size) return false;
+        written += size;
+        return true;
+    };
+    auto padTo = [&](uint64_t target) {
+        static const uint8_t zeros[ARRAY_ALIGNMENT] = {};
+        return put(zeros, static_cast<size_t>(target - written));
+    };
+    auto putArray = [&](const float* values, size_t count, size_t stride) {
+        if (stride == 1) return put(values, count * sizeof(float));
+        // Gathered a block at a time, so a view into an interleaved array needs no full copy.
+        gathered.resize(std::min<size_t>(count, 4096));
+        for (size_t i = 0; i < count; i += gathered.size()) {
+            size_t block = std::min(gathered.size(), count - i);
+            for (size_t k = 0; k < block; ++k) gathered[k] = values[(i + k) * stride];
+            if (!put(gathered.data(), block * sizeof(float))) return false;
+        }
+        return true;
+    };
+
+    bool ok = put(&header, sizeof(header)) && put(entries.data(), entries.size() * sizeof(ChannelEntry)) &&
+              put(scratch.data(), scratch.size());
+    for (size_t c = 0; ok && c < channels.size(); ++c) {
+        const CurveView& points = channels[c].points;
+        ok = padTo(entries[c].xsOffset) && putArray(points.xs, points.size(), points.stride) &&
+             padTo(entries[c].ysOffset) && putArray(points.ys, points.size(), points.stride);
+    }
+    if (std::fclose(out) != 0) ok = false;
+    if (!ok) {
+        error = "Cannot write " + temporary;
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    // The old file stays whole until the new one replaces it in a single rename.
+    bool compacting = file && path == filePath;
+    close();
+    std::error_code failure;
+    std::filesystem::rename(temporary, path, failure);
+    if (failure) {
+        error = "Cannot replace " + path + ": " + failure.message();
+        std::remove(temporary.c_str());
+        return false;
+    }
+    file = std::fopen(path.c_str(), "r+b");
+    if (!file || std::fseek(file, 0, SEEK_END) != 0) {
+        error = "Cannot reopen " + path;
+        close();
+        return false;
+    }
+
+    filePath = path;
+    channelSizes.resize(channels.size());
+    for (size_t c = 0; c < channels.size(); ++c) channelSizes[c] = channels[c].points.size();
+    savedSettings.swap(scratch);
+    size_t compactions = compacting ? current.compactions + 1 : 0;
+    current = SessionStats();
+    current.snapshotBytes = header.journalOffset;
+    current.compactions = compactions;
+    current.lastSnapshotNanos = nanosSince(start);
+    return true;
+}
+
+bool SessionWriter::resume(const std::string& path, const SessionData& session, std::string& error) {
+    close();
+    // Whatever follows the last intact record is a torn append; the next one goes in its place.
+    std::error_code failure;
+    if (std::filesystem::file_size(path, failure) != session.journalEnd) {
+        std::filesystem::resize_file(path, session.journalEnd, failure);
+        if (failure) {
+            error = "Cannot truncate " + path + ": " + failure.message();
+            return false;
+        }
+    }
+    file = std::fopen(path.c_str(), "r+b");
+    if (!file || std::fseek(file, 0, SEEK_END) != 0) {
+        error = "Cannot open " + path + " for writing";
+        close();
+        return false;
+    }
+
+    filePath = path;
+    channelSizes.resize(session.channels.size());
+    for (size_t c = 0; c < session.channels.size(); ++c) channelSizes[c] = session.channels[c].points.size();
+    encodeSettings(session.settings, savedSettings);
+    current = SessionStats();
+    current.snapshotBytes = session.snapshotBytes;
+    current.journalBytes = session.journalEnd - session.snapshotBytes;
+    current.journalRecords = session.journalRecords;
+    return true;
+}
+
+void SessionWriter::close() {
+    if (file) std::fclose(file);
+    file = nullptr;
+}
+
+bool SessionWriter::appendSplice(size_t channel, CurveView points, size_t first, size_t tail, std::string& error) {
+    if (!file || channel >= channelSizes.size()) {
+        error = "No session channel " + std::to_string(channel);
+        return false;
+    }
+    // Clamped the way the history clamps a change span, so a stale span still covers the edit.
+    size_t saved = static_cast<size_t>(channelSizes[channel]);
+    size_t n = points.size();
+    first = std::min({first, saved, n});
+    tail = std::min({tail, saved - first, n - first});
+    size_t count = n - first - tail;
+    SplicePayload splice{};
+    splice.channel = static_cast<uint32_t>(channel);
+    splice.first = first;
+    splice.removed = saved - first - tail;
+    splice.count = count;
+    if (splice.removed == 0 && count == 0) return true;
+    if (sizeof(splice) + count * 2 * sizeof(float) > UINT32_MAX) {
+        error = "Edit too large for the journal";
+        return false;
+    }
+
+    const float* xs = points.xs + first * points.stride;
+    const float* ys = points.ys + first * points.stride;
+    if (points.stride != 1) {
+        gathered.resize(2 * count);
+        for (size_t i = 0; i < count; ++i) {
+            gathered[i] = points.x(first + i);
+            gathered[count + i] = points.y(first + i);
+        }
+        xs = gathered.data();
+        ys = gathered.data() + count;
+    }
+    if (!appendRecord(RECORD_SPLICE, {{&splice, sizeof(splice)}, {xs, count * sizeof(float)}, {ys, count * sizeof(float)}},
+                      error))
+        return false;
+    channelSizes[channel] = n;
+    return true;
+}
+
+bool SessionWriter::appendSettings(const SessionSettings& settings, std::string& error) {
+    encodeSettings(settings, scratch);
+    if (scratch == savedSettings) return true;
+    if (!appendRecord(RECORD_SETTINGS, {{scratch.data(), scratch.size()}}, error)) return false;
+    savedSettings.swap(scratch);
+    return true;
+}
+
+bool SessionWriter::appendRecord(uint32_t type, std::initializer_list<Part> parts, std::string& error) {
+    if (!file) {
+        error = "No session open";
+        return false;
+    }
+    RecordHeader record{};
+    record.type = type;
+    for (const Part& part : parts) {
+        record.bytes += static_cast<uint32_t>(part.bytes);
+        record.crc = crc32(record.crc, part.data, part.bytes);
+    }
+    bool ok = std::fwrite(&record, sizeof(record), 1, file) == 1;
+    for (const Part& part : parts)
+        if (ok && part.bytes > 0) ok = std::fwrite(part.data, 1, part.bytes, file) == part.bytes;
+    if (!ok) {
+        // A partial record fails its CRC and ends the journal when the file is next opened.
+        error = "Cannot append to " + filePath;
+        return false;
+    }
+    current.journalBytes += sizeof(record) + record.bytes;
+    ++current.journalRecords;
+    return true;
+}
+
+bool SessionWriter::flush(std::string& error) {
+    if (file && std::fflush(file) != 0) {
+        error = "Cannot write " + filePath;
+        return false;
+    }
+    return true;
+}
+
+bool SessionWriter::needsCompaction() const {
+    return current.journalBytes > std::max(current.snapshotBytes, MIN_COMPACTION_JOURNAL);
+}
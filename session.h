@@ -0,0 +1,118 @@
+#pragma once
+
+#include "codegen.h"
+#include "curve.h"
+#include "curve_store.h"
+#include "i18n.h"
+#include "simplify.h"
+#include "waveform.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+// Editor sessions: the full-resolution curves of every channel and the settings, in a file that
+// opens by mapping it and is autosaved by appending to it.
+//
+// A session file is a snapshot followed by a journal. The snapshot is a header, one entry per
+// channel, the settings as tagged fields (unknown tags are skipped, so older editors read newer
+// files), and each channel's times and duties as separate float arrays, 64-byte aligned. The
+// journal is a run of records, each with a CRC-32: a splice replaces a span of one channel's
+// points, a settings record replaces the settings. Opening replays the journal up to the first
+// record that is cut short or damaged. Little-endian, as on every platform the editor builds for.
+
+// Everything the editor restores besides the curves.
+struct SessionSettings {
+    Language language = Language::English;
+    float timeScale = 1.0f;
+    Simplifier simplifier = Simplifier::Rdp;
+    float toleranceCounts = 1.0f;
+    bool budgetMode = false;
+    int pointBudget = 128;
+    WaveSettings wave;
+    PlayerKind player = PlayerKind::Scan;
+    unsigned tickMs = 10;
+    unsigned lookupShift = 3;
+    TableEncoding encoding = TableEncoding::Auto;
+    std::string board = "uno";
+    uint32_t activeChannel = 0;
+};
+
+// A channel as it is saved: its pin and its points, read in place.
+struct SessionChannel {
+    int pin = 10;
+    CurveView points;
+};
+
+struct SessionCurve {
+    int pin = 10;
+    CurveStore points;
+};
+
+struct SessionData {
+    SessionSettings settings;
+    std::vector<SessionCurve> channels;
+    size_t journalRecords = 0;  // replayed on top of the snapshot
+    uint64_t snapshotBytes = 0;
+    uint64_t journalEnd = 0;    // end of the last intact record; anything after it is dropped
+};
+
+// Maps `path` and reads the session, journal included.
+bool loadSession(const std::string& path, SessionData& session, std::string& error);
+
+struct SessionStats {
+    uint64_t snapshotBytes = 0;
+    uint64_t journalBytes = 0;
+    size_t journalRecords = 0;
+    size_t compactions = 0;        // snapshots rewritten over the open session
+    double lastSnapshotNanos = 0;
+};
+
+// Keeps a session file open and appends to its journal. The journal is compacted, the snapshot
+// rewritten with it folded in, once it outgrows the snapshot, so appends stay proportional to
+// the edit and the file to the curves.
+class SessionWriter {
+public:
+    SessionWriter() = default;
+    ~SessionWriter() { close(); }
+    SessionWriter(const SessionWriter&) = delete;
+    SessionWriter& operator=(const SessionWriter&) = delete;
+
+    // Writes a snapshot to `path`, through a temporary file renamed over it, and keeps it open.
+    bool save(const std::string& path, const SessionSettings& settings, const std::vector<SessionChannel>& channels,
+              std::string& error);
+    // Continues the journal of a session loadSession read from `path`.
+    bool resume(const std::string& path, const SessionData& session, std::string& error);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+    const std::string& path() const { return filePath; }
+
+    // Records that points[first, size - tail) of `channel` replace everything between the same
+    // first and tail of what was saved last, the span CurveStore::unsaved() reports.
+    bool appendSplice(size_t channel, CurveView points, size_t first, size_t tail, std::string& error);
+    // Records the settings if they differ from the last saved.
+    bool appendSettings(const SessionSettings& settings, std::string& error);
+    // Flushes what was appended to the operating system.
+    bool flush(std::string& error);
+
+    bool needsCompaction() const;
+    const SessionStats& stats() const { return current; }
+
+private:
+    struct Part {
+        const void* data;
+        size_t bytes;
+    };
+    bool appendRecord(uint32_t type, std::initializer_list<Part> parts, std::string& error);
+
+    std::FILE* file = nullptr;
+    std::string filePath;
+    std::vector<uint64_t> channelSizes;  // points of each channel as the file has them
+    std::vector<uint8_t> savedSettings;  // encoded
+    std::vector<uint8_t> scratch;
+    std::vector<float> gathered;         // a strided view's points, made contiguous
+    SessionStats current;
+};
@@ -0,0 +1,133 @@
+// Regression check of the generated players: small fixture curves are exported with every
+// player and table encoding, as a multi-channel rig and as the live player, played on the host
+// by simulateSketch, and must stay within simulationAllowance of the curve. Every player is also
+// built without Timer 1's registers, as for an ESP32. Needs the host C++ compiler simulateSketch
+// uses.
+#include "codegen.h"
+#include "curve.h"
+#include "firmware_sim.h"
+#include "live_link.h"
+#include "multichannel.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Fixture {
+    const char* name;
+    std::vector<DataPoint> points;
+};
+
+struct Case {
+    std::string name;
+    std::string sketch;
+    std::vector<Channel> channels;
+    float allowance = 0;
+    bool avrTimers = true;
+    uint32_t durationMs = 0;
+    bool ok = false;
+    std::string message{};
+};
+
+// The rig's tolerance, in percent duty; planChannels may move a channel this far from its curve.
+constexpr float RIG_TOLERANCE = 0.5f;
+
+std::vector<Fixture> fixtures() {
+    return {
+        {"ramp", {{0.0f, 0.0f}, {1.0f, 100.0f}}},
+        {"holds", {{0.0f, 20.0f}, {0.3f, 20.0f}, {0.3f, 80.0f}, {0.6f, 80.0f}, {0.6f, 40.0f}, {1.0f, 40.0f}}},
+        {"single point", {{0.0f, 60.0f}}},
+        {"triangle", {{0.0f, 10.0f}, {0.25f, 90.0f}, {0.7f, 30.0f}, {1.2f, 70.0f}}},
+    };
+}
+
+void runCase(Case& test) {
+    SimReport report;
+    SimOptions sim;
+    sim.avrTimers = test.avrTimers;
+    sim.durationMs = test.durationMs;
+    if (!simulateSketch(test.sketch, test.channels, sim, report, test.message)) return;
+    if (report.samples == 0) {
+        test.message = "no output";
+    } else if (report.maxError > test.allowance) {
+        char message[128];
+        std::snprintf(message, sizeof(message), "plays %.2f%% off the curve at %.3f s on pin %d, allowed %.2f%%",
+            report.maxError, report.maxErrorAt, report.maxErrorPin, test.allowance);
+        test.message = message;
+    } else {
+        test.ok = true;
+    }
+}
+
+}  // namespace
+
+int main() {
+    std::vector<Fixture> curves = fixtures();
+    std::vector<Case> cases;
+    auto addPlayer = [&](const Fixture& fixture, const CodeOptions& options) {
+        std::ostringstream sketch;
+        writeArduinoCode(sketch, fixture.points, options);
+        std::string name = std::string(fixture.name) + ", " + playerName(options.player) + " player, " +
+                           encodingName(options.encoding) + " tables";
+        float allowance = simulationAllowance(fixture.points, options);
+        cases.push_back({name, sketch.str(), {{10, fixture.points}}, allowance});
+        if (options.encoding == TableEncoding::Auto) {
+            cases.push_back({name + ", no Timer 1", sketch.str(), {{10, fixture.points}}, allowance, false});
+        }
+    };
+    for (const Fixture& fixture : curves) {
+        for (PlayerKind player : {PlayerKind::Scan, PlayerKind::Cursor, PlayerKind::FixedPoint, PlayerKind::Lookup}) {
+            CodeOptions options;
+            options.player = player;
+            options.encoding = TableEncoding::Auto;
+            addPlayer(fixture, options);
+            // Encodings the player cannot decode fall back to Plain, which is already covered.
+            for (const EncodingSize& size : measureEncodings(fixture.points, options)) {
+                if (!size.available) continue;
+                options.encoding = size.encoding;
+                addPlayer(fixture, options);
+            }
+        }
+
+        // The live player updates on its tick, so the run is long enough for a few even when the
+        // curve is a single point.
+        std::ostringstream live;
+        writeLiveSketch(live, fixture.points);
+        uint32_t liveMs = std::max(2 * static_cast<uint32_t>(fixture.points.back().x * 1000), 100u);
+        cases.push_back({std::string(fixture.name) + ", live player", live.str(), {{10, fixture.points}},
+            simulationAllowance(fixture.points, CodeOptions()), true, liveMs});
+    }
+
+    // A rig of three channels with different breakpoints, so the plan has to share times.
+    std::vector<Channel> rig = {{9, curves[0].points}, {10, curves[1].points}, {11, curves[3].points}};
+    CodeOptions rigOptions;
+    std::ostringstream rigSketch;
+    writeMultiChannelCode(rigSketch, planChannels(rig, RIG_TOLERANCE, rigOptions), rigOptions);
+    float rigAllowance = 0;
+    for (const Channel& channel : rig) {
+        std::vector<DataPoint> points(channel.points.size());
+        for (size_t i = 0; i < points.size(); ++i) points[i] = channel.points[i];
+        rigAllowance = std::max(rigAllowance, RIG_TOLERANCE + simulationAllowance(points, rigOptions));
+    }
+    cases.push_back({"ramp, holds and triangle, multi-channel rig", rigSketch.str(), rig, rigAllowance});
+    cases.push_back({"ramp, holds and triangle, multi-channel rig, no Timer 1", rigSketch.str(), rig, rigAllowance,
+        false});
+
+    ThreadPool pool;
+    pool.parallelFor(cases.size(), [&](size_t i) { runCase(cases[i]); });
+
+    size_t failed = 0;
+    for (const Case& test : cases) {
+        if (test.ok) continue;
+        ++failed;
+        std::printf("FAIL %s: %s\n", test.name.c_str(), test.message.c_str());
+    }
+    std::printf("%zu of %zu sketches within bounds\n", cases.size() - failed, cases.size());
+    return failed ? 1 : 0;
+}
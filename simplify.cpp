@@ -0,0 +1,602 @@
+#include "simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+double perpendicularDistanceSq(const DataPoint& p, const DataPoint& a, const DataPoint& b) {
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float ex = p.x - a.x;
+    float ey = p.y - a.y;
+    if (dx != 0 || dy != 0) {
+        float t = (ex * dx + ey * dy) / (dx * dx + dy * dy);
+        t = std::max(0.0f, std::min(1.0f, t));
+        ex = p.x - (a.x + t * dx);
+        ey = p.y - (a.y + t * dy);
+    }
+    return static_cast<double>(ex) * ex + static_cast<double>(ey) * ey;
+}
+
+float perpendicularDistance(const DataPoint& p, const DataPoint& a, const DataPoint& b) {
+    return static_cast<float>(std::sqrt(perpendicularDistanceSq(p, a, b)));
+}
+
+float verticalDistance(const DataPoint& p, const DataPoint& a, const DataPoint& b) {
+    if (b.x == a.x) {
+        float lo = std::min(a.y, b.y), hi = std::max(a.y, b.y);
+        return p.y < lo ? lo - p.y : p.y > hi ? p.y - hi : 0.0f;
+    }
+    return std::abs(p.y - (a.y + (p.x - a.x) / (b.x - a.x) * (b.y - a.y)));
+}
+
+size_t farthestPoint(CurveView points, size_t first, size_t last, float& maxDist, DistanceMetric metric) {
+    DataPoint a = points[first];
+    DataPoint b = points[last];
+    size_t index = 0;
+    maxDist = 0;
+    if (metric == DistanceMetric::Vertical) {
+        for (size_t i = first + 1; i < last; ++i) {
+            float d = verticalDistance(points[i], a, b);
+            if (d > maxDist) {
+                index = i;
+                maxDist = d;
+            }
+        }
+        return index;
+    }
+
+    double maxDistSq = 0;
+    for (size_t i = first + 1; i < last; ++i) {
+        double distSq = perpendicularDistanceSq(points[i], a, b);
+        if (distSq > maxDistSq) {
+            maxDistSq = distSq;
+            float d = static_cast<float>(std::sqrt(distSq));
+            if (d > maxDist) {
+                index = i;
+                maxDist = d;
+            }
+        }
+    }
+    return index;
+}
+
+size_t RdpSimplifier::mark(CurveView points, float epsilon, DistanceMetric metric) {
+    size_t count = points.size();
+    keep.assign(count, 0);
+    if (count < 3) {
+        std::fill(keep.begin(), keep.end(), 1);
+        return count;
+    }
+
+    keep.front() = keep.back() = 1;
+    size_t kept = 2;
+    stack.clear();
+    stack.push_back({0, count - 1});
+    while (!stack.empty()) {
+        auto [first, last] = stack.back();
+        stack.pop_back();
+
+        float maxDist;
+        size_t index = farthestPoint(points, first, last, maxDist, metric);
+        if (index != 0 && maxDist > epsilon) {
+            keep[index] = 1;
+            ++kept;
+            stack.push_back({index, last});
+            stack.push_back({first, index});
+        }
+    }
+    return kept;
+}
+
+void RdpSimplifier::simplify(CurveView points, float epsilon, std::vector<DataPoint>& out, DistanceMetric metric) {
+    size_t kept = mark(points, epsilon, metric);
+    out.clear();
+    out.reserve(kept);
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (keep[i]) out.push_back(points[i]);
+    }
+}
+
+void rdpSimplify(CurveView points, float epsilon, std::vector<DataPoint>& out, DistanceMetric metric) {
+    thread_local RdpSimplifier simplifier;
+    simplifier.simplify(points, epsilon, out, metric);
+}
+
+void SwingDoorSimplifier::reset(float tolerance) {
+    this->tolerance = tolerance;
+    started = pending = false;
+}
+
+bool SwingDoorSimplifier::add(const DataPoint& sample, std::vector<DataPoint>& out) {
+    if (!started) {
+        out.push_back(sample);
+        anchor = sample;
+        started = true;
+        return true;
+    }
+    const DataPoint& previous = pending ? last : anchor;
+    if (sample.x < previous.x) return false;
+
+    if (sample.x == previous.x) {
+        // Both ends of a vertical step are kept, so the step itself is exact.
+        if (sample.y == previous.y) return true;
+        if (pending) out.push_back(last);
+        out.push_back(sample);
+        anchor = sample;
+        pending = false;
+        return true;
+    }
+
+    if (pending) {
+        double slope = (static_cast<double>(sample.y) - anchor.y) / (static_cast<double>(sample.x) - anchor.x);
+        if (slope < lo || slope > hi) {
+            out.push_back(last);
+            anchor = last;
+            pending = false;
+        }
+    }
+    if (!pending) {
+        lo = -std::numeric_limits<double>::infinity();
+        hi = std::numeric_limits<double>::infinity();
+    }
+    narrow(sample);
+    last = sample;
+    pending = true;
+    return true;
+}
+
+void SwingDoorSimplifier::finish(std::vector<DataPoint>& out) {
+    if (pending) out.push_back(last);
+    pending = false;
+}
+
+// Keeps only the slopes from the anchor that pass within tolerance of `sample`.
+void SwingDoorSimplifier::narrow(const DataPoint& sample) {
+    double dx = static_cast<double>(sample.x) - anchor.x;
+    double dy = static_cast<double>(sample.y) - anchor.y;
+    lo = std::max(lo, (dy - tolerance) / dx);
+    hi = std::min(hi, (dy + tolerance) / dx);
+}
+
+void VisvalingamSimplifier::simplify(CurveView points, float tolerance, std::vector<DataPoint>& out) {
+    size_t n = points.size();
+    out.clear();
+    if (n < 3) {
+        for (size_t i = 0; i < n; ++i) out.push_back(points[i]);
+        return;
+    }
+    uint32_t count = static_cast<uint32_t>(n);
+    prev.resize(n);
+    next.resize(n);
+    segmentError.assign(n, 0.0f);
+    position.assign(n, NOT_QUEUED);
+    heap.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        prev[i] = i - 1;
+        next[i] = i + 1;
+    }
+    for (uint32_t i = 1; i + 1 < count; ++i) queue(points, i);
+
+    while (!heap.empty()) {
+        uint32_t i = popSmallest();
+        uint32_t a = prev[i], b = next[i];
+        DataPoint pa = points[a], pb = points[b];
+        // The chords differ most at point i, so no covered sample moves further than that.
+        float error = std::max(segmentError[a], segmentError[i]) + verticalDistance(points[i], pa, pb);
+        if (error > tolerance) {
+            error = 0;
+            for (uint32_t k = a + 1; k < b && error <= tolerance; ++k) {
+                error = std::max(error, verticalDistance(points[k], pa, pb));
+            }
+            if (error > tolerance) continue;  // kept until a neighbour goes
+        }
+
+        segmentError[a] = error;
+        next[a] = b;
+        prev[b] = a;
+        if (a > 0) queue(points, a);
+        if (b + 1 < count) queue(points, b);
+    }
+
+    for (uint32_t i = 0; i < count; i = next[i]) out.push_back(points[i]);
+}
+
+void VisvalingamSimplifier::queue(CurveView points, uint32_t index) {
+    DataPoint a = points[prev[index]], p = points[index], b = points[next[index]];
+    Candidate candidate{0.5f * std::abs((p.x - a.x) * (b.y - a.y) - (b.x - a.x) * (p.y - a.y)), index};
+    uint32_t at = position[index];
+    if (at == NOT_QUEUED) {
+        heap.push_back(candidate);
+        siftUp(static_cast<uint32_t>(heap.size() - 1), candidate);
+    } else if (candidate.area < heap[at].area) {
+        siftUp(at, candidate);
+    } else {
+        siftDown(at, candidate);
+    }
+}
+
+uint32_t VisvalingamSimplifier::popSmallest() {
+    uint32_t top = heap.front().index;
+    position[top] = NOT_QUEUED;
+    Candidate last = heap.back();
+    heap.pop_back();
+    if (!heap.empty()) siftDown(0, last);
+    return top;
+}
+
+void VisvalingamSimplifier::siftUp(uint32_t at, Candidate candidate) {
+    while (at > 0) {
+        uint32_t parent = (at - 1) / 4;
+        if (!(candidate.area < heap[parent].area)) break;
+        place(at, heap[parent]);
+        at = parent;
+    }
+    place(at, candidate);
+}
+
+void VisvalingamSimplifier::siftDown(uint32_t at, Candidate candidate) {
+    uint32_t size = static_cast<uint32_t>(heap.size());
+    while (true) {
+        uint32_t first = 4 * at + 1;
+        if (first >= size) break;
+        uint32_t smallest = first;
+        for (uint32_t child = first + 1; child < std::min(first + 4, size); ++child) {
+            if (heap[child].area < heap[smallest].area) smallest = child;
+        }
+        if (!(heap[smallest].area < candidate.area)) break;
+        place(at, heap[smallest]);
+        at = smallest;
+    }
+    place(at, candidate);
+}
+
+void VisvalingamSimplifier::place(uint32_t at, Candidate candidate) {
+    heap[at] = candidate;
+    position[candidate.index] = at;
+}
+
+float pwmCountsToPercent(float counts) {
+    return counts * 100.0f / 255.0f;
+}
+
+void simplifyCurve(CurveView points, Simplifier engine, float toleranceCounts, std::vector<DataPoint>& out) {
+    float tolerance = pwmCountsToPercent(toleranceCounts);
+    switch (engine) {
+    case Simplifier::Rdp:
+        rdpSimplify(points, tolerance, out, DistanceMetric::Vertical);
+        return;
+    case Simplifier::SwingDoor: {
+        SwingDoorSimplifier door(tolerance);
+        out.clear();
+        for (size_t i = 0; i < points.size(); ++i) door.add(points[i], out);
+        door.finish(out);
+        return;
+    }
+    case Simplifier::Visvalingam: {
+        thread_local VisvalingamSimplifier simplifier;
+        simplifier.simplify(points, tolerance, out);
+        return;
+    }
+    }
+}
+
+const char* simplifierName(Simplifier engine) {
+    switch (engine) {
+    case Simplifier::Rdp: return "rdp";
+    case Simplifier::SwingDoor: return "swing-door";
+    case Simplifier::Visvalingam: return "visvalingam";
+    }
+    return "";
+}
+
+bool parseSimplifier(const std::string& name, Simplifier& engine) {
+    for (Simplifier candidate : {Simplifier::Rdp, Simplifier::SwingDoor, Simplifier::Visvalingam}) {
+        if (name == simplifierName(candidate)) {
+            engine = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SimplifyCache::rebuild(CurveView points, float epsilon) {
+    cachedEpsilon = epsilon;
+    valid = true;
+    nodes.clear();
+    freeNodes.clear();
+    root = -1;
+    if (points.size() < 2) {
+        simplified.clear();
+        for (size_t i = 0; i < points.size(); ++i) simplified.push_back(points[i]);
+        collected = true;
+        return;
+    }
+    root = newNode(points, 0, points.size() - 1);
+    expand(points, root);
+    collected = false;
+}
+
+void SimplifyCache::update(CurveView points, Edit edit, size_t index, uint64_t& revision) {
+    bool current = valid && cachedRevision == revision && root >= 0;
+    ++revision;
+    if (!current) {
+        valid = false;
+        return;
+    }
+
+    // Edits at either end move the root chord, so nothing can be reused.
+    size_t oldLast = nodes[root].last;
+    size_t newLast = points.size() - 1;
+    if (points.size() < 3 || index == 0 ||
+        (edit == Edit::Erase ? index >= oldLast : index >= newLast)) {
+        rebuild(points, cachedEpsilon);
+        cachedRevision = revision;
+        return;
+    }
+
+    if (edit != Edit::Move) shiftIndices(edit, index);
+
+    CurveView p = points;
+    int id = root;
+    while (true) {
+        Node node = nodes[id];
+        bool wasDivided = node.left >= 0;
+        bool splitTouched = (edit == Edit::Erase && node.splitErased) ||
+                            (edit == Edit::Move && node.split == index);
+        size_t split = node.split;
+        float maxDist = node.maxDist;
+        if (splitTouched) {
+            split = farthestPoint(p, node.first, node.last, maxDist, cachedMetric);
+        } else if (edit != Edit::Erase) {
+            float d = distance(p[index], p[node.first], p[node.last]);
+            if (d > maxDist || (d == maxDist && d > 0 && index < split)) {
+                split = index;
+                maxDist = d;
+            }
+        }
+
+        bool divided = split != 0 && maxDist > cachedEpsilon;
+        if (!wasDivided && !divided) {
+            nodes[id].split = split;
+            nodes[id].maxDist = maxDist;
+            break;
+        }
+        if (wasDivided && divided && !splitTouched && split == node.split) {
+            bool goLeft = index < split || (edit == Edit::Erase && index == split);
+            id = goLeft ? node.left : node.right;
+            continue;
+        }
+
+        // The decision for this range changed: rebuild its subtree from scratch.
+        release(id);
+        nodes[id].split = split;
+        nodes[id].maxDist = maxDist;
+        nodes[id].splitErased = false;
+        expand(p, id);
+        break;
+    }
+
+    collected = false;
+    cachedRevision = revision;
+}
+
+void SimplifyCache::pointRelocated(CurveView points, size_t from, size_t to, uint64_t& revision) {
+    if (from == to) {
+        pointMoved(points, to, revision);
+        return;
+    }
+    bool current = valid && cachedRevision == revision && root >= 0;
+    ++revision;
+    if (!current) {
+        valid = false;
+        return;
+    }
+
+    // Only [lo, hi] was reordered: the moved point went from `from` to `to` and the points in
+    // between shifted by one. The others keep their order, so a range whose ends are not the
+    // moved point keeps its chord and its split, and can only gain or lose the moved point.
+    // Only the ranges overlapping [lo, hi] are visited; their indices are renumbered and the
+    // moved point is checked against their split.
+    size_t lo = std::min(from, to), hi = std::max(from, to);
+    if (lo == 0 || hi >= nodes[root].last) {
+        rebuild(points, cachedEpsilon);
+        cachedRevision = revision;
+        return;
+    }
+    auto renumber = [&](size_t& i) {
+        if (i == from) {
+            i = to;
+        } else if (from < to && i > from && i <= to) {
+            --i;
+        } else if (to < from && i >= to && i < from) {
+            ++i;
+        }
+    };
+
+    relocating.clear();
+    relocating.push_back(root);
+    while (!relocating.empty()) {
+        int id = relocating.back();
+        relocating.pop_back();
+        Node& node = nodes[id];
+        renumber(node.first);
+        renumber(node.last);
+        if (node.split != 0) renumber(node.split);
+
+        // The moved point was the split: its distance changed and the points it passed changed
+        // sides, so the range is split again from scratch. Descendants that end on the moved
+        // point are all below here.
+        if (node.split == to) {
+            release(id);
+            Node& target = nodes[id];
+            target.split = farthestPoint(points, target.first, target.last, target.maxDist, cachedMetric);
+            target.splitErased = false;
+            expand(points, id);
+            continue;
+        }
+        if (node.first < to && to < node.last) {
+            float d = distance(points[to], points[node.first], points[node.last]);
+            if (d > node.maxDist || (d == node.maxDist && d > 0 && to < node.split)) {
+                release(id);
+                Node& target = nodes[id];
+                target.split = to;
+                target.maxDist = d;
+                target.splitErased = false;
+                expand(points, id);
+                continue;
+            }
+        }
+        if (node.left < 0) continue;
+        for (int child : {node.left, node.right}) {
+            if (nodes[child].first <= hi && nodes[child].last >= lo) relocating.push_back(child);
+        }
+    }
+
+    collected = false;
+    cachedRevision = revision;
+}
+
+void SimplifyCache::shiftIndices(Edit edit, size_t index) {
+    auto shift = [&](size_t& i) {
+        if (edit == Edit::Insert && i >= index) ++i;
+        if (edit == Edit::Erase && i > index) --i;
+    };
+    for (Node& node : nodes) {
+        if (edit == Edit::Erase && node.split == index) node.splitErased = true;
+        shift(node.first);
+        shift(node.last);
+        if (node.split != 0) shift(node.split);
+    }
+}
+
+int SimplifyCache::newNode(CurveView points, size_t first, size_t last) {
+    Node node;
+    node.first = first;
+    node.last = last;
+    node.split = farthestPoint(points, first, last, node.maxDist, cachedMetric);
+    if (!freeNodes.empty()) {
+        int id = freeNodes.back();
+        freeNodes.pop_back();
+        nodes[id] = node;
+        return id;
+    }
+    nodes.push_back(node);
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+// Splits `id` and its descendants until every leaf is within epsilon.
+void SimplifyCache::expand(CurveView points, int id) {
+    work.clear();
+    work.push_back(id);
+    while (!work.empty()) {
+        int cur = work.back();
+        work.pop_back();
+        Node node = nodes[cur];
+        if (node.split == 0 || !(node.maxDist > cachedEpsilon)) {
+            nodes[cur].left = nodes[cur].right = -1;
+            continue;
+        }
+        int left = newNode(points, node.first, node.split);
+        int right = newNode(points, node.split, node.last);
+        nodes[cur].left = left;
+        nodes[cur].right = right;
+        work.push_back(right);
+        work.push_back(left);
+    }
+}
+
+// Returns the descendants of `id` to the free list and turns it into a leaf.
+void SimplifyCache::release(int id) {
+    work.clear();
+    if (nodes[id].left >= 0) {
+        work.push_back(nodes[id].left);
+        work.push_back(nodes[id].right);
+    }
+    nodes[id].left = nodes[id].right = -1;
+    while (!work.empty()) {
+        int cur = work.back();
+        work.pop_back();
+        if (nodes[cur].left >= 0) {
+            work.push_back(nodes[cur].left);
+            work.push_back(nodes[cur].right);
+        }
+        nodes[cur].left = nodes[cur].right = -1;
+        freeNodes.push_back(cur);
+    }
+}
+
+// In-order walk of the split points between the two curve ends.
+void SimplifyCache::collect(CurveView points) {
+    simplified.clear();
+    simplified.push_back(points[nodes[root].first]);
+    work.clear();
+    int cur = root;
+    while (cur >= 0 || !work.empty()) {
+        while (cur >= 0 && nodes[cur].left >= 0) {
+            work.push_back(cur);
+            cur = nodes[cur].left;
+        }
+        if (work.empty()) break;
+        cur = work.back();
+        work.pop_back();
+        simplified.push_back(points[nodes[cur].split]);
+        cur = nodes[cur].right;
+    }
+    simplified.push_back(points[nodes[root].last]);
+    collected = true;
+}
+
+void SimplifyCache::topSplits(size_t count, std::vector<std::pair<float, size_t>>& out) const {
+    if (root < 0 || nodes[root].left < 0 || count == 0) return;
+    // Effective distances never grow down the tree, so a best-first walk yields them in order.
+    std::vector<std::pair<float, int>> frontier = {{nodes[root].maxDist, root}};
+    while (!frontier.empty() && count-- > 0) {
+        std::pop_heap(frontier.begin(), frontier.end());
+        auto [effective, id] = frontier.back();
+        frontier.pop_back();
+        const Node& node = nodes[id];
+        out.push_back({effective, node.split});
+        for (int child : {node.left, node.right}) {
+            if (nodes[child].left < 0) continue;
+            frontier.push_back({std::min(effective, nodes[child].maxDist), child});
+            std::push_heap(frontier.begin(), frontier.end());
+        }
+    }
+}
+
+FitError measureFitError(CurveView original, const std::vector<DataPoint>& simplified) {
+    FitError error;
+    size_t count = original.size();
+    if (count == 0 || simplified.empty()) return error;
+
+    double sumSq = 0;
+    size_t seg = 0;
+    for (size_t i = 0; i < count; ++i) {
+        DataPoint p = original[i];
+        // Each skipped point is measured against the kept segment that spans it.
+        while (seg + 1 < simplified.size() && (simplified[seg + 1].x < p.x || simplified[seg + 1] == p)) ++seg;
+
+        const DataPoint& a = simplified[seg];
+        float e;
+        if (a == p) {
+            e = 0;
+        } else if (seg + 1 == simplified.size() || p.x < a.x) {
+            e = std::abs(p.y - a.y);  // outside the simplified time range
+        } else {
+            const DataPoint& b = simplified[seg + 1];
+            if (b.x == a.x) {
+                // A vertical step covers the values between its ends.
+                float lo = std::min(a.y, b.y), hi = std::max(a.y, b.y);
+                e = p.y < lo ? lo - p.y : p.y > hi ? p.y - hi : 0.0f;
+            } else {
+                e = std::abs(p.y - (a.y + (p.x - a.x) / (b.x - a.x) * (b.y - a.y)));
+            }
+        }
+
+        error.maxError = std::max(error.maxError, e);
+        sumSq += static_cast<double>(e) * e;
+    }
+    error.rmsError = static_cast<float>(std::sqrt(sumSq / count));
+    return error;
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "curve.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// How far a point lies from a chord. Perpendicular treats seconds and percent as one Euclidean
+// unit, so what an epsilon means changes with the time scale; Vertical is the duty error at the
+// point's time, what the player outputs.
+enum class DistanceMetric { Perpendicular, Vertical };
+
+// Squared distance from p to segment ab. Coordinates are combined in float and
+// squared in double, so sqrt() of the result matches the historic float distance bit for bit.
+double perpendicularDistanceSq(const DataPoint& p, const DataPoint& a, const DataPoint& b);
+float perpendicularDistance(const DataPoint& p, const DataPoint& a, const DataPoint& b);
+// Duty distance from p to the line through ab at p's time. A vertical chord covers the values
+// between its ends.
+float verticalDistance(const DataPoint& p, const DataPoint& a, const DataPoint& b);
+
+// Returns the interior point of (first, last) farthest from the chord and its distance, or 0
+// when no point lies off the chord. Candidates are compared on squared distance; sqrt is only
+// taken for a new running maximum, which keeps the first-index tie-breaking of a float compare.
+size_t farthestPoint(CurveView points, size_t first, size_t last, float& maxDist,
+                     DistanceMetric metric = DistanceMetric::Perpendicular);
+
+// Iterative Ramer-Douglas-Peucker over index ranges. The explicit stack and the
+// keep-mask are reused between calls, so steady-state simplification does not allocate.
+class RdpSimplifier {
+public:
+    // Marks the points RDP keeps and returns how many there are.
+    size_t mark(CurveView points, float epsilon, DistanceMetric metric = DistanceMetric::Perpendicular);
+    void simplify(CurveView points, float epsilon, std::vector<DataPoint>& out,
+                  DistanceMetric metric = DistanceMetric::Perpendicular);
+
+    const std::vector<uint8_t>& keepMask() const { return keep; }
+
+private:
+    std::vector<std::pair<size_t, size_t>> stack;
+    std::vector<uint8_t> keep;
+};
+
+void rdpSimplify(CurveView points, float epsilon, std::vector<DataPoint>& out,
+                 DistanceMetric metric = DistanceMetric::Perpendicular);
+
+// Online simplification for sample streams too long to hold: every dropped sample stays within
+// `tolerance` (percent duty) of the output line, measured vertically as in measureFitError.
+// Each segment is extended from its anchor for as long as the slope to the newest sample lies
+// in the window every skipped sample allows (the swing door), so only the anchor, the last
+// sample and two slopes are kept. Samples must come in time order; repeated times become
+// vertical steps.
+class SwingDoorSimplifier {
+public:
+    explicit SwingDoorSimplifier(float tolerance = 0) { reset(tolerance); }
+
+    void reset(float tolerance);
+
+    // Appends the points that become final to `out`. Returns false, ignoring the sample, if it
+    // is earlier than the previous one.
+    bool add(const DataPoint& sample, std::vector<DataPoint>& out);
+    // Appends the last pending point.
+    void finish(std::vector<DataPoint>& out);
+
+private:
+    void narrow(const DataPoint& sample);
+
+    double tolerance = 0;
+    DataPoint anchor{}, last{};
+    double lo = 0, hi = 0;  // admissible slopes from the anchor
+    bool started = false, pending = false;
+};
+
+// Visvalingam-Whyatt: repeatedly drops the point whose triangle with its neighbours has the
+// smallest area, taken from a heap, as long as every sample the merged segment covers stays
+// within `tolerance` (percent duty) vertically. A point that cannot go waits until a neighbour
+// changes. The covered samples are only scanned when a bound from the two merged segments'
+// errors does not already settle it, so smooth curves take O(n log n).
+class VisvalingamSimplifier {
+public:
+    void simplify(CurveView points, float tolerance, std::vector<DataPoint>& out);
+
+private:
+    static constexpr uint32_t NOT_QUEUED = UINT32_MAX;
+
+    struct Candidate {
+        float area;
+        uint32_t index;
+    };
+
+    // A 4-ary heap holding each candidate once, updated in place, so it never outgrows the curve
+    // and compares areas stored next to each other; a heap of superseded entries would be
+    // several times larger and miss the cache on every level.
+    void queue(CurveView points, uint32_t index);
+    uint32_t popSmallest();
+    void siftUp(uint32_t at, Candidate candidate);
+    void siftDown(uint32_t at, Candidate candidate);
+    void place(uint32_t at, Candidate candidate);
+
+    std::vector<uint32_t> prev, next;
+    std::vector<float> segmentError;  // bound on the error of the segment starting at each kept point
+    std::vector<Candidate> heap;      // smallest area first
+    std::vector<uint32_t> position;   // of each point in the heap, or NOT_QUEUED
+};
+
+// Interchangeable engines that simplify to a vertical tolerance in PWM counts: no dropped sample
+// ends up farther than that from the output line at its time, as measureFitError measures it.
+enum class Simplifier {
+    Rdp,          // Ramer-Douglas-Peucker on vertical distance; quadratic in the worst case
+    SwingDoor,    // one pass, O(n)
+    Visvalingam,  // smallest triangle first from a heap, O(n log n)
+};
+
+// One PWM count is 100/255 percent duty.
+float pwmCountsToPercent(float counts);
+
+void simplifyCurve(CurveView points, Simplifier engine, float toleranceCounts, std::vector<DataPoint>& out);
+
+const char* simplifierName(Simplifier engine);
+bool parseSimplifier(const std::string& name, Simplifier& engine);
+
+// Caches the simplified form of a curve for one revision and epsilon. The RDP decomposition
+// tree is kept, so after a single point is inserted, erased or moved only the ranges that
+// contain it are re-evaluated; untouched sub-spans keep their split decisions.
+class SimplifyCache {
+public:
+    const std::vector<DataPoint>& get(CurveView points, float epsilon, uint64_t revision,
+                                      DistanceMetric metric = DistanceMetric::Perpendicular) {
+        sync(points, epsilon, revision, metric);
+        if (!collected) collect(points);
+        return simplified;
+    }
+
+    void invalidate() { valid = false; }
+
+    // Brings the decomposition tree up to date without materializing the simplified points.
+    void sync(CurveView points, float epsilon, uint64_t revision,
+              DistanceMetric metric = DistanceMetric::Perpendicular) {
+        if (!valid || revision != cachedRevision || epsilon != cachedEpsilon || metric != cachedMetric) {
+            cachedMetric = metric;
+            rebuild(points, epsilon);
+            cachedRevision = revision;
+        }
+    }
+
+    // Appends up to `count` (effective distance, index) pairs in descending order, where the
+    // effective distance of a split is the smallest maxDist on its path from the root. Synced
+    // with epsilon 0 the tree is the full RDP hierarchy, and rdpSimplify(e) keeps exactly the
+    // splits whose effective distance exceeds e.
+    void topSplits(size_t count, std::vector<std::pair<float, size_t>>& out) const;
+
+    // Edit notifications, called after `points` has been modified. They bump `revision`;
+    // if the cache was not current before the edit it rebuilds lazily on the next get().
+    void pointInserted(CurveView points, size_t index, uint64_t& revision) {
+        update(points, Edit::Insert, index, revision);
+    }
+    void pointErased(CurveView points, size_t index, uint64_t& revision) {
+        update(points, Edit::Erase, index, revision);
+    }
+    void pointMoved(CurveView points, size_t index, uint64_t& revision) {
+        update(points, Edit::Move, index, revision);
+    }
+    // The point at `from` was given a new time and now sits at `to`; the points between
+    // shifted by one. Cheaper than an erase and an insert, which both renumber the whole tree.
+    void pointRelocated(CurveView points, size_t from, size_t to, uint64_t& revision);
+
+private:
+    enum class Edit { Insert, Erase, Move };
+
+    struct Node {
+        size_t first = 0, last = 0;
+        size_t split = 0;       // farthest interior point, 0 if none
+        float maxDist = 0;
+        int left = -1, right = -1;
+        bool splitErased = false;
+    };
+
+    void rebuild(CurveView points, float epsilon);
+    void update(CurveView points, Edit edit, size_t index, uint64_t& revision);
+    void shiftIndices(Edit edit, size_t index);
+    int newNode(CurveView points, size_t first, size_t last);
+    void expand(CurveView points, int id);
+    void release(int id);
+    void collect(CurveView points);
+    float distance(const DataPoint& p, const DataPoint& a, const DataPoint& b) const {
+        return cachedMetric == DistanceMetric::Vertical ? verticalDistance(p, a, b) : perpendicularDistance(p, a, b);
+    }
+
+    std::vector<Node> nodes;
+    std::vector<int> freeNodes;
+    std::vector<int> work;
+    std::vector<int> relocating;  // ranges pointRelocated has yet to visit
+    std::vector<DataPoint> simplified;
+    int root = -1;
+    float cachedEpsilon = 0;
+    DistanceMetric cachedMetric = DistanceMetric::Perpendicular;
+    uint64_t cachedRevision = 0;
+    bool valid = false;
+    bool collected = false;
+};
+
+// Vertical interpolation error of a simplified curve against the original samples, in percent duty.
+struct FitError {
+    float maxError = 0;
+    float rmsError = 0;
+};
+
+FitError measureFitError(CurveView original, const std::vector<DataPoint>& simplified);
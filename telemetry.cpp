@@ -0,0 +1,184 @@
+#include "telemetry.h"
+#include "simplify.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+namespace {
+
+constexpr size_t CHUNK_BYTES = 1 << 20;
+
+struct FileCloser {
+    void operator()(std::FILE* file) const { std::fclose(file); }
+};
+
+// Feeds samples to the simplifier and enforces the options. On failure the reason is left in
+// `failure`, for the reader to prefix with where the sample came from.
+class SampleSink {
+public:
+    SampleSink(const ImportOptions& options, std::vector<DataPoint>& points)
+        : simplifier(options.tolerance), maxPoints(options.maxPoints), points(points) {}
+
+    bool add(const DataPoint& sample) {
+        ++count;
+        if (!simplifier.add(sample, points)) {
+            failure = "time goes backwards";
+            return false;
+        }
+        if (maxPoints > 0 && points.size() > maxPoints) {
+            failure = "more than " + std::to_string(maxPoints) + " points at this tolerance";
+            return false;
+        }
+        return true;
+    }
+
+    void finish() { simplifier.finish(points); }
+    uint64_t samples() const { return count; }
+
+    std::string failure;
+
+private:
+    SwingDoorSimplifier simplifier;
+    size_t maxPoints;
+    std::vector<DataPoint>& points;
+    uint64_t count = 0;
+};
+
+bool cancelled(ImportProgress* progress, std::string& error) {
+    if (!progress || !progress->cancel.load(std::memory_order_relaxed)) return false;
+    error = "import cancelled";
+    return true;
+}
+
+void reportChunk(ImportProgress* progress, size_t bytes, const SampleSink& sink) {
+    if (!progress) return;
+    progress->bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+    progress->samples.store(sink.samples(), std::memory_order_relaxed);
+}
+
+bool importCsv(std::FILE* file, const std::string& path, SampleSink& sink, std::string& error,
+               ImportProgress* progress) {
+    // One spare byte so the last line can be terminated in place.
+    std::vector<char> buffer(CHUNK_BYTES + 1);
+    size_t held = 0;  // start of a line carried over from the previous chunk
+    size_t lineNo = 0;
+    bool seenSample = false;
+    while (true) {
+        if (cancelled(progress, error)) return false;
+        size_t got = std::fread(buffer.data() + held, 1, CHUNK_BYTES - held, file);
+        bool atEnd = got < CHUNK_BYTES - held;
+        if (atEnd && std::ferror(file)) {
+            error = "cannot read " + path;
+            return false;
+        }
+        char* line = buffer.data();
+        char* end = line + held + got;
+        while (line < end) {
+            char* newline = static_cast<char*>(std::memchr(line, '\n', end - line));
+            if (!newline) {
+                if (!atEnd) break;
+                newline = end;  // last line without a newline
+            }
+            *newline = '\0';
+            ++lineNo;
+            DataPoint sample;
+            CurveLine kind = parseCurveLine(line, sample);
+            line = newline + 1;
+            if (kind == CurveLine::Blank) continue;
+            if (kind == CurveLine::Invalid) {
+                if (!seenSample && lineNo == 1) continue;  // column header
+                error = path + ":" + std::to_string(lineNo) + ": expected \"time,duty\"";
+                return false;
+            }
+            seenSample = true;
+            if (!sink.add(sample)) {
+                error = path + ":" + std::to_string(lineNo) + ": " + sink.failure;
+                return false;
+            }
+        }
+        reportChunk(progress, got, sink);
+        if (atEnd) return true;
+
+        held = line < end ? end - line : 0;
+        if (held == CHUNK_BYTES) {
+            error = path + ":" + std::to_string(lineNo + 1) + ": line too long";
+            return false;
+        }
+        std::memmove(buffer.data(), line, held);
+    }
+}
+
+bool importBinary(std::FILE* file, const std::string& path, SampleSink& sink, std::string& error,
+                  ImportProgress* progress) {
+    constexpr size_t SAMPLE_BYTES = 2 * sizeof(float);
+    std::vector<unsigned char> buffer(CHUNK_BYTES);
+    uint64_t index = 0;
+    while (true) {
+        if (cancelled(progress, error)) return false;
+        size_t got = std::fread(buffer.data(), 1, CHUNK_BYTES, file);
+        if (got < CHUNK_BYTES && std::ferror(file)) {
+            error = "cannot read " + path;
+            return false;
+        }
+        if (got % SAMPLE_BYTES != 0 && std::feof(file)) {
+            error = path + ": truncated sample at the end";
+            return false;
+        }
+        for (size_t at = 0; at + SAMPLE_BYTES <= got; at += SAMPLE_BYTES, ++index) {
+            DataPoint sample;
+            uint32_t bits[2];
+            for (int k = 0; k < 2; ++k) {
+                const unsigned char* b = &buffer[at + 4 * k];
+                bits[k] = b[0] | b[1] << 8 | b[2] << 16 | static_cast<uint32_t>(b[3]) << 24;
+            }
+            std::memcpy(&sample.x, &bits[0], sizeof(float));
+            std::memcpy(&sample.y, &bits[1], sizeof(float));
+            if (!sink.add(sample)) {
+                error = path + ": sample " + std::to_string(index) + ": " + sink.failure;
+                return false;
+            }
+        }
+        reportChunk(progress, got, sink);
+        if (got < CHUNK_BYTES) return true;
+    }
+}
+
+}  // namespace
+
+TelemetryFormat telemetryFormatFor(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == ".bin" || ext == ".raw" || ext == ".f32" ? TelemetryFormat::BinaryF32 : TelemetryFormat::Csv;
+}
+
+bool importTelemetry(const std::string& path, const ImportOptions& options, std::vector<DataPoint>& points,
+                     std::string& error, ImportProgress* progress) {
+    std::unique_ptr<std::FILE, FileCloser> file(std::fopen(path.c_str(), "rb"));
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    if (progress) {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(path, ec);
+        progress->bytesTotal = ec ? 0 : size;
+        progress->bytesRead = 0;
+        progress->samples = 0;
+    }
+
+    points.clear();
+    SampleSink sink(options, points);
+    TelemetryFormat format = options.format == TelemetryFormat::Auto ? telemetryFormatFor(path) : options.format;
+    bool ok = format == TelemetryFormat::BinaryF32 ? importBinary(file.get(), path, sink, error, progress)
+                                                   : importCsv(file.get(), path, sink, error, progress);
+    if (!ok) {
+        points.clear();
+        return false;
+    }
+    sink.finish();
+    return true;
+}
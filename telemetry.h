@@ -0,0 +1,35 @@
+#pragma once
+
+#include "curve.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Recorded runs are either curve-style CSV text or raw little-endian float32 (time, duty)
+// pairs with no header. Auto picks binary for .bin, .raw and .f32 files and CSV otherwise.
+enum class TelemetryFormat { Auto, Csv, BinaryF32 };
+
+TelemetryFormat telemetryFormatFor(const std::string& path);
+
+struct ImportOptions {
+    TelemetryFormat format = TelemetryFormat::Auto;
+    float tolerance = 0.2f;  // percent duty a dropped sample may be off the imported curve
+    size_t maxPoints = 0;    // fail once the curve grows past this; 0 means no limit
+};
+
+// Shared with the thread running an import: read it from anywhere, set `cancel` to stop it.
+struct ImportProgress {
+    std::atomic<uint64_t> bytesRead{0};
+    std::atomic<uint64_t> bytesTotal{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<bool> cancel{false};
+};
+
+// Streams a recorded run through SwingDoorSimplifier in fixed-size chunks, so memory use is one
+// chunk plus the simplified curve however long the log is. Samples must be in time order.
+// Returns false with `error` set on failure or cancellation.
+bool importTelemetry(const std::string& path, const ImportOptions& options, std::vector<DataPoint>& points,
+                     std::string& error, ImportProgress* progress = nullptr);
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads fed from a single task queue.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = 0) {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this] { run(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push(std::move(task));
+            ++pending;
+        }
+        wake.notify_one();
+    }
+
+    // Blocks until every submitted task has finished.
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return pending == 0; });
+    }
+
+    // Runs fn(i) for i in [0, count) across the pool and waits for completion. Indices are
+    // handed out dynamically, so uneven per-item cost still keeps every core busy.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        std::atomic<size_t> next{0};
+        size_t jobs = std::min(count, workers.size());
+        for (size_t j = 0; j < jobs; ++j) {
+            submit([&] {
+                for (size_t i = next++; i < count; i = next++) fn(i);
+            });
+        }
+        wait();
+    }
+
+private:
+    void run() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0) idle.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    size_t pending = 0;
+    bool stopping = false;
+};
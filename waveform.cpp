@@ -0,0 +1,201 @@
+#include "waveform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WAVEFORM_SSE2 1
+#endif
+
+namespace {
+
+// Samples are generated in blocks that fit in L1: phases first, then one shape kernel per block.
+constexpr size_t BLOCK = 256;
+
+// Taylor terms of sin(x) up to x^11; within 2e-7 of sinf on [-pi/2, pi/2].
+constexpr float S3 = -1.0f / 6, S5 = 1.0f / 120, S7 = -1.0f / 5040, S9 = 1.0f / 362880, S11 = -1.0f / 39916800;
+
+// Shape parameters shared by the scalar and SSE2 kernels, which do the same float operations
+// in the same order and so give identical results.
+struct Kernel {
+    WaveShape shape;
+    float rampGain;  // trapezoid and S-curve: triangle slope multiplier
+};
+
+// Maps a phase u in [0, 1) to the folded phase in [-1/4, 1/4]: sin(2 pi u) = sin(2 pi r), and
+// 4r is the triangle wave.
+inline float foldPhase(float u) {
+    float r = u >= 0.5f ? u - 1.0f : u;
+    float a = std::fabs(r);
+    return std::copysign(std::min(a, 0.5f - a), r);
+}
+
+inline float level(const Kernel& kernel, float u) {
+    float r = foldPhase(u);
+    switch (kernel.shape) {
+    case WaveShape::Sine:
+    case WaveShape::Chirp: {
+        float x = r * (2 * PI);
+        float x2 = x * x;
+        return x * (1.0f + x2 * (S3 + x2 * (S5 + x2 * (S7 + x2 * (S9 + x2 * S11)))));
+    }
+    case WaveShape::Triangle:
+        return 4.0f * r;
+    case WaveShape::Trapezoid:
+    case WaveShape::SCurve: {
+        float v = std::max(-1.0f, std::min(4.0f * r * kernel.rampGain, 1.0f));
+        return kernel.shape == WaveShape::Trapezoid ? v : v * (2.0f - std::fabs(v));
+    }
+    }
+    return 0.0f;
+}
+
+#ifdef WAVEFORM_SSE2
+// Four lanes of level(); the scalar version handles the remainder of a block.
+inline __m128 level4(const Kernel& kernel, __m128 u) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 r = _mm_sub_ps(u, _mm_and_ps(_mm_cmpge_ps(u, _mm_set1_ps(0.5f)), one));
+    __m128 a = _mm_andnot_ps(sign, r);
+    r = _mm_or_ps(_mm_min_ps(a, _mm_sub_ps(_mm_set1_ps(0.5f), a)), _mm_and_ps(sign, r));
+
+    switch (kernel.shape) {
+    case WaveShape::Sine:
+    case WaveShape::Chirp: {
+        __m128 x = _mm_mul_ps(r, _mm_set1_ps(2 * PI));
+        __m128 x2 = _mm_mul_ps(x, x);
+        __m128 p = _mm_add_ps(_mm_set1_ps(S9), _mm_mul_ps(x2, _mm_set1_ps(S11)));
+        p = _mm_add_ps(_mm_set1_ps(S7), _mm_mul_ps(x2, p));
+        p = _mm_add_ps(_mm_set1_ps(S5), _mm_mul_ps(x2, p));
+        p = _mm_add_ps(_mm_set1_ps(S3), _mm_mul_ps(x2, p));
+        p = _mm_add_ps(one, _mm_mul_ps(x2, p));
+        return _mm_mul_ps(x, p);
+    }
+    case WaveShape::Triangle:
+        return _mm_mul_ps(_mm_set1_ps(4.0f), r);
+    case WaveShape::Trapezoid:
+    case WaveShape::SCurve: {
+        __m128 v = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(4.0f), r), _mm_set1_ps(kernel.rampGain));
+        v = _mm_max_ps(_mm_set1_ps(-1.0f), _mm_min_ps(v, one));
+        if (kernel.shape == WaveShape::Trapezoid) return v;
+        return _mm_mul_ps(v, _mm_sub_ps(_mm_set1_ps(2.0f), _mm_andnot_ps(sign, v)));
+    }
+    }
+    return _mm_setzero_ps();
+}
+#endif
+
+// Sample times and phases in [0, 1) for samples base .. base + count - 1. The phase in cycles,
+// t (f0 + sweep t), is computed in double; truncation stands in for floor because the phase is
+// non-negative in practice, and a negative remainder is wrapped anyway.
+void phaseBlock(double base, double density, double f0, double sweep, float* time, float* phase, size_t count) {
+    size_t k = 0;
+#ifdef WAVEFORM_SSE2
+    const __m128d step = _mm_set1_pd(density), f = _mm_set1_pd(f0), s = _mm_set1_pd(sweep);
+    const __m128d limit = _mm_set1_pd(2147483647.0), one = _mm_set1_pd(1.0), zero = _mm_setzero_pd();
+    __m128d index = _mm_set_pd(base + 1, base);
+    for (; k + 2 <= count; k += 2, index = _mm_add_pd(index, _mm_set1_pd(2.0))) {
+        __m128d t = _mm_mul_pd(index, step);
+        __m128d cycles = _mm_mul_pd(t, _mm_add_pd(f, _mm_mul_pd(s, t)));
+        // The 32-bit truncation only covers phases below 2^31 cycles; the scalar loop takes over
+        // past that.
+        __m128d magnitude = _mm_andnot_pd(_mm_set1_pd(-0.0), cycles);
+        if (_mm_movemask_pd(_mm_cmpge_pd(magnitude, limit))) break;
+        __m128d fraction = _mm_sub_pd(cycles, _mm_cvtepi32_pd(_mm_cvttpd_epi32(cycles)));
+        fraction = _mm_add_pd(fraction, _mm_and_pd(_mm_cmplt_pd(fraction, zero), one));
+        __m128 t4 = _mm_cvtpd_ps(t), u4 = _mm_cvtpd_ps(fraction);
+        _mm_storel_pi(reinterpret_cast<__m64*>(time + k), t4);
+        _mm_storel_pi(reinterpret_cast<__m64*>(phase + k), u4);
+    }
+#endif
+    for (; k < count; ++k) {
+        double t = (base + static_cast<double>(k)) * density;
+        double cycles = t * (f0 + sweep * t);
+        double fraction = cycles - static_cast<double>(static_cast<int64_t>(cycles));
+        phase[k] = static_cast<float>(fraction < 0 ? fraction + 1 : fraction);
+        time[k] = static_cast<float>(t);
+    }
+}
+
+// y = clamp(50 + amplitude * level(u), 0, 100) for a block of phases.
+void shapeBlock(const Kernel& kernel, float amplitude, const float* u, float* y, size_t count) {
+    size_t i = 0;
+#ifdef WAVEFORM_SSE2
+    const __m128 mid = _mm_set1_ps(50.0f), amp = _mm_set1_ps(amplitude);
+    const __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(100.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_add_ps(mid, _mm_mul_ps(amp, level4(kernel, _mm_loadu_ps(u + i))));
+        _mm_storeu_ps(y + i, _mm_max_ps(lo, _mm_min_ps(v, hi)));
+    }
+#endif
+    for (; i < count; ++i) {
+        float v = 50.0f + amplitude * level(kernel, u[i]);
+        y[i] = std::max(0.0f, std::min(v, 100.0f));
+    }
+}
+
+}  // namespace
+
+const char* waveShapeName(WaveShape shape) {
+    switch (shape) {
+    case WaveShape::Sine: return "Sine";
+    case WaveShape::Triangle: return "Triangle";
+    case WaveShape::Trapezoid: return "Trapezoid";
+    case WaveShape::SCurve: return "S-curve";
+    case WaveShape::Chirp: return "Chirp";
+    }
+    return "";
+}
+
+size_t waveSampleCount(const WaveSettings& settings, float startX) {
+    double duration = static_cast<double>(settings.timeScale) - startX;
+    if (!(settings.density > 0) || duration < 0) return 0;
+    // The tolerance keeps the last sample when the duration is a whole number of steps.
+    return static_cast<size_t>(std::floor(duration / settings.density + 1e-6)) + 1;
+}
+
+void sampleWave(const WaveSettings& settings, float startX, size_t first, size_t count, DataPoint* out) {
+    Kernel kernel{settings.shape, 1.0f / (2 * std::clamp(settings.rampFraction, 0.01f, 0.5f))};
+
+    // Phase in cycles: f0 t, plus (f1 - f0) t^2 / 2T for the chirp. It is computed in double
+    // and reduced to [0, 1) before the float kernels see it.
+    double f0 = settings.frequency;
+    double sweep = 0;
+    if (settings.shape == WaveShape::Chirp) {
+        double duration = (waveSampleCount(settings, startX) - 1) * static_cast<double>(settings.density);
+        if (duration > 0) sweep = (settings.endFrequency - f0) / (2 * duration);
+    }
+
+    float time[BLOCK], phase[BLOCK], value[BLOCK];
+    for (size_t done = 0; done < count; done += BLOCK) {
+        size_t n = std::min(BLOCK, count - done);
+        phaseBlock(static_cast<double>(first + done), settings.density, f0, sweep, time, phase, n);
+        shapeBlock(kernel, settings.amplitude, phase, value, n);
+        for (size_t k = 0; k < n; ++k) out[done + k] = {startX + time[k], value[k]};
+    }
+}
+
+namespace {
+
+float waveStartTime(CurveView points, const WaveSettings& settings) {
+    return settings.append && !points.empty() ? points.back().x : 0.0f;
+}
+
+}  // namespace
+
+size_t waveSpliceStart(CurveView points, const WaveSettings& settings) {
+    return points.lowerBound(waveStartTime(points, settings));
+}
+
+std::vector<DataPoint> spliceWave(CurveView points, const WaveSettings& settings) {
+    float startX = waveStartTime(points, settings);
+    size_t keep = points.lowerBound(startX);
+    size_t samples = waveSampleCount(settings, startX);
+
+    std::vector<DataPoint> result(keep + samples);
+    for (size_t i = 0; i < keep; ++i) result[i] = points[i];
+    sampleWave(settings, startX, 0, samples, result.data() + keep);
+    return result;
+}
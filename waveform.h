@@ -0,0 +1,41 @@
+#pragma once
+
+#include "curve.h"
+
+#include <cstddef>
+#include <vector>
+
+enum class WaveShape { Sine, Triangle, Trapezoid, SCurve, Chirp };
+
+const char* waveShapeName(WaveShape shape);
+
+struct WaveSettings {
+    WaveShape shape = WaveShape::Sine;
+    float timeScale = 1.0f;
+    float amplitude = 50.0f;
+    float frequency = 1.0f;
+    float density = 0.02f;    // seconds between samples
+    bool append = false;
+    float rampFraction = 0.25f;  // trapezoid and S-curve: share of each period spent on each ramp
+    float endFrequency = 5.0f;   // chirp: the frequency sweeps linearly to this by the end
+};
+
+// All shapes swing between 50 - amplitude and 50 + amplitude and cross 50 upwards at the
+// start of each period, like the sine. The S-curve ramps with constant jerk.
+
+// Number of samples a wave starting at `startX` gets: one every `density` seconds up to and
+// including the time scale.
+size_t waveSampleCount(const WaveSettings& settings, float startX);
+
+// Writes samples [first, first + count) of the wave starting at `startX`. Sample i lies at
+// startX + i * density, computed from the index so long waves do not drift. Values are clamped
+// to 0..100.
+void sampleWave(const WaveSettings& settings, float startX, size_t first, size_t count, DataPoint* out);
+
+// Returns `points` with everything from the wave start onwards replaced by the sampled wave.
+// The wave starts at 0, or at the last point when appending. The kept prefix and the wave are
+// written once into a buffer of the final size; nothing is sorted.
+std::vector<DataPoint> spliceWave(CurveView points, const WaveSettings& settings);
+
+// How many points at the front of `points` spliceWave keeps.
+size_t waveSpliceStart(CurveView points, const WaveSettings& settings);